@@ -0,0 +1,31 @@
+QT += core xml network
+QT -= gui
+
+CONFIG += c++11
+
+TARGET = a3trans
+CONFIG += console
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../src
+DEPENDPATH += $$PWD/../src
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../lib/release/ -la3trans
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../lib/debug/ -la3trans
+else:unix: LIBS += -L$$OUT_PWD/../lib/ -la3trans
+
+a3trans_shared {
+    unix: QMAKE_RPATHDIR += $$OUT_PWD/../lib
+} else {
+    DEFINES += A3TRANS_STATIC
+
+    win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../lib/release/liba3trans.a
+    else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../lib/debug/liba3trans.a
+    else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../lib/release/a3trans.lib
+    else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../lib/debug/a3trans.lib
+    else:unix: PRE_TARGETDEPS += $$OUT_PWD/../lib/liba3trans.a
+}
+
+SOURCES += ../src/main.cpp
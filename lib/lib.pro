@@ -0,0 +1,82 @@
+QT += core xml network
+QT -= gui
+
+CONFIG += c++11
+
+TARGET = a3trans
+TEMPLATE = lib
+
+# builds a static library by default, run qmake with CONFIG+=a3trans_shared to build a shared library
+a3trans_shared {
+    DEFINES += A3TRANS_LIBRARY
+} else {
+    CONFIG += staticlib
+    DEFINES += A3TRANS_STATIC
+}
+
+SOURCES += \
+    ../src/scriptparser.cpp \
+    ../src/project.cpp \
+    ../src/package.cpp \
+    ../src/container.cpp \
+    ../src/key.cpp \
+    ../src/translation.cpp \
+    ../src/stringtableparser.cpp \
+    ../src/filewriter.cpp \
+    ../src/xliffparser.cpp \
+    ../src/stringtablemerger.cpp \
+    ../src/languages.cpp \
+    ../src/job.cpp \
+    ../src/filediscovery.cpp \
+    ../src/filematcher.cpp \
+    ../src/includecache.cpp \
+    ../src/configscanner.cpp \
+    ../src/keyindex.cpp \
+    ../src/referenceset.cpp \
+    ../src/report.cpp \
+    ../src/xliffstreamconverter.cpp \
+    ../src/stringtablewriter.cpp \
+    ../src/xliffstreammerger.cpp \
+    ../src/workspace.cpp \
+    ../src/a3trans_c.cpp \
+    ../src/server.cpp \
+    ../src/translationmemory.cpp \
+    ../src/duplicatefinder.cpp \
+    ../src/validator.cpp \
+    ../src/artifact.cpp \
+    ../src/artifactcache.cpp
+
+HEADERS += \
+    ../src/scriptparser.h \
+    ../src/project.h \
+    ../src/package.h \
+    ../src/container.h \
+    ../src/key.h \
+    ../src/translation.h \
+    ../src/stringtableparser.h \
+    ../src/filewriter.h \
+    ../src/xliffparser.h \
+    ../src/stringtablemerger.h \
+    ../src/languages.h \
+    ../src/job.h \
+    ../src/filediscovery.h \
+    ../src/filematcher.h \
+    ../src/includecache.h \
+    ../src/scriptresult.h \
+    ../src/configscanner.h \
+    ../src/keyindex.h \
+    ../src/referenceset.h \
+    ../src/report.h \
+    ../src/xliffstreamconverter.h \
+    ../src/stringtablewriter.h \
+    ../src/xliffstreammerger.h \
+    ../src/a3trans_global.h \
+    ../src/workspace.h \
+    ../src/a3trans_c.h \
+    ../src/server.h \
+    ../src/translationmemory.h \
+    ../src/duplicatefinder.h \
+    ../src/validator.h \
+    ../src/artifact.h \
+    ../src/artifactcache.h \
+    ../src/passthrough.h
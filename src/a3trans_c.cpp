@@ -0,0 +1,248 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "a3trans_c.h"
+#include "workspace.h"
+#include "report.h"
+#include "a3trans_global.h"
+
+
+
+/*!
+ * \internal
+ * \brief Handle of a Workspace object used by the C interface.
+ *
+ * Keeps the UTF-8 encoded result of the last lookup alive until the next call.
+ */
+struct a3trans_workspace
+{
+    explicit a3trans_workspace(const QString &workingDir) : workspace(workingDir) {}
+
+    Workspace workspace;
+    QByteArray buffer;
+};
+
+
+
+/*!
+ * \brief Returns the version of the library.
+ * \since 1.1.0
+ */
+const char *a3trans_version(void)
+{
+    return A3TRANS_VERSION;
+}
+
+
+
+/*!
+ * \brief Creates a new workspace for the \a working_dir. Free it with a3trans_workspace_free().
+ * \since 1.1.0
+ */
+a3trans_workspace *a3trans_workspace_new(const char *working_dir)
+{
+    if (!working_dir) {
+        return nullptr;
+    }
+
+    return new a3trans_workspace(QString::fromUtf8(working_dir));
+}
+
+
+
+/*!
+ * \brief Frees the workspace \a ws and the loaded project.
+ * \since 1.1.0
+ */
+void a3trans_workspace_free(a3trans_workspace *ws)
+{
+    delete ws;
+}
+
+
+
+/*!
+ * \brief Sets the option \a name to \a value.
+ *
+ * Supported options are the command line options sourceLang, xliff2, sourceLangOnly, backup,
+ * sort, since, ancestor, include and exclude. Flags are enabled by a value of \c 1. The include
+ * and exclude options add a pattern, a null \a value clears the patterns.
+ *
+ * \since 1.1.0
+ * \return 0 on success, -1 if the option is unknown.
+ */
+int a3trans_set_option(a3trans_workspace *ws, const char *name, const char *value)
+{
+    if (!ws || !name) {
+        return -1;
+    }
+
+    JobOptions o = ws->workspace.options();
+    const QLatin1String n(name);
+    const QString v = QString::fromUtf8(value);
+    const bool flag = v == QLatin1String("1");
+
+    if (n == QLatin1String("sourceLang")) {
+        o.srcLang = v.isEmpty() ? QStringLiteral("en") : v;
+    } else if (n == QLatin1String("xliff2")) {
+        o.xliffVersion2 = flag;
+    } else if (n == QLatin1String("sourceLangOnly")) {
+        o.sourceLangOnly = flag;
+    } else if (n == QLatin1String("backup")) {
+        o.backup = flag;
+    } else if (n == QLatin1String("sort")) {
+        o.sorted = flag;
+    } else if (n == QLatin1String("since")) {
+        o.sincePath = v;
+    } else if (n == QLatin1String("ancestor")) {
+        o.ancestorPath = v;
+    } else if (n == QLatin1String("include")) {
+        if (value) {
+            o.includes.append(v);
+        } else {
+            o.includes.clear();
+        }
+    } else if (n == QLatin1String("exclude")) {
+        if (value) {
+            o.excludes.append(v);
+        } else {
+            o.excludes.clear();
+        }
+    } else {
+        return -1;
+    }
+
+    ws->workspace.setOptions(o);
+
+    return 0;
+}
+
+
+
+/*!
+ * \brief Extracts the translation strings and updates the stringtable.xml file.
+ * \since 1.1.0
+ */
+int a3trans_extract(a3trans_workspace *ws)
+{
+    return ws && ws->workspace.extract() ? 0 : 1;
+}
+
+
+
+/*!
+ * \brief Converts the stringtable.xml file into XLIFF files.
+ * \since 1.1.0
+ */
+int a3trans_export_xliff(a3trans_workspace *ws)
+{
+    return ws && ws->workspace.exportXliff() ? 0 : 1;
+}
+
+
+
+/*!
+ * \brief Converts the XLIFF files into the stringtable.xml file.
+ * \since 1.1.0
+ */
+int a3trans_import_xliff(a3trans_workspace *ws)
+{
+    return ws && ws->workspace.importXliff() ? 0 : 1;
+}
+
+
+
+/*!
+ * \brief Returns the number of files parsed by the last extraction.
+ * \since 1.1.0
+ */
+int a3trans_files_parsed(const a3trans_workspace *ws)
+{
+    return ws ? ws->workspace.filesParsed() : 0;
+}
+
+
+
+/*!
+ * \brief Returns the translation of the key with \a id into \a lang or a null pointer if it does not exist.
+ *
+ * The returned string is valid until the next call to this function with the same workspace.
+ *
+ * \since 1.1.0
+ */
+const char *a3trans_translation(a3trans_workspace *ws, const char *id, const char *lang)
+{
+    if (!ws || !id || !lang) {
+        return nullptr;
+    }
+
+    const QString t = ws->workspace.translation(QString::fromUtf8(id), QString::fromUtf8(lang));
+
+    if (t.isNull()) {
+        return nullptr;
+    }
+
+    ws->buffer = t.toUtf8();
+
+    return ws->buffer.constData();
+}
+
+
+
+/*!
+ * \brief Returns the number of findings collected since the report has been cleared.
+ * \since 1.1.0
+ */
+int a3trans_diagnostics_count(const a3trans_workspace *ws)
+{
+    return ws ? ws->workspace.report()->size() : 0;
+}
+
+
+
+/*!
+ * \brief Writes the findings to \a file_path or to stderr if it is a null pointer.
+ *
+ * \a format is one of text, json or sarif, a null pointer selects text.
+ *
+ * \since 1.1.0
+ */
+int a3trans_write_report(a3trans_workspace *ws, const char *file_path, const char *format)
+{
+    if (!ws) {
+        return 1;
+    }
+
+    Report *r = ws->workspace.report();
+    r->setFormat(Report::formatFromString(QString::fromUtf8(format)));
+
+    return r->write(QString::fromUtf8(file_path)) ? 0 : 1;
+}
+
+
+
+/*!
+ * \brief Removes all findings from the report of the workspace.
+ * \since 1.1.0
+ */
+void a3trans_clear_report(a3trans_workspace *ws)
+{
+    if (ws) {
+        ws->workspace.report()->clear();
+    }
+}
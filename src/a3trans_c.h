@@ -0,0 +1,74 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef A3TRANS_C_H
+#define A3TRANS_C_H
+
+/*
+ * C interface of the a3trans library for hosts that are not written in C++.
+ *
+ * All strings are UTF-8 encoded. Functions returning int return 0 on success.
+ */
+
+#if defined(A3TRANS_STATIC)
+#  define A3TRANS_C_API
+#elif defined(_WIN32)
+#  if defined(A3TRANS_LIBRARY)
+#    define A3TRANS_C_API __declspec(dllexport)
+#  else
+#    define A3TRANS_C_API __declspec(dllimport)
+#  endif
+#else
+#  define A3TRANS_C_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct a3trans_workspace a3trans_workspace;
+
+A3TRANS_C_API const char *a3trans_version(void);
+
+A3TRANS_C_API a3trans_workspace *a3trans_workspace_new(const char *working_dir);
+
+A3TRANS_C_API void a3trans_workspace_free(a3trans_workspace *ws);
+
+A3TRANS_C_API int a3trans_set_option(a3trans_workspace *ws, const char *name, const char *value);
+
+A3TRANS_C_API int a3trans_extract(a3trans_workspace *ws);
+
+A3TRANS_C_API int a3trans_export_xliff(a3trans_workspace *ws);
+
+A3TRANS_C_API int a3trans_import_xliff(a3trans_workspace *ws);
+
+A3TRANS_C_API int a3trans_files_parsed(const a3trans_workspace *ws);
+
+A3TRANS_C_API const char *a3trans_translation(a3trans_workspace *ws, const char *id, const char *lang);
+
+A3TRANS_C_API int a3trans_diagnostics_count(const a3trans_workspace *ws);
+
+A3TRANS_C_API int a3trans_write_report(a3trans_workspace *ws, const char *file_path, const char *format);
+
+A3TRANS_C_API void a3trans_clear_report(a3trans_workspace *ws);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // A3TRANS_C_H
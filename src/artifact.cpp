@@ -0,0 +1,287 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "artifact.h"
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+
+
+/*!
+ * \class Artifact
+ * \brief Reads and writes the data extracted from script and config files as intermediate build artifact.
+ *
+ * Artifacts allow to split the extraction: the files of a working directory can be extracted on
+ * different machines with \c extract-file and the artifacts are linked with the stringtable.xml file
+ * afterwards with \c link. Unchanged artifacts can be reused from a build cache.
+ *
+ * An artifact is a UTF-8 encoded JSON Lines file. The first line is a header identifying the format
+ * and its version, every following line contains the ScriptResult of a single file:
+ *
+ * \code{.json}
+ * {"a3trans":"artifact","version":1}
+ * {"file":"addons/main/fn_init.sqf","entries":[["Main","fn_init","STR_Hello","Hello"]],"references":[["STR_Hello",12,8,""]],"includes":["addons/main/macros.hpp"]}
+ * \endcode
+ *
+ * Entries contain package, container, ID and text, references contain ID, line, column and context.
+ * All paths are relative to the working directory, so that artifacts created in different checkouts
+ * can be linked together. Artifacts are read line by line, so that any number of them can be linked
+ * without loading them into memory.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new Artifact object for the working directory at \a rootDir.
+ * \since 1.1.0
+ */
+Artifact::Artifact(const QString &rootDir) : m_root(rootDir), m_line(0), m_error(false)
+{
+
+}
+
+
+
+/*!
+ * \brief Writes the \a results into a new artifact file at \a filePath.
+ *
+ * The file is only replaced if all results have been written successfully.
+ *
+ * \since 1.1.0
+ */
+bool Artifact::write(const QString &filePath, const QVector<const ScriptResult*> &results) const
+{
+    QSaveFile file(filePath);
+
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCritical("%s", qUtf8Printable(tr("Can not open artifact file for writing: %1").arg(filePath)));
+        return false;
+    }
+
+    QJsonObject header;
+    header.insert(QStringLiteral("a3trans"), QStringLiteral("artifact"));
+    header.insert(QStringLiteral("version"), 1);
+
+    file.write(QJsonDocument(header).toJson(QJsonDocument::Compact));
+    file.write("\n");
+
+    for (int i = 0; i < results.size(); ++i) {
+        file.write(encode(*results.at(i)));
+        file.write("\n");
+    }
+
+    if (!file.commit()) {
+        qCritical("%s", qUtf8Printable(tr("Failed to write artifact file: %1").arg(filePath)));
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/*!
+ * \brief Opens the artifact file at \a filePath for reading and checks its header.
+ * \since 1.1.0
+ */
+bool Artifact::open(const QString &filePath)
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+
+    m_file.setFileName(filePath);
+    m_line = 0;
+    m_error = false;
+
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qCritical("%s", qUtf8Printable(tr("Can not open artifact file: %1").arg(filePath)));
+        m_error = true;
+        return false;
+    }
+
+    m_line++;
+    const QJsonObject header = QJsonDocument::fromJson(m_file.readLine()).object();
+
+    if (header.value(QStringLiteral("a3trans")).toString() != QLatin1String("artifact") || header.value(QStringLiteral("version")).toInt() != 1) {
+        qCritical("%s", qUtf8Printable(tr("Not a supported artifact file: %1").arg(filePath)));
+        m_file.close();
+        m_error = true;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/*!
+ * \brief Reads the data of the next file from the opened artifact into \a result.
+ *
+ * Returns false at the end of the artifact or if a line can not be read. Use hasError() to
+ * distinguish both cases.
+ *
+ * \since 1.1.0
+ */
+bool Artifact::next(ScriptResult *result)
+{
+    if (!m_file.isOpen()) {
+        return false;
+    }
+
+    while (!m_file.atEnd()) {
+        const QByteArray line = m_file.readLine().trimmed();
+        m_line++;
+
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        if (!decode(line, result)) {
+            qCritical("%s", qUtf8Printable(tr("Invalid data in line %1 of artifact file: %2").arg(m_line).arg(m_file.fileName())));
+            m_file.close();
+            m_error = true;
+            return false;
+        }
+
+        return true;
+    }
+
+    m_file.close();
+
+    return false;
+}
+
+
+
+/*!
+ * \brief Returns true if the last opened artifact could not be read completely.
+ * \since 1.1.0
+ */
+bool Artifact::hasError() const
+{
+    return m_error;
+}
+
+
+
+/*!
+ * \brief Returns \a result encoded as a single artifact line without the trailing line break.
+ * \since 1.1.0
+ */
+QByteArray Artifact::encode(const ScriptResult &result) const
+{
+    QJsonArray entries;
+    for (int i = 0; i < result.entries.size(); ++i) {
+        const TranslationEntry &e = result.entries.at(i);
+        entries.append(QJsonArray({e.package, e.container, e.key, e.text}));
+    }
+
+    QJsonArray references;
+    for (int i = 0; i < result.references.size(); ++i) {
+        const Reference &r = result.references.at(i);
+        references.append(QJsonArray({r.key, r.line, r.column, r.context}));
+    }
+
+    QJsonArray includes;
+    for (int i = 0; i < result.includes.size(); ++i) {
+        includes.append(relativePath(result.includes.at(i)));
+    }
+
+    QJsonObject o;
+    o.insert(QStringLiteral("file"), relativePath(result.file));
+    o.insert(QStringLiteral("entries"), entries);
+    o.insert(QStringLiteral("references"), references);
+    o.insert(QStringLiteral("includes"), includes);
+
+    return QJsonDocument(o).toJson(QJsonDocument::Compact);
+}
+
+
+
+/*!
+ * \brief Decodes a single artifact \a line into \a result, resolving the paths against the working directory.
+ * \since 1.1.0
+ */
+bool Artifact::decode(const QByteArray &line, ScriptResult *result) const
+{
+    QJsonParseError pe;
+    const QJsonDocument doc = QJsonDocument::fromJson(line, &pe);
+
+    if (pe.error != QJsonParseError::NoError || !doc.isObject()) {
+        return false;
+    }
+
+    const QJsonObject o = doc.object();
+    const QString file = o.value(QStringLiteral("file")).toString();
+
+    if (file.isEmpty()) {
+        return false;
+    }
+
+    result->file = QDir::cleanPath(m_root.absoluteFilePath(file));
+    result->entries.clear();
+    result->references.clear();
+    result->includes.clear();
+
+    const QJsonArray entries = o.value(QStringLiteral("entries")).toArray();
+    result->entries.reserve(entries.size());
+    for (int i = 0; i < entries.size(); ++i) {
+        const QJsonArray e = entries.at(i).toArray();
+        if (e.size() != 4) {
+            return false;
+        }
+        result->entries.append({e.at(0).toString(), e.at(1).toString(), e.at(2).toString(), e.at(3).toString()});
+    }
+
+    const QJsonArray references = o.value(QStringLiteral("references")).toArray();
+    result->references.reserve(references.size());
+    for (int i = 0; i < references.size(); ++i) {
+        const QJsonArray r = references.at(i).toArray();
+        if (r.size() != 4) {
+            return false;
+        }
+        result->references.append({r.at(0).toString(), result->file, r.at(1).toInt(), r.at(2).toInt(), r.at(3).toString()});
+    }
+
+    const QJsonArray includes = o.value(QStringLiteral("includes")).toArray();
+    for (int i = 0; i < includes.size(); ++i) {
+        result->includes.append(QDir::cleanPath(m_root.absoluteFilePath(includes.at(i).toString())));
+    }
+
+    return true;
+}
+
+
+
+/*!
+ * \brief Returns \a filePath relative to the working directory, using slashes as separator.
+ * \since 1.1.0
+ */
+QString Artifact::relativePath(const QString &filePath) const
+{
+    return QDir::fromNativeSeparators(m_root.relativeFilePath(filePath));
+}
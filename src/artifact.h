@@ -0,0 +1,58 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ARTIFACT_H
+#define ARTIFACT_H
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QVector>
+#include "scriptresult.h"
+#include "a3trans_global.h"
+
+class A3TRANS_EXPORT Artifact
+{
+    Q_DECLARE_TR_FUNCTIONS(Artifact)
+public:
+    explicit Artifact(const QString &rootDir);
+
+    bool write(const QString &filePath, const QVector<const ScriptResult*> &results) const;
+
+    bool open(const QString &filePath);
+
+    bool next(ScriptResult *result);
+
+    bool hasError() const;
+
+    QByteArray encode(const ScriptResult &result) const;
+
+    bool decode(const QByteArray &line, ScriptResult *result) const;
+
+private:
+    Q_DISABLE_COPY(Artifact)
+
+    QDir m_root;
+    QFile m_file;
+    int m_line;
+    bool m_error;
+
+    QString relativePath(const QString &filePath) const;
+};
+
+#endif // ARTIFACT_H
@@ -0,0 +1,310 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "artifactcache.h"
+#include <QCryptographicHash>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <algorithm>
+
+
+
+/*!
+ * \class ArtifactCache
+ * \brief Stores the data extracted from single files in a content addressed cache directory.
+ *
+ * Every entry is addressed by the SHA-256 hash of the a3trans version, the kind of scanner, the
+ * path of the file relative to the working directory and the content of the file. The entry is a
+ * single Artifact line, so entries are independent of the location of the working directory and
+ * the cache directory can be shared between machines, for example via a mounted volume or the
+ * cache of a CI service. Entries are written atomically, so that several processes can use the
+ * same directory at the same time.
+ *
+ * Included files are resolved when a file is parsed. A fetched entry is only used if all files it
+ * includes do still exist.
+ *
+ * Every use of an entry updates its modification time. If the size of all entries exceeds the
+ * maximum size, prune() removes the least recently used entries. A maximum size of 0 disables
+ * pruning.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new ArtifactCache object with a maximum size of 512 MiB.
+ * \since 1.1.0
+ * \param cacheDir  The directory that contains the cache entries. It will be created if it does not exist.
+ * \param rootDir   The working directory the extracted files belong to.
+ */
+ArtifactCache::ArtifactCache(const QString &cacheDir, const QString &rootDir) :
+    m_dir(cacheDir), m_root(rootDir), m_artifact(rootDir), m_maxSize(Q_INT64_C(512) * 1024 * 1024), m_hits(0), m_misses(0)
+{
+    if (!m_dir.exists() && !m_dir.mkpath(QStringLiteral("."))) {
+        qWarning("%s", qUtf8Printable(tr("Can not create cache directory: %1").arg(cacheDir)));
+    }
+}
+
+
+
+/*!
+ * \brief Sets the maximum size of all cache entries in \a bytes, 0 for no limit.
+ * \since 1.1.0
+ */
+void ArtifactCache::setMaxSize(qint64 bytes)
+{
+    m_maxSize = qMax(Q_INT64_C(0), bytes);
+}
+
+
+
+/*!
+ * \brief Returns the maximum size of all cache entries in bytes.
+ * \since 1.1.0
+ */
+qint64 ArtifactCache::maxSize() const
+{
+    return m_maxSize;
+}
+
+
+
+/*!
+ * \brief Reads the cached data of the file at \a filePath into \a result.
+ *
+ * Returns false if there is no valid entry for the current content of the file.
+ *
+ * \since 1.1.0
+ * \param filePath  Absolute path to the script or config file.
+ * \param kind      The scanner the file would be parsed with.
+ * \param result    Pointer to the object that receives the data.
+ */
+bool ArtifactCache::fetch(const QString &filePath, FileMatcher::Kind kind, ScriptResult *result)
+{
+    const QByteArray k = key(filePath, kind);
+
+    if (k.isEmpty()) {
+        m_misses++;
+        return false;
+    }
+
+    // the key is reused by store() if the file has to be parsed
+    m_keys.insert(filePath, k);
+
+    QFile f(entryPath(k));
+
+    if (!f.open(QIODevice::ReadOnly)) {
+        m_misses++;
+        return false;
+    }
+
+    const QByteArray data = f.readAll();
+
+    if (!m_artifact.decode(data.trimmed(), result)) {
+        m_misses++;
+        return false;
+    }
+
+    for (int i = 0; i < result->includes.size(); ++i) {
+        if (!QFileInfo(result->includes.at(i)).isFile()) {
+            m_misses++;
+            return false;
+        }
+    }
+
+    f.close();
+
+    // mark the entry as recently used, a read only cache is used without eviction
+    if (f.open(QIODevice::ReadWrite)) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+        f.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+#else
+        f.write(data);
+#endif
+    }
+
+    m_keys.remove(filePath);
+    m_hits++;
+
+    return true;
+}
+
+
+
+/*!
+ * \brief Writes the data of \a result, that has been parsed with the \a kind of scanner, into the cache.
+ * \since 1.1.0
+ */
+void ArtifactCache::store(const ScriptResult &result, FileMatcher::Kind kind)
+{
+    QByteArray k = m_keys.take(result.file);
+
+    if (k.isEmpty()) {
+        k = key(result.file, kind);
+        if (k.isEmpty()) {
+            return;
+        }
+    }
+
+    const QString path = entryPath(k);
+
+    if (!m_dir.mkpath(QFileInfo(path).path())) {
+        return;
+    }
+
+    QSaveFile f(path);
+
+    if (!f.open(QIODevice::WriteOnly)) {
+        qWarning("%s", qUtf8Printable(tr("Can not write cache entry: %1").arg(path)));
+        return;
+    }
+
+    f.write(m_artifact.encode(result));
+    f.write("\n");
+
+    if (!f.commit()) {
+        qWarning("%s", qUtf8Printable(tr("Can not write cache entry: %1").arg(path)));
+    }
+}
+
+
+
+/*!
+ * \brief Removes the least recently used entries until the cache does not exceed the maximum size.
+ *
+ * Nothing is removed if the maximum size is 0.
+ *
+ * \since 1.1.0
+ * \return The number of removed entries.
+ */
+int ArtifactCache::prune()
+{
+    if (m_maxSize == 0) {
+        return 0;
+    }
+
+    struct Entry {
+        QString path;
+        QDateTime used;
+        qint64 size;
+    };
+
+    QVector<Entry> entries;
+    qint64 total = 0;
+
+    QDirIterator it(m_dir.absolutePath(), QStringList(QStringLiteral("*.a3a")), QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo fi = it.fileInfo();
+        entries.append({fi.absoluteFilePath(), fi.lastModified(), fi.size()});
+        total += fi.size();
+    }
+
+    if (total <= m_maxSize) {
+        return 0;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.used < b.used;
+    });
+
+    int removed = 0;
+
+    for (int i = 0; i < entries.size() && total > m_maxSize; ++i) {
+        // entries might have been removed by another process sharing the directory
+        QFile::remove(entries.at(i).path);
+        total -= entries.at(i).size;
+        removed++;
+    }
+
+    return removed;
+}
+
+
+
+/*!
+ * \brief Returns the number of files whose data has been fetched from the cache.
+ * \since 1.1.0
+ */
+int ArtifactCache::hits() const
+{
+    return m_hits;
+}
+
+
+
+/*!
+ * \brief Returns the number of files that have not been found in the cache.
+ * \since 1.1.0
+ */
+int ArtifactCache::misses() const
+{
+    return m_misses;
+}
+
+
+
+/*!
+ * \brief Returns the hexadecimal key of the entry for the current content of the file at \a filePath.
+ *
+ * Returns an empty key if the file can not be read.
+ *
+ * \since 1.1.0
+ */
+QByteArray ArtifactCache::key(const QString &filePath, FileMatcher::Kind kind) const
+{
+    QFile f(filePath);
+
+    if (!f.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(QByteArrayLiteral(A3TRANS_VERSION));
+    hash.addData("\0", 1);
+    hash.addData(QByteArray::number(static_cast<int>(kind)));
+    hash.addData("\0", 1);
+    hash.addData(QDir::fromNativeSeparators(m_root.relativeFilePath(filePath)).toUtf8());
+    hash.addData("\0", 1);
+
+    if (!hash.addData(&f)) {
+        return QByteArray();
+    }
+
+    return hash.result().toHex();
+}
+
+
+
+/*!
+ * \brief Returns the path of the entry with \a key, spread over subdirectories by the first two characters.
+ * \since 1.1.0
+ */
+QString ArtifactCache::entryPath(const QByteArray &key) const
+{
+    const QString k = QString::fromLatin1(key);
+
+    return m_dir.absoluteFilePath(k.left(2) + QLatin1Char('/') + k + QLatin1String(".a3a"));
+}
@@ -0,0 +1,64 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ARTIFACTCACHE_H
+#define ARTIFACTCACHE_H
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QHash>
+#include "artifact.h"
+#include "filematcher.h"
+#include "a3trans_global.h"
+
+class A3TRANS_EXPORT ArtifactCache
+{
+    Q_DECLARE_TR_FUNCTIONS(ArtifactCache)
+public:
+    ArtifactCache(const QString &cacheDir, const QString &rootDir);
+
+    void setMaxSize(qint64 bytes);
+
+    qint64 maxSize() const;
+
+    bool fetch(const QString &filePath, FileMatcher::Kind kind, ScriptResult *result);
+
+    void store(const ScriptResult &result, FileMatcher::Kind kind);
+
+    int prune();
+
+    int hits() const;
+
+    int misses() const;
+
+private:
+    Q_DISABLE_COPY(ArtifactCache)
+
+    QDir m_dir;
+    QDir m_root;
+    Artifact m_artifact;
+    QHash<QString, QByteArray> m_keys;
+    qint64 m_maxSize;
+    int m_hits;
+    int m_misses;
+
+    QByteArray key(const QString &filePath, FileMatcher::Kind kind) const;
+    QString entryPath(const QByteArray &key) const;
+};
+
+#endif // ARTIFACTCACHE_H
@@ -0,0 +1,342 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "configscanner.h"
+#include "scriptparser.h"
+#include "includecache.h"
+#include <QVector>
+#include <QPair>
+#include <QFileInfo>
+
+
+
+/*!
+ * \internal
+ * \brief Returns true if \a c can be part of an identifier or key id.
+ */
+static inline bool isIdentChar(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+
+/*!
+ * \internal
+ * \brief Returns the length of the key id starting at \a p, or 0 if there is no STR_ key id at \a p.
+ *
+ * A key id needs at least one identifier character after the \c STR_ prefix.
+ */
+static inline int keyLength(const char *p, const char *end)
+{
+    if (end - p < 5 || qstrnicmp(p, "STR_", 4) != 0 || !isIdentChar(p[4])) {
+        return 0;
+    }
+
+    const char *k = p + 4;
+    while (k < end && isIdentChar(*k)) {
+        k++;
+    }
+
+    return int(k - p);
+}
+
+
+/*!
+ * \internal
+ * \brief Returns true if the comment text starting at \a p begins with a TR marker.
+ */
+static inline bool isTrComment(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+
+    return end - p > 2 && p[0] == 'T' && p[1] == 'R' && (p[2] == ' ' || p[2] == '\t');
+}
+
+
+
+/*!
+ * \class ConfigScanner
+ * \brief Extracts localization key references from config class files.
+ *
+ * The scanner is specialized on the config file format used by \c mission.sqm, \c description.ext,
+ * \c config.cpp and their headers. Instead of matching regular expressions line by line, it walks
+ * over the raw file data once, skips comments, jumps from one quoted string to the next and keeps
+ * track of the class nesting. Key ids used as \c $STR_... values and key ids anywhere inside of
+ * strings, like in \c "$STR_..." or \c "hint localize 'STR_...'", are extracted together with the
+ * path of the class they are used in.
+ *
+ * TR comments are extracted during the same pass, see ScriptParser::extractComment().
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new ConfigScanner object.
+ * \since 1.1.0
+ * \param configFile    Full path to the file to scan.
+ * \param parent        Pointer to the parent object.
+ */
+ConfigScanner::ConfigScanner(const QString &configFile, QObject *parent) : QObject(parent)
+{
+    m_file.setFileName(configFile);
+}
+
+
+
+/*!
+ * \brief Extracts the localization key references and include directives from the file.
+ *
+ * If \a cache is not a null pointer, include directives are resolved and the included files are parsed through the cache.
+ *
+ * \since 1.1.0
+ * \param cache     Pointer to the cache used to parse included files.
+ * \return          The extracted data.
+ */
+ScriptResult ConfigScanner::extract(IncludeCache *cache)
+{
+    ScriptResult result;
+    result.file = m_file.fileName();
+
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qCritical("%s", qUtf8Printable(tr("Can not open config file.")));
+        return result;
+    }
+
+    const QByteArray data = m_file.readAll();
+    m_file.close();
+
+    const char *begin = data.constData();
+    const char *end = begin + data.size();
+    const char *p = begin;
+    const char *lineStart = begin;
+    int line = 1;
+    bool atLineStart = true;
+    const QString fileBaseName = QFileInfo(result.file).baseName();
+
+    // class names are referenced in the file data, not copied
+    QVector<QPair<const char*, int> > classes;
+    classes.reserve(16);
+    const char *pendingClass = nullptr;
+    int pendingClassLength = 0;
+
+    auto addReference = [&](const char *key, int length) {
+        QString context;
+        for (int i = 0; i < classes.size(); ++i) {
+            if (classes.at(i).second > 0) {
+                if (!context.isEmpty()) {
+                    context.append(QLatin1Char('/'));
+                }
+                context.append(QLatin1String(classes.at(i).first, classes.at(i).second));
+            }
+        }
+        result.references.append({QString::fromLatin1(key, length), result.file, line, int(key - lineStart) + 1, context});
+    };
+
+    auto addComment = [&](const char *comment, const char *commentEnd) {
+        TranslationEntry e;
+        if (ScriptParser::extractComment(QString::fromUtf8(comment, int(commentEnd - comment)), fileBaseName, &e)) {
+            result.entries.append(e);
+        }
+    };
+
+    while (p < end) {
+        const char c = *p;
+
+        if (c == '\n') {
+            line++;
+            p++;
+            lineStart = p;
+            atLineStart = true;
+            continue;
+        }
+
+        if (c == '/' && p + 1 < end && p[1] == '/') {
+
+            const char *s = p;
+            while (p < end && *p != '\n') {
+                p++;
+            }
+            if (isTrComment(s + 2, p)) {
+                addComment(s, p);
+            }
+            continue;
+
+        } else if (c == '/' && p + 1 < end && p[1] == '*') {
+
+            const char *s = p;
+            p += 2;
+            while (p < end && !(*p == '*' && p + 1 < end && p[1] == '/')) {
+                if (*p == '\n') {
+                    line++;
+                    lineStart = p + 1;
+                }
+                p++;
+            }
+            // unterminated comments end with the file
+            if (p < end) {
+                p += 2;
+            }
+            if (isTrComment(s + 2, p)) {
+                addComment(s, p);
+            }
+            continue;
+
+        } else if (c == '"') {
+
+            p++;
+
+            // quotes inside strings are escaped by doubling them
+            while (p < end && !(*p == '"' && !(p + 1 < end && p[1] == '"'))) {
+                if (*p == '"') {
+                    p += 2;
+                    continue;
+                }
+                if (*p == '\n') {
+                    line++;
+                    lineStart = p + 1;
+                } else if (!isIdentChar(p[-1])) {
+                    const int length = keyLength(p, end);
+                    if (length > 0) {
+                        addReference(p, length);
+                        p += length;
+                        continue;
+                    }
+                }
+                p++;
+            }
+
+            // unterminated strings end with the file
+            if (p < end) {
+                p++;
+            }
+            atLineStart = false;
+            continue;
+
+        } else if (c == '$') {
+
+            const int length = keyLength(p + 1, end);
+            if (length > 0) {
+                addReference(p + 1, length);
+                p += length + 1;
+                atLineStart = false;
+                continue;
+            }
+
+        } else if (c == '#' && atLineStart) {
+
+            const char *s = p;
+            while (p < end && *p != '\n') {
+                // key ids can be used in macro definitions
+                if (p > s && !isIdentChar(p[-1])) {
+                    const int length = keyLength(p, end);
+                    if (length > 0) {
+                        addReference(p, length);
+                        p += length;
+                        continue;
+                    }
+                }
+                p++;
+            }
+
+            if (cache) {
+                const QString directive = QString::fromUtf8(s, int(p - s)).simplified();
+                if (directive.startsWith(QLatin1String("#include"))) {
+                    QString path = directive.mid(8).trimmed();
+                    if (path.size() > 2) {
+                        path = path.mid(1, path.size() - 2);
+                        const QString included = cache->resolve(result.file, path);
+                        if (!included.isEmpty() && !result.includes.contains(included)) {
+                            result.includes.append(included);
+                        }
+                    }
+                }
+            }
+            continue;
+
+        } else if (c == '{') {
+
+            classes.append(qMakePair(pendingClass, pendingClassLength));
+            pendingClass = nullptr;
+            pendingClassLength = 0;
+
+        } else if (c == '}') {
+
+            if (!classes.isEmpty()) {
+                classes.removeLast();
+            }
+
+        } else if (c == ';') {
+
+            pendingClass = nullptr;
+            pendingClassLength = 0;
+
+        } else if (isIdentChar(c) && (p == begin || !isIdentChar(p[-1]))) {
+
+            const char *s = p;
+            while (p < end && isIdentChar(*p)) {
+                p++;
+            }
+
+            // key ids used as macro arguments
+            if (keyLength(s, p) == int(p - s)) {
+                addReference(s, int(p - s));
+            }
+
+            if (p - s == 5 && qstrncmp(s, "class", 5) == 0) {
+                while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+                    if (*p == '\n') {
+                        line++;
+                        lineStart = p + 1;
+                    }
+                    p++;
+                }
+                pendingClass = p;
+                while (p < end && isIdentChar(*p)) {
+                    p++;
+                }
+                pendingClassLength = int(p - pendingClass);
+            }
+
+            atLineStart = false;
+            continue;
+        }
+
+        if (c != ' ' && c != '\t' && c != '\r') {
+            atLineStart = false;
+        }
+
+        p++;
+    }
+
+    // parse the included files through the cache, so that every file is parsed only once
+    if (cache) {
+        for (int i = 0; i < result.includes.size(); ++i) {
+            cache->result(result.includes.at(i));
+        }
+    }
+
+    return result;
+}
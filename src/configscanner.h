@@ -0,0 +1,43 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CONFIGSCANNER_H
+#define CONFIGSCANNER_H
+
+#include <QObject>
+#include <QFile>
+#include "scriptresult.h"
+#include "a3trans_global.h"
+
+class IncludeCache;
+
+class A3TRANS_EXPORT ConfigScanner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ConfigScanner(const QString &configFile, QObject *parent = nullptr);
+
+    ScriptResult extract(IncludeCache *cache = nullptr);
+
+private:
+    Q_DISABLE_COPY(ConfigScanner)
+
+    QFile m_file;
+};
+
+#endif // CONFIGSCANNER_H
@@ -19,7 +19,6 @@
 #include "container.h"
 #include "translation.h"
 #include "key.h"
-#include <QRegularExpression>
 #ifdef QT_DEBUG
 #include <QDebug>
 #endif
@@ -31,6 +30,10 @@
  *
  * The container class is an object representation of the stringtable XML container node.
  *
+ * Keys are looked up case insensitive through a hash index that is built on first use and that is
+ * updated when keys are created via key(). Keys have to be created through key() or the
+ * setTranslation() functions to be found by the lookups.
+ *
  * \since 1.0.0
  * \version 1.0.0
  * \date 2016-09-05
@@ -45,7 +48,7 @@
  * \param name      The name of the container. Can be returned by objectName().
  * \param parent    The parent object.
  */
-Container::Container(const QString &name, QObject *parent) : QObject(parent)
+Container::Container(const QString &name, QObject *parent) : QObject(parent), m_indexed(false)
 {
     setObjectName(name);
 
@@ -69,22 +72,82 @@ Container::Container(const QString &name, QObject *parent) : QObject(parent)
  */
 void Container::setTranslation(const QString &key, const QString &lang, const QString &translation)
 {
-    QList<Key*> ks = findChildren<Key *>(QRegularExpression(key, QRegularExpression::CaseInsensitiveOption), Qt::FindDirectChildrenOnly);
+    Key *k = this->key(key, true);
 
-    Key *k = nullptr;
+    if (k) {
+        k->setTranslation(lang, translation);
+    }
+}
 
-    if (ks.isEmpty()) {
-        k = new Key(key, this);
-    } else {
-        k = ks.first();
+
+/*!
+ * \brief Returns the key identified by the case insensitive \a id.
+ *
+ * If the key does not exist and \a create is true, a new empty key will be created,
+ * otherwise a null pointer is returned.
+ *
+ * \since 1.1.0
+ */
+Key *Container::key(const QString &id, bool create)
+{
+    Key *k = findKey(id);
+
+    if (!k && create) {
+        k = new Key(id, this);
+        m_keys.insert(id.toCaseFolded(), k);
     }
 
-    if (k) {
-        k->setTranslation(lang, translation);
+    return k;
+}
+
+
+
+/*!
+ * \brief Returns the keys of this container in creation order.
+ * \since 1.1.0
+ */
+QVector<Key*> Container::keys() const
+{
+    return findChildren<Key *>(QString(), Qt::FindDirectChildrenOnly).toVector();
+}
+
+
+
+/*!
+ * \brief Looks up the key with the case insensitive \a id in the index, builds the index on first use.
+ * \since 1.1.0
+ */
+Key *Container::findKey(const QString &id) const
+{
+    if (!m_indexed) {
+        const QList<Key*> ks = findChildren<Key *>(QString(), Qt::FindDirectChildrenOnly);
+        m_keys.reserve(ks.size());
+        for (int i = 0; i < ks.size(); ++i) {
+            const QString folded = ks.at(i)->objectName().toCaseFolded();
+            if (!m_keys.contains(folded)) {
+                m_keys.insert(folded, ks.at(i));
+            }
+        }
+        m_indexed = true;
+    }
+
+    QHash<QString, QPointer<Key> >::iterator it = m_keys.find(id.toCaseFolded());
+
+    if (it == m_keys.end()) {
+        return nullptr;
+    }
+
+    // the key has been deleted in the meantime
+    if (it.value().isNull()) {
+        m_keys.erase(it);
+        return nullptr;
     }
+
+    return it.value().data();
 }
 
 
+
 /*!
  * \brief Returns a pointer to the translation identified by key and language.
  * \since 1.0.0
@@ -94,13 +157,9 @@ void Container::setTranslation(const QString &key, const QString &lang, const QS
  */
 Translation *Container::getTranslation(const QString &key, const QString &lang)
 {
-    QList<Key*> ks = findChildren<Key *>(QRegularExpression(key, QRegularExpression::CaseInsensitiveOption), Qt::FindDirectChildrenOnly);
-
-    if (ks.isEmpty()) {
-        return nullptr;
-    }
+    Key *k = findKey(key);
 
-    return ks.first()->getTranslation(lang);
+    return k ? k->getTranslation(lang) : nullptr;
 }
 
 
@@ -113,13 +172,9 @@ Translation *Container::getTranslation(const QString &key, const QString &lang)
  */
 QList<Translation *> Container::getAllTranslations(const QString &key) const
 {
-    QList<Key*> ks = findChildren<Key *>(QRegularExpression(key, QRegularExpression::CaseInsensitiveOption), Qt::FindDirectChildrenOnly);
+    Key *k = findKey(key);
 
-    if (ks.isEmpty()) {
-        return QList<Translation*>();
-    }
-
-    return ks.first()->getAllTranslations();
+    return k ? k->getAllTranslations() : QList<Translation*>();
 }
 
 
@@ -133,8 +188,20 @@ QList<Translation *> Container::getAllTranslations(const QString &key) const
  */
 QDomDocument Container::toXml() const
 {
-    QList<Key *> ks = findChildren<Key *>(QString(), Qt::FindDirectChildrenOnly);
+    return toXml(keys());
+}
+
 
+/*!
+ * \brief Converts this object into an XML entity, containing the \a keys in the given order.
+ *
+ * \a keys have to be children of this container.
+ *
+ * \since 1.1.0
+ * \return XML document
+ */
+QDomDocument Container::toXml(const QVector<Key *> &ks) const
+{
     QDomDocument xml;
 
     if (ks.isEmpty()) {
@@ -165,12 +232,27 @@ QDomDocument Container::toXml() const
  *
  * \param lang          The target language of the XLIFF document.
  * \param version2      Set to true if the output should be XLIFF 2.0 compatible.
+ * \param since         Baseline project for delta exports, see Project::toXliff().
+ * \param memory        Translation memory to propose matches for untranslated keys from, see Key::toXliffMatch().
+ * \param duplicates    Duplicate source strings to collapse, see Project::toXliff().
  * \return              XML document
  */
-QDomDocument Container::toXliff(const QString &lang, bool version2) const
+QDomDocument Container::toXliff(const QString &lang, bool version2, const Project *since, const TranslationMemory *memory, const DuplicateFinder *duplicates) const
 {
-    QList<Key *> ks = findChildren<Key*>(QString(), Qt::FindDirectChildrenOnly);
+    return toXliff(keys(), lang, version2, since, memory, duplicates);
+}
+
 
+/*!
+ * \brief Converts this object into an XLIFF compatible xml entity, containing the \a keys in the given order.
+ *
+ * \a keys have to be children of this container. See toXliff() for the other parameters.
+ *
+ * \since 1.1.0
+ * \return XML document
+ */
+QDomDocument Container::toXliff(const QVector<Key *> &ks, const QString &lang, bool version2, const Project *since, const TranslationMemory *memory, const DuplicateFinder *duplicates) const
+{
     QDomDocument xml;
 
     if (ks.isEmpty()) {
@@ -192,12 +274,62 @@ QDomDocument Container::toXliff(const QString &lang, bool version2) const
     e.setAttribute(QStringLiteral("id"), id);
     xml.appendChild(e);
 
+    // in XLIFF 2.0, matches are part of the unit and refer to the segments of the keys
+    QDomElement matches;
+
     for (int i = 0; i < ks.size(); ++i) {
-        QDomDocument k = ks.at(i)->toXliff(lang, version2);
+        QDomDocument k = ks.at(i)->toXliff(lang, version2, since, memory, duplicates);
         if (k.hasChildNodes()) {
             e.appendChild(k);
+            if (version2 && memory) {
+                QDomDocument m = ks.at(i)->toXliffMatch(lang, version2, memory);
+                if (m.hasChildNodes()) {
+                    if (matches.isNull()) {
+                        matches = xml.createElement(QStringLiteral("mtc:matches"));
+                    }
+                    matches.appendChild(m);
+                }
+            }
         }
     }
 
+    if (!matches.isNull()) {
+        e.insertBefore(matches, QDomNode());
+    }
+
+    if (!e.hasChildNodes()) {
+        return QDomDocument();
+    }
+
     return xml;
 }
+
+
+
+
+
+/*!
+ * \brief Returns the raw XML of this container that is not represented by the object model.
+ *
+ * Contains unknown attributes and the comments and unknown elements around its children, so
+ * that the StringtableWriter can write them back.
+ *
+ * \since 1.1.0
+ */
+PassThrough &Container::passThrough()
+{
+    return m_passThrough;
+}
+
+
+
+
+
+/*!
+ * \brief Returns the raw XML of this container that is not represented by the object model.
+ * \since 1.1.0
+ */
+const PassThrough &Container::passThrough() const
+{
+    return m_passThrough;
+}
@@ -21,10 +21,19 @@
 
 #include <QObject>
 #include <QDomDocument>
+#include <QHash>
+#include <QPointer>
+#include <QVector>
+#include "passthrough.h"
+#include "a3trans_global.h"
 
 class Translation;
+class Project;
+class TranslationMemory;
+class DuplicateFinder;
+class Key;
 
-class Container : public QObject
+class A3TRANS_EXPORT Container : public QObject
 {
     Q_OBJECT
 public:
@@ -36,12 +45,30 @@ public:
 
     QList<Translation *> getAllTranslations(const QString &key) const;
 
+    Key *key(const QString &id, bool create = false);
+
     QDomDocument toXml() const;
 
-    QDomDocument toXliff(const QString &lang, bool version2 = false) const;
+    QDomDocument toXml(const QVector<Key*> &keys) const;
+
+    QDomDocument toXliff(const QString &lang, bool version2 = false, const Project *since = nullptr, const TranslationMemory *memory = nullptr, const DuplicateFinder *duplicates = nullptr) const;
+
+    QDomDocument toXliff(const QVector<Key*> &keys, const QString &lang, bool version2 = false, const Project *since = nullptr, const TranslationMemory *memory = nullptr, const DuplicateFinder *duplicates = nullptr) const;
+
+    QVector<Key*> keys() const;
+
+    PassThrough &passThrough();
+
+    const PassThrough &passThrough() const;
 
 private:
     Q_DISABLE_COPY(Container)
+
+    PassThrough m_passThrough;
+    mutable QHash<QString, QPointer<Key> > m_keys;
+    mutable bool m_indexed;
+
+    Key *findKey(const QString &id) const;
 };
 
 #endif // CONTAINER_H
@@ -0,0 +1,217 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "duplicatefinder.h"
+#include "key.h"
+#include "translation.h"
+#include "report.h"
+#include <QStringList>
+
+
+
+/*!
+ * \class DuplicateFinder
+ * \brief Groups keys that have the same source string.
+ *
+ * Every Original string is hashed once, so the keys are grouped in linear time. In Normalized
+ * mode, white space is simplified and the strings are case folded before hashing, to find strings
+ * that only differ in formatting. In Exact mode, only keys with identical strings in all languages
+ * are grouped, as required to collapse the duplicates into a single XLIFF unit without losing the
+ * original strings or the existing translations.
+ *
+ * The first key of a group in the order the keys have been given is the representative of the group,
+ * the other keys are its duplicates.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new DuplicateFinder object that compares strings in \a mode.
+ * \since 1.1.0
+ */
+DuplicateFinder::DuplicateFinder(Mode mode) : m_mode(mode)
+{
+
+}
+
+
+
+/*!
+ * \brief Groups the \a keys by their source strings, replacing the result of a previous call.
+ *
+ * Keys without or with an empty Original string are ignored.
+ *
+ * \since 1.1.0
+ */
+void DuplicateFinder::find(const QVector<Key*> &keys)
+{
+    m_groups.clear();
+    m_groupOf.clear();
+
+    QHash<QString, int> sources;
+    sources.reserve(keys.size());
+
+    QVector<QVector<Key*> > all;
+
+    for (int i = 0; i < keys.size(); ++i) {
+        const Translation *o = keys.at(i)->getTranslation(QStringLiteral("Original"));
+        if (!o || o->string().isEmpty()) {
+            continue;
+        }
+
+        const QString s = m_mode == Normalized ? normalize(o->string()) : signature(keys.at(i));
+
+        QHash<QString, int>::const_iterator it = sources.constFind(s);
+        if (it != sources.constEnd()) {
+            all[it.value()].append(keys.at(i));
+        } else {
+            sources.insert(s, all.size());
+            all.append(QVector<Key*>(1, keys.at(i)));
+        }
+    }
+
+    for (int i = 0; i < all.size(); ++i) {
+        if (all.at(i).size() < 2) {
+            continue;
+        }
+        const QVector<Key*> &g = all.at(i);
+        for (int j = 0; j < g.size(); ++j) {
+            m_groupOf.insert(g.at(j), m_groups.size());
+        }
+        m_groups.append(g);
+    }
+}
+
+
+
+/*!
+ * \brief Returns the groups of keys with the same source string, every group contains at least two keys.
+ * \since 1.1.0
+ */
+QVector<QVector<Key*> > DuplicateFinder::groups() const
+{
+    return m_groups;
+}
+
+
+
+/*!
+ * \brief Returns true if \a key has the same source string as a key before it, the representative of its group.
+ * \since 1.1.0
+ */
+bool DuplicateFinder::isDuplicate(const Key *key) const
+{
+    const int g = m_groupOf.value(key, -1);
+
+    return g >= 0 && m_groups.at(g).first() != key;
+}
+
+
+
+/*!
+ * \brief Returns the duplicates of \a key if it is the representative of a group, otherwise an empty list.
+ * \since 1.1.0
+ */
+QVector<Key*> DuplicateFinder::duplicatesOf(const Key *key) const
+{
+    const int g = m_groupOf.value(key, -1);
+
+    if (g < 0 || m_groups.at(g).first() != key) {
+        return QVector<Key*>();
+    }
+
+    return m_groups.at(g).mid(1);
+}
+
+
+
+/*!
+ * \brief Returns the number of keys that are duplicates of another key.
+ * \since 1.1.0
+ */
+int DuplicateFinder::duplicateCount() const
+{
+    return m_groupOf.size() - m_groups.size();
+}
+
+
+
+/*!
+ * \brief Adds a finding for every group to the \a report.
+ *
+ * The finding is reported for the representative of the group and lists the ids of its duplicates.
+ *
+ * \since 1.1.0
+ */
+void DuplicateFinder::report(Report *report) const
+{
+    if (!report) {
+        return;
+    }
+
+    for (int i = 0; i < m_groups.size(); ++i) {
+        const QVector<Key*> &g = m_groups.at(i);
+        QStringList ids;
+        for (int j = 1; j < g.size(); ++j) {
+            ids.append(g.at(j)->objectName());
+        }
+        report->add(QStringLiteral("duplicate-source"), Report::Note, g.first()->objectName(), tr("Same source string as %1").arg(ids.join(QStringLiteral(", "))));
+    }
+}
+
+
+
+/*!
+ * \brief Returns the strings of all languages of the \a key, used for comparisons in Exact mode.
+ *
+ * Empty translations are treated like missing ones.
+ *
+ * \since 1.1.0
+ */
+QString DuplicateFinder::signature(const Key *key)
+{
+    const QList<Translation*> ts = key->getAllTranslations();
+
+    QStringList parts;
+    for (int i = 0; i < ts.size(); ++i) {
+        if (!ts.at(i)->string().isEmpty()) {
+            parts.append(ts.at(i)->objectName() + QChar(0x1f) + ts.at(i)->string());
+        }
+    }
+
+    parts.sort();
+
+    return parts.join(QChar(0x1e));
+}
+
+
+
+/*!
+ * \brief Returns the form of \a source used for comparisons in Normalized mode.
+ * \since 1.1.0
+ */
+QString DuplicateFinder::normalize(const QString &source)
+{
+    return source.simplified().toCaseFolded();
+}
@@ -0,0 +1,65 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DUPLICATEFINDER_H
+#define DUPLICATEFINDER_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <QCoreApplication>
+#include "a3trans_global.h"
+
+class Project;
+class Key;
+class Report;
+
+class A3TRANS_EXPORT DuplicateFinder
+{
+    Q_DECLARE_TR_FUNCTIONS(DuplicateFinder)
+public:
+    enum Mode {
+        Normalized,
+        Exact
+    };
+
+    explicit DuplicateFinder(Mode mode = Normalized);
+
+    void find(const QVector<Key*> &keys);
+
+    QVector<QVector<Key*> > groups() const;
+
+    bool isDuplicate(const Key *key) const;
+
+    QVector<Key*> duplicatesOf(const Key *key) const;
+
+    int duplicateCount() const;
+
+    void report(Report *report) const;
+
+    static QString normalize(const QString &source);
+
+private:
+    Mode m_mode;
+    QVector<QVector<Key*> > m_groups;
+    QHash<const Key*, int> m_groupOf;
+
+    static QString signature(const Key *key);
+};
+
+#endif // DUPLICATEFINDER_H
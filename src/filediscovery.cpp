@@ -0,0 +1,328 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "filediscovery.h"
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QFile>
+#include <QTextStream>
+#include <QRunnable>
+#include <QMutexLocker>
+#include <algorithm>
+
+
+
+/*!
+ * \internal
+ * \brief Lists a single directory on the thread pool of a FileDiscovery object.
+ */
+class DirectoryTask : public QRunnable
+{
+public:
+    DirectoryTask(FileDiscovery *discovery, const QString &path) : m_discovery(discovery), m_path(path) {}
+
+    void run() override
+    {
+        m_discovery->scan(m_path);
+    }
+
+private:
+    FileDiscovery *m_discovery;
+    QString m_path;
+};
+
+
+
+/*!
+ * \class FileDiscovery
+ * \brief Discovers the files to parse in a directory tree.
+ *
+ * Every directory is listed in its own task on the global thread pool, so that the stat calls of
+ * large or network mounted trees are issued in parallel. All FileDiscovery objects of the process,
+ * also those of parallel jobs, share the threads of the global pool. Files accepted by the FileMatcher
+ * are consumed by the parsers via next() while further directories are listed, so that discovery and
+ * parsing overlap. Every file is matched only once, together with the kind of scanner it should be
+ * routed to.
+ *
+ * The directory tasks finish in any order, but next() hands out the files in a fixed order, so that
+ * the same tree always produces the same output: the files of a directory ordered by path, followed
+ * by the files of its subdirectories, one subdirectory after another in the order of their paths.
+ * Listed directories whose files can not be handed out yet are kept until it is their turn. No
+ * further directories are listed while more files than the queue capacity are waiting, except the
+ * one next() is waiting for.
+ *
+ * Directories and files can be excluded by glob patterns in a \c .a3transignore file in the
+ * root directory, one pattern per line, that are added as exclude patterns to the matcher.
+ * Lines starting with \c # are comments. Version control directories are always ignored.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new FileDiscovery object.
+ * \since 1.1.0
+ * \param rootDir       The directory to start the discovery in.
+ * \param matcher       The include and exclude patterns. The ignore rules will be added to a copy of it.
+ * \param parent        Pointer to the parent object.
+ */
+FileDiscovery::FileDiscovery(const QString &rootDir, const FileMatcher &matcher, QObject *parent) :
+    QObject(parent), m_root(rootDir), m_matcher(matcher), m_pool(QThreadPool::globalInstance()), m_capacity(256), m_buffered(0), m_pendingDirs(0), m_aborted(false)
+{
+    loadIgnoreRules();
+}
+
+
+
+/*!
+ * \brief Stops the discovery and waits for its running tasks to finish.
+ */
+FileDiscovery::~FileDiscovery()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_aborted = true;
+
+    // the global pool is shared, so only the tasks of this object are waited for
+    while (m_pendingDirs > 0) {
+        m_listed.wait(&m_mutex);
+    }
+}
+
+
+
+/*!
+ * \brief Starts the discovery in the background.
+ * \since 1.1.0
+ */
+void FileDiscovery::start()
+{
+    QMutexLocker locker(&m_mutex);
+
+    const QString path = m_root.absolutePath();
+
+    m_directories.insert(path, Directory());
+    m_order.push(path);
+    startDirectory(path);
+}
+
+
+
+/*!
+ * \brief Returns the full path of the next discovered file.
+ *
+ * Blocks until the directory of the next file has been listed. Returns a null string if all
+ * directories have been listed and all discovered files have been returned. If \a kind is not
+ * a null pointer, it will be set to the kind of scanner the file should be routed to.
+ *
+ * \since 1.1.0
+ */
+QString FileDiscovery::next(FileMatcher::Kind *kind)
+{
+    QMutexLocker locker(&m_mutex);
+
+    while (m_queue.isEmpty()) {
+
+        if (m_order.isEmpty()) {
+            return QString();
+        }
+
+        const QString path = m_order.top();
+        Directory &d = m_directories[path];
+
+        if (!d.listed) {
+            // the directory whose files are next is listed at once, also if the queue is full
+            if (!d.started) {
+                startDirectory(path);
+            }
+            m_listed.wait(&m_mutex);
+            continue;
+        }
+
+        m_order.pop();
+
+        const Directory listed = m_directories.take(path);
+
+        for (int i = 0; i < listed.files.size(); ++i) {
+            m_queue.enqueue(listed.files.at(i));
+        }
+
+        for (int i = listed.dirs.size() - 1; i >= 0; --i) {
+            m_order.push(listed.dirs.at(i));
+        }
+    }
+
+    const QPair<QString, FileMatcher::Kind> entry = m_queue.dequeue();
+
+    m_buffered--;
+    scheduleDirectories();
+
+    if (kind) {
+        *kind = entry.second;
+    }
+
+    return entry.first;
+}
+
+
+
+/*!
+ * \brief Sets the number of discovered files that can wait for the consumer before no further directories are listed.
+ *
+ * The default capacity is 256 files.
+ *
+ * \since 1.1.0
+ */
+void FileDiscovery::setQueueCapacity(int capacity)
+{
+    QMutexLocker locker(&m_mutex);
+    m_capacity = qMax(1, capacity);
+    scheduleDirectories();
+}
+
+
+
+/*!
+ * \brief Adds the rules from the .a3transignore file in the root directory to the matcher.
+ * \since 1.1.0
+ */
+void FileDiscovery::loadIgnoreRules()
+{
+    m_matcher.addExclude(QStringLiteral(".git/"));
+    m_matcher.addExclude(QStringLiteral(".svn/"));
+    m_matcher.addExclude(QStringLiteral(".hg/"));
+
+    QFile f(m_root.absoluteFilePath(QStringLiteral(".a3transignore")));
+
+    if (f.open(QIODevice::ReadOnly|QIODevice::Text)) {
+        QTextStream in(&f);
+        in.setCodec("UTF-8");
+        while (!in.atEnd()) {
+            const QString line = in.readLine().trimmed();
+            if (!line.isEmpty() && !line.startsWith(QLatin1Char('#'))) {
+                m_matcher.addExclude(line);
+            }
+        }
+    }
+
+    m_matcher.compile();
+}
+
+
+
+/*!
+ * \brief Lists the directory at \a path and keeps its matching files and subdirectories ordered by path.
+ * \since 1.1.0
+ */
+void FileDiscovery::scan(const QString &path)
+{
+    QVector<QPair<QString, FileMatcher::Kind> > files;
+    QStringList dirs;
+
+    bool aborted = false;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        aborted = m_aborted;
+    }
+
+    QDirIterator it(path, QDir::Files|QDir::Dirs|QDir::NoDotAndDotDot);
+
+    while (!aborted && it.hasNext()) {
+        it.next();
+
+        const QFileInfo fi = it.fileInfo();
+        const QString relativePath = m_root.relativeFilePath(fi.absoluteFilePath());
+
+        if (fi.isDir()) {
+
+            if (!fi.isSymLink() && !m_matcher.isExcludedDir(relativePath)) {
+                dirs.append(fi.absoluteFilePath());
+            }
+
+        } else {
+
+            const FileMatcher::Kind kind = m_matcher.match(relativePath);
+
+            if (kind != FileMatcher::None) {
+                files.append(qMakePair(fi.absoluteFilePath(), kind));
+            }
+
+        }
+    }
+
+    std::sort(files.begin(), files.end(), [](const QPair<QString, FileMatcher::Kind> &a, const QPair<QString, FileMatcher::Kind> &b) {
+        return a.first < b.first;
+    });
+    std::sort(dirs.begin(), dirs.end());
+
+    QMutexLocker locker(&m_mutex);
+
+    for (int i = 0; i < dirs.size(); ++i) {
+        m_directories.insert(dirs.at(i), Directory());
+        m_waiting.enqueue(dirs.at(i));
+    }
+
+    Directory &d = m_directories[path];
+    d.files = files;
+    d.dirs = dirs;
+    d.listed = true;
+
+    m_buffered += files.size();
+    m_pendingDirs--;
+
+    scheduleDirectories();
+
+    m_listed.wakeAll();
+}
+
+
+
+/*!
+ * \brief Starts the task that lists the directory at \a path, the mutex has to be locked.
+ * \since 1.1.0
+ */
+void FileDiscovery::startDirectory(const QString &path)
+{
+    m_directories[path].started = true;
+    m_pendingDirs++;
+    m_pool->start(new DirectoryTask(this, path));
+}
+
+
+
+/*!
+ * \brief Starts tasks for the waiting directories while the queue capacity is not reached, the mutex has to be locked.
+ * \since 1.1.0
+ */
+void FileDiscovery::scheduleDirectories()
+{
+    while (!m_aborted && m_buffered < m_capacity && !m_waiting.isEmpty()) {
+        const QString path = m_waiting.dequeue();
+        const QHash<QString, Directory>::const_iterator it = m_directories.constFind(path);
+        // the consumer starts the directory it is waiting for itself
+        if (it != m_directories.constEnd() && !it.value().started) {
+            startDirectory(path);
+        }
+    }
+}
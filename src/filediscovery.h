@@ -0,0 +1,83 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FILEDISCOVERY_H
+#define FILEDISCOVERY_H
+
+#include <QObject>
+#include <QDir>
+#include <QQueue>
+#include <QStack>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QPair>
+#include "filematcher.h"
+#include "a3trans_global.h"
+
+class A3TRANS_EXPORT FileDiscovery : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FileDiscovery(const QString &rootDir, const FileMatcher &matcher, QObject *parent = nullptr);
+    ~FileDiscovery();
+
+    void start();
+
+    QString next(FileMatcher::Kind *kind = nullptr);
+
+    void setQueueCapacity(int capacity);
+
+private:
+    Q_DISABLE_COPY(FileDiscovery)
+
+    friend class DirectoryTask;
+
+    QDir m_root;
+    FileMatcher m_matcher;
+
+    struct Directory
+    {
+        QVector<QPair<QString, FileMatcher::Kind> > files;
+        QStringList dirs;
+        bool started = false;
+        bool listed = false;
+    };
+
+    QThreadPool *m_pool;
+    QMutex m_mutex;
+    QWaitCondition m_listed;
+    QHash<QString, Directory> m_directories;
+    QQueue<QString> m_waiting;
+    QStack<QString> m_order;
+    QQueue<QPair<QString, FileMatcher::Kind> > m_queue;
+    int m_capacity;
+    int m_buffered;
+    int m_pendingDirs;
+    bool m_aborted;
+
+    void loadIgnoreRules();
+    void scan(const QString &path);
+    void startDirectory(const QString &path);
+    void scheduleDirectories();
+};
+
+#endif // FILEDISCOVERY_H
@@ -0,0 +1,246 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "filematcher.h"
+
+
+
+/*!
+ * \class FileMatcher
+ * \brief Decides which files are parsed and which scanner they are routed to.
+ *
+ * The matcher holds a set of include and exclude glob patterns that are compiled into a single
+ * case insensitive regular expression each by compile(). Patterns are matched against the path
+ * relative to the working directory, using slashes as separator. Patterns without a slash match
+ * the file name in any directory, patterns containing a slash are anchored at the working directory.
+ * \c ** matches across directories.
+ *
+ * Every include pattern is associated with a file Kind. Patterns for \c .sqf, \c .sqs and \c .inc
+ * files are routed to the script scanner, all other patterns to the config scanner. The kind can
+ * be set explicitly by prefixing the pattern with \c script: or \c config:.
+ *
+ * Exclude patterns ending with a slash only match directories.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new empty FileMatcher object.
+ * \since 1.1.0
+ */
+FileMatcher::FileMatcher()
+{
+
+}
+
+
+
+/*!
+ * \brief Returns the include patterns used if no include patterns are set by the user.
+ * \since 1.1.0
+ */
+QStringList FileMatcher::defaultIncludes()
+{
+    return QStringList({QStringLiteral("*.sqf"), QStringLiteral("*.inc"), QStringLiteral("description.ext"), QStringLiteral("mission.sqm"), QStringLiteral("config.cpp"), QStringLiteral("*.hpp"), QStringLiteral("*.h")});
+}
+
+
+
+/*!
+ * \brief Adds an include pattern.
+ *
+ * Call compile() after adding all patterns.
+ *
+ * \since 1.1.0
+ * \param glob  Wildcard pattern, optionally prefixed with \c script: or \c config:.
+ */
+void FileMatcher::addInclude(const QString &glob)
+{
+    QString g = glob.trimmed();
+
+    if (g.startsWith(QLatin1String("script:"), Qt::CaseInsensitive)) {
+        m_scriptPatterns.append(pathPattern(g.mid(7)));
+    } else if (g.startsWith(QLatin1String("config:"), Qt::CaseInsensitive)) {
+        m_configPatterns.append(pathPattern(g.mid(7)));
+    } else if (g.endsWith(QLatin1String(".sqf"), Qt::CaseInsensitive) || g.endsWith(QLatin1String(".sqs"), Qt::CaseInsensitive) || g.endsWith(QLatin1String(".inc"), Qt::CaseInsensitive)) {
+        m_scriptPatterns.append(pathPattern(g));
+    } else if (!g.isEmpty()) {
+        m_configPatterns.append(pathPattern(g));
+    }
+}
+
+
+
+/*!
+ * \brief Adds an exclude pattern.
+ *
+ * Call compile() after adding all patterns.
+ *
+ * \since 1.1.0
+ * \param glob  Wildcard pattern. If it ends with a slash, it only matches directories.
+ */
+void FileMatcher::addExclude(const QString &glob)
+{
+    QString g = glob.trimmed();
+
+    if (g.isEmpty()) {
+        return;
+    }
+
+    if (g.endsWith(QLatin1Char('/'))) {
+        g.chop(1);
+        m_excludeDirPatterns.append(pathPattern(g));
+    } else {
+        m_excludePatterns.append(pathPattern(g));
+    }
+}
+
+
+
+/*!
+ * \brief Compiles the patterns into regular expressions.
+ * \since 1.1.0
+ */
+void FileMatcher::compile()
+{
+    m_include.setPattern(QLatin1String("^(?:(?<script>") + alternation(m_scriptPatterns) + QLatin1String(")|(?<config>") + alternation(m_configPatterns) + QLatin1String("))$"));
+    m_include.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+    m_include.optimize();
+
+    m_exclude.setPattern(QLatin1String("^(?:") + alternation(m_excludePatterns) + QLatin1String(")$"));
+    m_exclude.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+    m_exclude.optimize();
+
+    m_excludeDir.setPattern(QLatin1String("^(?:") + alternation(m_excludeDirPatterns) + QLatin1String(")$"));
+    m_excludeDir.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+    m_excludeDir.optimize();
+}
+
+
+
+/*!
+ * \brief Returns the kind of the file at \a relativePath or None if the file should not be parsed.
+ * \since 1.1.0
+ */
+FileMatcher::Kind FileMatcher::match(const QString &relativePath) const
+{
+    const QRegularExpressionMatch m = m_include.match(relativePath);
+
+    if (!m.hasMatch() || m_exclude.match(relativePath).hasMatch()) {
+        return None;
+    }
+
+    return m.capturedStart(QStringLiteral("script")) >= 0 ? Script : Config;
+}
+
+
+
+/*!
+ * \brief Returns true if the directory at \a relativePath should not be traversed.
+ * \since 1.1.0
+ */
+bool FileMatcher::isExcludedDir(const QString &relativePath) const
+{
+    return m_excludeDir.match(relativePath).hasMatch() || m_exclude.match(relativePath).hasMatch();
+}
+
+
+
+/*!
+ * \brief Converts the wildcard pattern \a glob into a regular expression pattern.
+ *
+ * \c ** matches any number of characters including slashes, \c * and \c ? match any number
+ * respectively a single character except slashes. Character classes are passed through.
+ *
+ * \since 1.1.0
+ */
+QString FileMatcher::globToRegex(const QString &glob)
+{
+    QString rx;
+    rx.reserve(glob.size() * 2);
+
+    for (int i = 0; i < glob.size(); ++i) {
+        const QChar c = glob.at(i);
+
+        if (c == QLatin1Char('*')) {
+            if (i + 1 < glob.size() && glob.at(i + 1) == QLatin1Char('*')) {
+                rx.append(QLatin1String(".*"));
+                i++;
+            } else {
+                rx.append(QLatin1String("[^/]*"));
+            }
+        } else if (c == QLatin1Char('?')) {
+            rx.append(QLatin1String("[^/]"));
+        } else if (c == QLatin1Char('[')) {
+            const int end = glob.indexOf(QLatin1Char(']'), i + 1);
+            if (end > i) {
+                rx.append(glob.midRef(i, end - i + 1));
+                i = end;
+            } else {
+                rx.append(QLatin1String("\\["));
+            }
+        } else {
+            rx.append(QRegularExpression::escape(QString(c)));
+        }
+    }
+
+    return rx;
+}
+
+
+
+/*!
+ * \brief Converts \a glob into a pattern that is matched against a relative path.
+ * \since 1.1.0
+ */
+QString FileMatcher::pathPattern(const QString &glob)
+{
+    QString g = glob;
+    g.replace(QLatin1Char('\\'), QLatin1Char('/'));
+
+    if (g.startsWith(QLatin1Char('/'))) {
+        return globToRegex(g.mid(1));
+    }
+
+    if (g.contains(QLatin1Char('/'))) {
+        return globToRegex(g);
+    }
+
+    return QLatin1String("(?:.*/)?") + globToRegex(g);
+}
+
+
+
+/*!
+ * \brief Joins \a patterns into an alternation that never matches if the list is empty.
+ * \since 1.1.0
+ */
+QString FileMatcher::alternation(const QStringList &patterns)
+{
+    if (patterns.isEmpty()) {
+        return QStringLiteral("(?!)");
+    }
+
+    return patterns.join(QLatin1Char('|'));
+}
@@ -0,0 +1,65 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FILEMATCHER_H
+#define FILEMATCHER_H
+
+#include <QStringList>
+#include <QRegularExpression>
+#include "a3trans_global.h"
+
+class A3TRANS_EXPORT FileMatcher
+{
+public:
+    enum Kind {
+        None,
+        Script,
+        Config
+    };
+
+    FileMatcher();
+
+    static QStringList defaultIncludes();
+
+    void addInclude(const QString &glob);
+
+    void addExclude(const QString &glob);
+
+    void compile();
+
+    Kind match(const QString &relativePath) const;
+
+    bool isExcludedDir(const QString &relativePath) const;
+
+    static QString globToRegex(const QString &glob);
+
+private:
+    QStringList m_scriptPatterns;
+    QStringList m_configPatterns;
+    QStringList m_excludePatterns;
+    QStringList m_excludeDirPatterns;
+
+    QRegularExpression m_include;
+    QRegularExpression m_exclude;
+    QRegularExpression m_excludeDir;
+
+    static QString pathPattern(const QString &glob);
+    static QString alternation(const QStringList &patterns);
+};
+
+#endif // FILEMATCHER_H
@@ -18,10 +18,13 @@
 
 #include "filewriter.h"
 #include "project.h"
+#include "stringtablewriter.h"
+#include "package.h"
 #include <QFile>
 #include <QDomDocument>
 #include <QStringList>
 #include <QDateTime>
+#include <algorithm>
 
 
 
@@ -49,34 +52,73 @@ FileWriter::FileWriter(const QDir &workingDir, Project *project, QObject *parent
 
 /*!
  * \brief Writes a new stringtable.xml file in the working directory.
+ *
+ * The file is written package by package via the StringtableWriter, together with the raw markup
+ * kept by the StringtableParser. Every Package, Container and Key object is written as an element
+ * of its own, also if it is empty.
+ *
  * \since 1.0.0
  * \param backup    Set to true if the current stringtable.xml file should be copied to backup file.
+ * \param sorted    Set to true to write packages and containers ordered by name and keys ordered by case folded id, like Project::sortedKeys().
  */
-void FileWriter::writeStringTable(bool backup)
+void FileWriter::writeStringTable(bool backup, bool sorted)
 {
     if (!m_prj) {
         qFatal("No valid project object.");
         return;
     }
 
-    QFile stf(m_wd.absoluteFilePath(QStringLiteral("stringtable.xml")));
+    if (backup && !backupStringTable()) {
+        return;
+    }
 
-    if (stf.exists() && backup) {
-        if (!stf.copy(m_wd.absoluteFilePath(QStringLiteral("stringtable_")).append(QString::number(QDateTime::currentDateTimeUtc().toTime_t())).append(QLatin1String(".xml.bak")))) {
-            qCritical("%s", qUtf8Printable(tr("Failed to create stringtable.xml backup file.")));
-            return;
-        }
+    StringtableWriter writer(m_wd.absoluteFilePath(QStringLiteral("stringtable.xml")));
+
+    if (!writer.open(m_prj->objectName(), &m_prj->passThrough())) {
+        return;
+    }
+
+    QList<Package*> ps = m_prj->findChildren<Package*>(QString(), Qt::FindDirectChildrenOnly);
+
+    if (sorted) {
+        std::stable_sort(ps.begin(), ps.end(), [](const Package *a, const Package *b) {
+            return a->objectName() < b->objectName();
+        });
+    }
+
+    for (int i = 0; i < ps.size(); ++i) {
+        writer.writePackage(ps.at(i), sorted);
+    }
+
+    if (!writer.commit()) {
+        qCritical("%s", qUtf8Printable(tr("Failed to write stringtable.xml file.")));
     }
 
+}
+
+
+
+
+/*!
+ * \brief Copies the current stringtable.xml file in the working directory to a backup file.
+ *
+ * The backup file name contains the current time stamp. Returns true on success or if there
+ * is no stringtable.xml file.
+ *
+ * \since 1.1.0
+ */
+bool FileWriter::backupStringTable() const
+{
+    QFile stf(m_wd.absoluteFilePath(QStringLiteral("stringtable.xml")));
+
     if (stf.exists()) {
-        if (!stf.remove()) {
-            qCritical("%s", qUtf8Printable(tr("Failed to remove current stringtable.xml file.")));
-            return;
+        if (!stf.copy(m_wd.absoluteFilePath(QStringLiteral("stringtable_")).append(QString::number(QDateTime::currentDateTimeUtc().toTime_t())).append(QLatin1String(".xml.bak")))) {
+            qCritical("%s", qUtf8Printable(tr("Failed to create stringtable.xml backup file.")));
+            return false;
         }
     }
 
-    writeToFile(stf.fileName(), QStringLiteral("stringtable.xml"), m_prj->toXml().toByteArray(8));
-
+    return true;
 }
 
 
@@ -86,10 +128,9 @@ void FileWriter::writeStringTable(bool backup)
  * \brief Writes XLIFF CAT files to the l10n directory inside the current working directory.
  * \since 1.0.0
  * \param trgLangs  List of target languages. If empty, only a source translation file will be created.
- * \param srcLang   ISO 639-1 language code of the source language.
- * \param version2  Set this to true to write XLIFF 2.0 compatible files.
+ * \param options   Source language, XLIFF version, baseline project for delta exports and output order, see Project::toXliff().
  */
-void FileWriter::writeXliff(const QStringList &trgLangs, const QString &srcLang, bool version2)
+void FileWriter::writeXliff(const QStringList &trgLangs, const XliffOptions &options)
 {
     if (!m_prj) {
         qFatal("No valid project object.");
@@ -108,7 +149,7 @@ void FileWriter::writeXliff(const QStringList &trgLangs, const QString &srcLang,
     QString filePath = fullFilePath;
     filePath.remove(m_wd.absolutePath());
 
-    writeToFile(fullFilePath, filePath, m_prj->toXliff(QString(), srcLang, version2).toByteArray(8));
+    writeToFile(fullFilePath, filePath, m_prj->toXliff(QString(), options).toByteArray(8));
 
     if (!trgLangs.isEmpty()) {
 
@@ -120,7 +161,7 @@ void FileWriter::writeXliff(const QStringList &trgLangs, const QString &srcLang,
             filePath = fullFilePath;
             filePath.remove(m_wd.absolutePath());
 
-            writeToFile(fullFilePath, filePath, m_prj->toXliff(l, srcLang, version2).toByteArray(8));
+            writeToFile(fullFilePath, filePath, m_prj->toXliff(l, options).toByteArray(8));
         }
 
     }
@@ -21,19 +21,21 @@
 
 #include <QObject>
 #include <QDir>
+#include "project.h"
+#include "a3trans_global.h"
 
-class Project;
-
-class FileWriter : public QObject
+class A3TRANS_EXPORT FileWriter : public QObject
 {
     Q_OBJECT
 public:
     explicit FileWriter(const QDir &workingDir, Project *project, QObject *parent = nullptr);
 
 
-    void writeStringTable(bool backup = false);
+    void writeStringTable(bool backup = false, bool sorted = false);
+
+    bool backupStringTable() const;
 
-    void writeXliff(const QStringList &trgLangs, const QString &srcLang = QStringLiteral("en"), bool version2 = false);
+    void writeXliff(const QStringList &trgLangs, const XliffOptions &options = XliffOptions());
 
 private:
     QDir m_wd;
@@ -0,0 +1,199 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "includecache.h"
+#include "scriptparser.h"
+#include "configscanner.h"
+#include "artifactcache.h"
+#include <QFileInfo>
+
+
+
+/*!
+ * \class IncludeCache
+ * \brief Parses every script file only once per run and resolves include directives.
+ *
+ * Script files, description.ext and config files often include shared headers via \c #include.
+ * Script files are parsed by the ScriptParser, config files by the ConfigScanner. The cache makes sure that every file is parsed exactly once, no matter how many files include it,
+ * and keeps the extracted data, so that it can be attributed to every including file. Include
+ * cycles are detected and reported.
+ *
+ * The cache is not thread-safe, it is meant to be used by the thread that consumes the discovered files.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new IncludeCache object.
+ * \since 1.1.0
+ * \param rootDir   The working directory, used to resolve absolute include paths like \c \\x\\mod\\addons\\main\\macros.hpp
+ * \param parent    Pointer to the parent object.
+ */
+IncludeCache::IncludeCache(const QString &rootDir, QObject *parent) : QObject(parent), m_root(rootDir), m_artifacts(nullptr)
+{
+
+}
+
+
+
+/*!
+ * \brief Returns the data extracted from the file at \a filePath.
+ *
+ * If the file has not been parsed yet, it will be parsed together with all files it includes.
+ * Returns a null pointer if the file is part of an include cycle.
+ *
+ * \since 1.1.0
+ * \param filePath  Absolute path to the script or config file.
+ * \param kind      The scanner to use. If this is FileMatcher::None, it is determined by the file extension.
+ */
+const ScriptResult *IncludeCache::result(const QString &filePath, FileMatcher::Kind kind)
+{
+    const QString path = QDir::cleanPath(filePath);
+
+    QHash<QString, ScriptResult>::const_iterator it = m_results.constFind(path);
+    if (it != m_results.constEnd()) {
+        return &it.value();
+    }
+
+    if (m_inProgress.contains(path)) {
+        qWarning("%s", qUtf8Printable(tr("Include cycle detected at file: %1").arg(m_root.relativeFilePath(path))));
+        return nullptr;
+    }
+
+    m_inProgress.insert(path);
+
+    ScriptResult r;
+
+    if (kind == FileMatcher::None) {
+        kind = kindFromPath(path);
+    }
+
+    // files fetched from the artifact cache are not parsed, their includes are parsed on first use
+    if (!m_artifacts || !m_artifacts->fetch(path, kind, &r)) {
+
+        if (kind == FileMatcher::Config) {
+            ConfigScanner cs(path);
+            r = cs.extract(this);
+        } else {
+            ScriptParser sp(path, nullptr, nullptr);
+            r = sp.extract(this);
+        }
+
+        if (m_artifacts) {
+            m_artifacts->store(r, kind);
+        }
+    }
+
+    m_inProgress.remove(path);
+
+    return &m_results.insert(path, r).value();
+}
+
+
+
+/*!
+ * \brief Removes the data extracted from the file at \a filePath, so that it will be parsed again on next use.
+ * \since 1.1.0
+ */
+void IncludeCache::remove(const QString &filePath)
+{
+    m_results.remove(QDir::cleanPath(filePath));
+}
+
+
+
+/*!
+ * \brief Sets the \a artifacts cache that is used to fetch the data of unchanged files instead of parsing them.
+ *
+ * The cache is not owned by the IncludeCache.
+ *
+ * \since 1.1.0
+ */
+void IncludeCache::setArtifactCache(ArtifactCache *artifacts)
+{
+    m_artifacts = artifacts;
+}
+
+
+
+/*!
+ * \brief Resolves the path of an include directive.
+ *
+ * Relative paths are resolved against the directory of the \a includingFile. Absolute paths,
+ * like they are used for addons, are resolved against the working directory, stripping leading
+ * path components until an existing file has been found.
+ *
+ * \since 1.1.0
+ * \param includingFile The absolute path of the file containing the include directive.
+ * \param includePath   The path given in the include directive.
+ * \return              Absolute path of the included file or a null string if it can not be found.
+ */
+QString IncludeCache::resolve(const QString &includingFile, const QString &includePath) const
+{
+    QString p = includePath.trimmed();
+    p.replace(QLatin1Char('\\'), QLatin1Char('/'));
+
+    if (p.isEmpty()) {
+        return QString();
+    }
+
+    if (!p.startsWith(QLatin1Char('/'))) {
+        const QFileInfo fi(QFileInfo(includingFile).absoluteDir(), p);
+        if (fi.isFile()) {
+            return QDir::cleanPath(fi.absoluteFilePath());
+        }
+    }
+
+    QStringList parts = p.split(QLatin1Char('/'), QString::SkipEmptyParts);
+
+    while (!parts.isEmpty()) {
+        const QFileInfo fi(m_root, parts.join(QLatin1Char('/')));
+        if (fi.isFile()) {
+            return QDir::cleanPath(fi.absoluteFilePath());
+        }
+        parts.removeFirst();
+    }
+
+    return QString();
+}
+
+
+
+/*!
+ * \brief Returns the kind of scanner for the file at \a filePath, determined by its extension.
+ *
+ * Used for included files, that have not been matched by the FileMatcher.
+ *
+ * \since 1.1.0
+ */
+FileMatcher::Kind IncludeCache::kindFromPath(const QString &filePath)
+{
+    const QString suffix = QFileInfo(filePath).suffix();
+
+    if (suffix.compare(QLatin1String("sqf"), Qt::CaseInsensitive) == 0 || suffix.compare(QLatin1String("sqs"), Qt::CaseInsensitive) == 0 || suffix.compare(QLatin1String("inc"), Qt::CaseInsensitive) == 0) {
+        return FileMatcher::Script;
+    }
+
+    return FileMatcher::Config;
+}
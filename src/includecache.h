@@ -0,0 +1,57 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INCLUDECACHE_H
+#define INCLUDECACHE_H
+
+#include <QObject>
+#include <QDir>
+#include <QHash>
+#include <QSet>
+#include "scriptresult.h"
+#include "filematcher.h"
+#include "a3trans_global.h"
+
+class ArtifactCache;
+
+class A3TRANS_EXPORT IncludeCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit IncludeCache(const QString &rootDir, QObject *parent = nullptr);
+
+    const ScriptResult *result(const QString &filePath, FileMatcher::Kind kind = FileMatcher::None);
+
+    void remove(const QString &filePath);
+
+    void setArtifactCache(ArtifactCache *artifacts);
+
+    QString resolve(const QString &includingFile, const QString &includePath) const;
+
+private:
+    Q_DISABLE_COPY(IncludeCache)
+
+    QDir m_root;
+    QHash<QString, ScriptResult> m_results;
+    QSet<QString> m_inProgress;
+    ArtifactCache *m_artifacts;
+
+    static FileMatcher::Kind kindFromPath(const QString &filePath);
+};
+
+#endif // INCLUDECACHE_H
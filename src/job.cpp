@@ -0,0 +1,636 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "job.h"
+#include "scriptparser.h"
+#include "stringtableparser.h"
+#include "project.h"
+#include "filewriter.h"
+#include "xliffparser.h"
+#include "stringtablemerger.h"
+#include "languages.h"
+#include "filediscovery.h"
+#include "includecache.h"
+#include "referenceset.h"
+#include "xliffstreamconverter.h"
+#include "xliffstreammerger.h"
+#include "translationmemory.h"
+#include "duplicatefinder.h"
+#include "validator.h"
+#include "artifact.h"
+#include "artifactcache.h"
+#include "report.h"
+#include <QElapsedTimer>
+#include <QScopedPointer>
+#include <QFileInfo>
+#include <QHash>
+#include <QPair>
+#include <QCryptographicHash>
+
+
+
+/*!
+ * \class Job
+ * \brief Processes a single working directory.
+ *
+ * A job performs the extraction or conversion requested by JobOptions for one working directory,
+ * the mod root. Jobs can be run directly or can be executed on a QThreadPool to process many
+ * working directories in one process. Every job uses its own Project objects, shared resources
+ * like the language table and the compiled expressions of the ScriptParser are initialized only
+ * once per process.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new Job object for the \a workingDir.
+ *
+ * The job will not be deleted automatically when run on a QThreadPool.
+ *
+ * \since 1.1.0
+ * \param workingDir    Path to the working directory.
+ * \param options       The options to process the working directory with.
+ * \param parent        Pointer to the parent object.
+ */
+Job::Job(const QString &workingDir, const JobOptions &options, QObject *parent) :
+    QObject(parent), m_wd(QDir(workingDir).absolutePath()), m_options(options), m_succeeded(false), m_filesParsed(0), m_elapsed(0), m_report(nullptr), m_findings(nullptr), m_stringTable(nullptr)
+{
+    setAutoDelete(false);
+}
+
+
+
+/*!
+ * \brief Processes the working directory.
+ * \since 1.1.0
+ */
+void Job::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // findings are collected per job, so that they are aggregated per working directory in a shared report
+    Report findings;
+    m_findings = m_report ? &findings : nullptr;
+
+    m_succeeded = process();
+
+    if (m_report) {
+        m_report->add(findings, m_wd.absolutePath());
+    }
+
+    m_findings = nullptr;
+
+    m_elapsed = timer.elapsed();
+}
+
+
+
+/*!
+ * \brief Sets the \a report that collects the findings of the job.
+ *
+ * If no report is set, findings are printed as debug messages. The findings of the job are added
+ * together with the working directory, so that they are not aggregated with the findings of other
+ * jobs sharing the same report.
+ *
+ * \since 1.1.0
+ */
+void Job::setReport(Report *report)
+{
+    m_report = report;
+}
+
+
+
+/*!
+ * \brief Sets an already loaded \a stringTable project of the working directory.
+ *
+ * If set, the job will use the project instead of parsing the stringtable.xml file. When extracting,
+ * the extracted strings are merged into the project, so that it reflects the written file afterwards.
+ * The job does not take ownership of the project.
+ *
+ * \since 1.1.0
+ */
+void Job::setStringTable(Project *stringTable)
+{
+    m_stringTable = stringTable;
+}
+
+
+
+/*!
+ * \brief Returns the absolute path of the working directory.
+ * \since 1.1.0
+ */
+QString Job::workingDir() const
+{
+    return m_wd.absolutePath();
+}
+
+
+
+/*!
+ * \brief Returns true if the job has been run successfully.
+ * \since 1.1.0
+ */
+bool Job::succeeded() const
+{
+    return m_succeeded;
+}
+
+
+
+/*!
+ * \brief Returns the number of script files that have been parsed.
+ * \since 1.1.0
+ */
+int Job::filesParsed() const
+{
+    return m_filesParsed;
+}
+
+
+
+/*!
+ * \brief Returns the time in milliseconds it took to run the job.
+ * \since 1.1.0
+ */
+qint64 Job::elapsed() const
+{
+    return m_elapsed;
+}
+
+
+
+/*!
+ * \brief Performs the work of the job.
+ * \since 1.1.0
+ * \return True on success.
+ */
+bool Job::process()
+{
+    const QString dirPath = m_wd.absolutePath();
+    const bool x2s = m_options.mode == JobOptions::XliffToStringtable;
+
+    // unsorted conversion to XLIFF is done without loading the stringtable into memory, unless it is needed as translation memory or for duplicates
+    const bool streaming = m_options.mode == JobOptions::ConvertToXliff && !m_options.sorted && m_options.fuzzy <= 0 && !m_options.duplicates && !m_options.collapseDuplicates && !m_stringTable;
+
+    qInfo("%s", qUtf8Printable(tr("Working directory: %1").arg(dirPath)));
+
+    if (m_options.mode == JobOptions::ExtractFile) {
+        return extractFiles();
+    }
+
+    if (x2s && !m_options.sorted && !m_options.duplicates) {
+
+        // XLIFF files sharing the same unit order are merged in a single pass without building a Project
+        qInfo("%s", qUtf8Printable(tr("Start converting XLIFF files into stringtable.xml.")));
+
+        XliffStreamMerger merger(m_wd);
+        const XliffStreamMerger::Result r = merger.merge(m_options.backup);
+
+        if (r == XliffStreamMerger::Merged) {
+            // imported translations are always checked, once it is known which path has written the file
+            Validator validator(m_findings);
+            validator.validateStringTable(m_wd.absoluteFilePath(QStringLiteral("stringtable.xml")));
+            qInfo("%s", qUtf8Printable(tr("Found %1 placeholder or tag inconsistencies.").arg(validator.violations())));
+            return true;
+        } else if (r == XliffStreamMerger::Failed) {
+            return false;
+        }
+    }
+
+    QScopedPointer<Project> loadedStringTable;
+    Project *stringTableProject = m_stringTable;
+
+    if (stringTableProject) {
+        // already loaded by the caller
+    } else if (!x2s && !streaming) {
+
+        qInfo("%s", qUtf8Printable(tr("Start parsing stringtable.xml file.")));
+
+        StringtableParser stp(m_wd.absoluteFilePath(QStringLiteral("stringtable.xml")));
+        // a source only export needs no translations, unless they have to be validated
+        if (m_options.mode == JobOptions::ConvertToXliff && m_options.sourceLangOnly && !m_options.validate) {
+            stp.setLanguages(QStringList(QStringLiteral("Original")));
+        }
+        loadedStringTable.reset(stp.parse());
+        stringTableProject = loadedStringTable.data();
+
+    } else if (m_wd.exists(QStringLiteral("stringtable.xml")) && (x2s || m_options.validate)) {
+
+        // XLIFF files are merged into the current stringtable.xml, streamed conversions only need it for validation
+        StringtableParser stp(m_wd.absoluteFilePath(QStringLiteral("stringtable.xml")));
+        loadedStringTable.reset(stp.parse());
+        stringTableProject = loadedStringTable.data();
+
+    }
+
+    if (m_options.mode == JobOptions::ConvertToXliff) {
+
+        qInfo("%s", qUtf8Printable(tr("Start converting stringtable.xml into XLIFF files.")));
+
+        if (streaming ? !m_wd.exists(QStringLiteral("stringtable.xml")) : !stringTableProject) {
+            qCritical("%s", qUtf8Printable(tr("Can not convert without a valid stringtable.xml file. Aborting.")));
+            return false;
+        }
+
+        QScopedPointer<Project> sinceProject;
+
+        if (!m_options.sincePath.isEmpty()) {
+            qInfo("%s", qUtf8Printable(tr("Start parsing baseline file: %1").arg(m_options.sincePath)));
+
+            // only the original strings are compared with the baseline
+            StringtableParser bp(m_options.sincePath);
+            bp.setLanguages(QStringList(QStringLiteral("Original")));
+            sinceProject.reset(bp.parse());
+
+            if (!sinceProject) {
+                qCritical("%s", qUtf8Printable(tr("Failed to load baseline file. Aborting.")));
+                return false;
+            }
+        }
+
+        TranslationMemory memory;
+
+        if (m_options.fuzzy > 0) {
+            memory.setThreshold(m_options.fuzzy);
+            memory.addProject(stringTableProject);
+
+            for (int i = 0; i < m_options.memoryPaths.size(); ++i) {
+                qInfo("%s", qUtf8Printable(tr("Start parsing translation memory file: %1").arg(m_options.memoryPaths.at(i))));
+                StringtableParser mp(m_options.memoryPaths.at(i));
+                QScopedPointer<Project> memoryProject(mp.parse());
+                if (!memoryProject) {
+                    qCritical("%s", qUtf8Printable(tr("Failed to load translation memory file. Aborting.")));
+                    return false;
+                }
+                memory.addProject(memoryProject.data());
+            }
+
+            qInfo("%s", qUtf8Printable(tr("Translation memory contains %1 source strings.").arg(memory.size())));
+        }
+
+        // only identical source strings are collapsed, so that the XliffParser can restore them
+        DuplicateFinder collapsed(DuplicateFinder::Exact);
+
+        if (m_options.collapseDuplicates) {
+            collapsed.find(m_options.sorted ? stringTableProject->sortedKeys() : stringTableProject->keys());
+            qInfo("%s", qUtf8Printable(tr("Collapsing %1 keys with duplicate source strings.").arg(collapsed.duplicateCount())));
+        }
+
+        XliffOptions xo;
+        xo.srcLang = m_options.srcLang;
+        xo.version2 = m_options.xliffVersion2;
+        xo.since = sinceProject.data();
+        xo.sorted = m_options.sorted;
+        xo.memory = m_options.fuzzy > 0 ? &memory : nullptr;
+        xo.duplicates = m_options.collapseDuplicates ? &collapsed : nullptr;
+
+        const QStringList trgLangs = m_options.sourceLangOnly ? QStringList() : Languages::supported();
+
+        if (streaming) {
+            XliffStreamConverter converter(m_wd, xo);
+            if (!converter.convert(m_wd.absoluteFilePath(QStringLiteral("stringtable.xml")), trgLangs)) {
+                qCritical("%s", qUtf8Printable(tr("Failed to convert stringtable.xml file. Aborting.")));
+                return false;
+            }
+        } else {
+            FileWriter fw(m_wd, stringTableProject);
+            fw.writeXliff(trgLangs, xo);
+        }
+
+        analyze(stringTableProject);
+
+    } else if (m_options.mode == JobOptions::Extract || m_options.mode == JobOptions::Link || x2s) {
+
+        QString projectName;
+
+        if (stringTableProject) {
+            projectName = stringTableProject->objectName();
+        }
+
+        if (projectName.isEmpty()) {
+            projectName = QStringLiteral("My Project");
+        }
+
+        QScopedPointer<Project> currentProject(new Project(projectName));
+
+        if (x2s) {
+
+            qInfo("%s", qUtf8Printable(tr("Start converting XLIFF files into stringtable.xml.")));
+
+            XliffParser xp(m_wd, currentProject.data(), stringTableProject);
+            xp.parse();
+
+            FileWriter fw(m_wd, currentProject.data());
+            fw.writeStringTable(m_options.backup, m_options.sorted);
+
+            analyze(currentProject.data());
+
+        } else {
+
+            // used key ids are collected over all files and resolved once per unique id
+            ReferenceSet references;
+
+            if (m_options.mode == JobOptions::Link) {
+
+                if (m_options.files.isEmpty()) {
+                    qCritical("%s", qUtf8Printable(tr("No artifact files to link given. Aborting.")));
+                    return false;
+                }
+
+                qInfo("%s", qUtf8Printable(tr("Start linking artifact files.")));
+
+                // artifacts are read line by line, files contained in several artifacts, like shared headers, are only applied
+                // once and have to contain the same data in all of them, otherwise the result would depend on the order
+                Artifact artifact(dirPath);
+                QHash<QString, QPair<QString, QByteArray> > linked;
+                ScriptResult r;
+
+                for (int i = 0; i < m_options.files.size(); ++i) {
+                    qInfo("%s", qUtf8Printable(tr("Linking artifact file: %1").arg(m_options.files.at(i))));
+
+                    if (!artifact.open(m_options.files.at(i))) {
+                        return false;
+                    }
+
+                    while (artifact.next(&r)) {
+                        const QByteArray hash = QCryptographicHash::hash(artifact.encode(r), QCryptographicHash::Sha1);
+                        const QHash<QString, QPair<QString, QByteArray> >::const_iterator it = linked.constFind(r.file);
+                        if (it != linked.constEnd()) {
+                            if (it.value().second == hash) {
+                                continue;
+                            }
+                            qCritical("%s", qUtf8Printable(tr("File %1 has different data in artifact file %2 and in %3. Aborting.").arg(m_wd.relativeFilePath(r.file), it.value().first, m_options.files.at(i))));
+                            return false;
+                        }
+                        linked.insert(r.file, qMakePair(m_options.files.at(i), hash));
+                        ScriptParser sp(r.file, stringTableProject, currentProject.data());
+                        sp.setReferenceSet(&references);
+                        sp.parse(r);
+                        m_filesParsed++;
+                    }
+
+                    if (artifact.hasError()) {
+                        qCritical("%s", qUtf8Printable(tr("Failed to read artifact file. Aborting.")));
+                        return false;
+                    }
+                }
+
+            } else {
+
+                qInfo("%s", qUtf8Printable(tr("Start parsing script files.")));
+
+                FileMatcher matcher;
+                const QStringList patterns = m_options.includes.isEmpty() ? FileMatcher::defaultIncludes() : m_options.includes;
+                for (int i = 0; i < patterns.size(); ++i) {
+                    matcher.addInclude(patterns.at(i));
+                }
+                for (int i = 0; i < m_options.excludes.size(); ++i) {
+                    matcher.addExclude(m_options.excludes.at(i));
+                }
+
+                // directories are listed in parallel while the files are parsed, in the same order on every run
+                FileDiscovery discovery(dirPath, matcher);
+                discovery.start();
+
+                // unchanged files are fetched from the artifact cache, if one has been set
+                QScopedPointer<ArtifactCache> artifacts(createCache());
+
+                // every file, also when included by several others, is parsed only once
+                IncludeCache includes(dirPath);
+                includes.setArtifactCache(artifacts.data());
+
+                QString fp;
+                FileMatcher::Kind kind = FileMatcher::None;
+                while (!(fp = discovery.next(&kind)).isNull()) {
+                    QString fn = fp;
+                    fn.remove(dirPath);
+                    fn.remove(0, 1);
+                    qInfo("%s", qUtf8Printable(tr("Parsing file: %1").arg(fn)));
+                    // config files are scanned by the ConfigScanner, script files by the ScriptParser
+                    includes.result(fp, kind);
+                    ScriptParser sp(fp, stringTableProject, currentProject.data());
+                    sp.setIncludeCache(&includes);
+                    sp.setReferenceSet(&references);
+                    sp.parse();
+                    m_filesParsed++;
+                }
+
+                finishCache(artifacts.data());
+
+            }
+
+            references.resolve(currentProject.data(), stringTableProject, m_findings);
+
+            Project *result = currentProject.data();
+
+            if (stringTableProject) {
+
+                QScopedPointer<Project> ancestorProject;
+
+                if (!m_options.ancestorPath.isEmpty()) {
+                    qInfo("%s", qUtf8Printable(tr("Start parsing ancestor file: %1").arg(m_options.ancestorPath)));
+
+                    StringtableParser ap(m_options.ancestorPath);
+                    ancestorProject.reset(ap.parse());
+
+                    if (!ancestorProject) {
+                        qCritical("%s", qUtf8Printable(tr("Failed to load ancestor file. Aborting.")));
+                        return false;
+                    }
+                }
+
+                qInfo("%s", qUtf8Printable(tr("Start merging extracted strings into stringtable.xml.")));
+
+                StringtableMerger merger(stringTableProject, currentProject.data(), ancestorProject.data());
+                merger.merge();
+
+                result = stringTableProject;
+            }
+
+            FileWriter fw(m_wd, result);
+            fw.writeStringTable(m_options.backup, m_options.sorted);
+
+            analyze(result);
+        }
+
+    } else {
+
+        analyze(stringTableProject);
+
+    }
+
+    return true;
+}
+
+
+
+/*!
+ * \brief Extracts the files given in the options and writes their data into an artifact file.
+ *
+ * The data of all files included by the given files is written into the artifact, too, so that
+ * the artifact can be linked without access to the working directory.
+ *
+ * \since 1.1.0
+ * \return True on success.
+ */
+bool Job::extractFiles()
+{
+    if (m_options.files.isEmpty()) {
+        qCritical("%s", qUtf8Printable(tr("No files to extract given. Aborting.")));
+        return false;
+    }
+
+    if (m_options.artifactPath.isEmpty()) {
+        qCritical("%s", qUtf8Printable(tr("No artifact file to write given. Aborting.")));
+        return false;
+    }
+
+    const QString dirPath = m_wd.absolutePath();
+
+    FileMatcher matcher;
+    const QStringList patterns = m_options.includes.isEmpty() ? FileMatcher::defaultIncludes() : m_options.includes;
+    for (int i = 0; i < patterns.size(); ++i) {
+        matcher.addInclude(patterns.at(i));
+    }
+    matcher.compile();
+
+    QScopedPointer<ArtifactCache> artifacts(createCache());
+
+    IncludeCache includes(dirPath);
+    includes.setArtifactCache(artifacts.data());
+
+    QStringList pending;
+
+    for (int i = 0; i < m_options.files.size(); ++i) {
+        const QString fp = QDir::cleanPath(m_wd.absoluteFilePath(m_options.files.at(i)));
+
+        if (!QFileInfo(fp).isFile()) {
+            qCritical("%s", qUtf8Printable(tr("Can not find file: %1. Aborting.").arg(m_options.files.at(i))));
+            return false;
+        }
+
+        qInfo("%s", qUtf8Printable(tr("Parsing file: %1").arg(m_wd.relativeFilePath(fp))));
+        // files not matching the patterns are routed by their extension
+        includes.result(fp, matcher.match(m_wd.relativeFilePath(fp)));
+        pending.append(fp);
+        m_filesParsed++;
+    }
+
+    QVector<const ScriptResult*> results;
+    QSet<QString> added;
+
+    while (!pending.isEmpty()) {
+        const QString fp = pending.takeFirst();
+
+        if (added.contains(fp)) {
+            continue;
+        }
+        added.insert(fp);
+
+        const ScriptResult *r = includes.result(fp);
+        if (r) {
+            results.append(r);
+            pending.append(r->includes);
+        }
+    }
+
+    finishCache(artifacts.data());
+
+    Artifact artifact(dirPath);
+
+    return artifact.write(m_options.artifactPath, results);
+}
+
+
+
+/*!
+ * \brief Runs the analysis passes requested by the options on \a project and adds the findings to the report.
+ * \since 1.1.0
+ */
+void Job::analyze(const Project *project) const
+{
+    if (!project) {
+        return;
+    }
+
+    if (m_options.duplicates) {
+        DuplicateFinder df;
+        df.find(project->keys());
+        qInfo("%s", qUtf8Printable(tr("Found %1 keys with duplicate source strings.").arg(df.duplicateCount())));
+        df.report(m_findings);
+    }
+
+    if (m_options.validate || m_options.mode == JobOptions::XliffToStringtable) {
+        Validator validator(m_findings);
+        validator.validate(project);
+        qInfo("%s", qUtf8Printable(tr("Found %1 placeholder or tag inconsistencies.").arg(validator.violations())));
+    }
+}
+
+
+
+/*!
+ * \brief Returns a new ArtifactCache for the cache directory set in the options or a null pointer if no cache directory has been set.
+ * \since 1.1.0
+ */
+ArtifactCache *Job::createCache() const
+{
+    if (m_options.cacheDir.isEmpty()) {
+        return nullptr;
+    }
+
+    ArtifactCache *artifacts = new ArtifactCache(m_options.cacheDir, m_wd.absolutePath());
+    artifacts->setMaxSize(qint64(m_options.cacheSize) * 1024 * 1024);
+
+    return artifacts;
+}
+
+
+
+/*!
+ * \brief Prints the cache statistics of \a artifacts and removes the least recently used entries exceeding the cache size.
+ * \since 1.1.0
+ */
+void Job::finishCache(ArtifactCache *artifacts) const
+{
+    if (!artifacts) {
+        return;
+    }
+
+    qInfo("%s", qUtf8Printable(tr("Fetched %1 files from the artifact cache, %2 files had to be parsed.").arg(artifacts->hits()).arg(artifacts->misses())));
+
+    // jobs of a batch share the cache directory, it is pruned once after all of them have finished
+    if (!m_options.pruneCache) {
+        return;
+    }
+
+    const int removed = artifacts->prune();
+
+    if (removed > 0) {
+        qInfo("%s", qUtf8Printable(tr("Removed %1 least recently used entries from the artifact cache.").arg(removed)));
+    }
+}
@@ -0,0 +1,103 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef JOB_H
+#define JOB_H
+
+#include <QObject>
+#include <QRunnable>
+#include <QDir>
+#include "a3trans_global.h"
+
+class Report;
+class Project;
+class ArtifactCache;
+
+struct JobOptions
+{
+    enum Mode {
+        None,
+        Extract,
+        ConvertToXliff,
+        XliffToStringtable,
+        ExtractFile,
+        Link
+    };
+
+    Mode mode = None;
+    bool xliffVersion2 = false;
+    QString srcLang = QStringLiteral("en");
+    bool sourceLangOnly = false;
+    bool backup = false;
+    bool sorted = false;
+    QString sincePath;
+    QString ancestorPath;
+    int fuzzy = 0;
+    QStringList memoryPaths;
+    bool duplicates = false;
+    bool collapseDuplicates = false;
+    bool validate = false;
+    QStringList includes;
+    QStringList excludes;
+    QStringList files;
+    QString artifactPath;
+    QString cacheDir;
+    int cacheSize = 512;
+    bool pruneCache = true;
+};
+
+class A3TRANS_EXPORT Job : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    explicit Job(const QString &workingDir, const JobOptions &options, QObject *parent = nullptr);
+
+    void run() override;
+
+    void setReport(Report *report);
+
+    void setStringTable(Project *stringTable);
+
+    QString workingDir() const;
+
+    bool succeeded() const;
+
+    int filesParsed() const;
+
+    qint64 elapsed() const;
+
+private:
+    Q_DISABLE_COPY(Job)
+
+    QDir m_wd;
+    JobOptions m_options;
+    bool m_succeeded;
+    int m_filesParsed;
+    qint64 m_elapsed;
+    Report *m_report;
+    Report *m_findings;
+    Project *m_stringTable;
+
+    bool process();
+    bool extractFiles();
+    void analyze(const Project *project) const;
+    ArtifactCache *createCache() const;
+    void finishCache(ArtifactCache *artifacts) const;
+};
+
+#endif // JOB_H
@@ -18,7 +18,13 @@
 
 #include "key.h"
 #include "translation.h"
+#include "container.h"
+#include "package.h"
+#include "project.h"
+#include "translationmemory.h"
+#include "duplicatefinder.h"
 #include <QDomElement>
+#include <QUrl>
 #ifdef QT_DEBUG
 #include <QDebug>
 #endif
@@ -30,6 +36,11 @@
  *
  * The key class is an object representation of the stringtable XML key node.
  *
+ * A key can share the translations of another key via shareTranslations(), instead of holding
+ * own copies of them. Translations of the key itself take precedence over the shared ones.
+ * Sharing is copy-on-write: as soon as the translations of one of the keys are changed or the
+ * source key is deleted, the shared translations are copied into the sharing keys.
+ *
  * \since 1.0.0
  * \version 1.0.0
  * \date 2016-09-05
@@ -45,7 +56,7 @@
  * \param id        The id of the key. Can be returned by objectName().
  * \param parent    The parent object.
  */
-Key::Key(const QString &id, QObject *parent) : QObject(parent)
+Key::Key(const QString &id, QObject *parent) : QObject(parent), m_shared(nullptr)
 {
     setObjectName(id);
 
@@ -56,6 +67,20 @@ Key::Key(const QString &id, QObject *parent) : QObject(parent)
 
 
 
+/*!
+ * \brief Deconstructs the key, keys sharing its translations get own copies of them.
+ */
+Key::~Key()
+{
+    detachSharers();
+
+    if (m_shared) {
+        m_shared->m_sharers.removeAll(QPointer<Key>(this));
+    }
+}
+
+
+
 
 
 
@@ -71,6 +96,9 @@ Key::Key(const QString &id, QObject *parent) : QObject(parent)
  */
 void Key::setTranslation(const QString &lang, const QString &string)
 {
+    detach();
+    detachSharers();
+
     Translation *t = findChild<Translation *>(lang, Qt::FindDirectChildrenOnly);
 
     if (t && !string.isEmpty()) {
@@ -89,13 +117,24 @@ void Key::setTranslation(const QString &lang, const QString &string)
 
 /*!
  * \brief Returns a pointer to the translation identified by language.
+ *
+ * The translation might be shared with other keys, use setTranslation() to change it. A shared
+ * translation is owned by the key that shares it with this key, so its parent() is not necessarily
+ * this key, and it can be copied or deleted as soon as one of the keys is changed.
+ *
  * \since 1.0.0
  * \param lang  The language for the translation.
  * \return      Pointer to a Translation object.
  */
 Translation *Key::getTranslation(const QString &lang) const
 {
-    return findChild<Translation *>(lang, Qt::FindDirectChildrenOnly);
+    Translation *t = findChild<Translation *>(lang, Qt::FindDirectChildrenOnly);
+
+    if (!t && m_shared) {
+        t = m_shared->getTranslation(lang);
+    }
+
+    return t;
 }
 
 
@@ -105,12 +144,140 @@ Translation *Key::getTranslation(const QString &lang) const
 
 /*!
  * \brief Returns a list of all translations associated with tis key.
+ *
+ * Like for getTranslation(), shared translations are owned by the key that shares them with this key.
+ * The pointers are only valid until this key or the sharing key is changed, so callers that change
+ * one of them while iterating over the list have to copy the language names or strings first.
+ *
  * \since 1.0.0
  * \return      List of pointers to Translations.
  */
 QList<Translation *> Key::getAllTranslations() const
 {
-    return findChildren<Translation *>(QString(), Qt::FindDirectChildrenOnly);
+    QList<Translation *> ts = findChildren<Translation *>(QString(), Qt::FindDirectChildrenOnly);
+
+    if (m_shared) {
+        const QList<Translation *> shared = m_shared->getAllTranslations();
+        for (int i = 0; i < shared.size(); ++i) {
+            if (!findChild<Translation *>(shared.at(i)->objectName(), Qt::FindDirectChildrenOnly)) {
+                ts.append(shared.at(i));
+            }
+        }
+    }
+
+    return ts;
+}
+
+
+
+
+/*!
+ * \brief Shares the translations of the \a source key with this key.
+ *
+ * Languages this key has own translations for are not affected. Instead of copying the
+ * translations, this key refers to the translation objects of the \a source key until
+ * one of the keys is changed or deleted.
+ *
+ * \since 1.1.0
+ */
+void Key::shareTranslations(Key *source)
+{
+    while (source && source->m_shared) {
+        source = source->m_shared;
+    }
+
+    if (!source || source == this || source == m_shared) {
+        return;
+    }
+
+    detach();
+    detachSharers();
+
+    m_shared = source;
+    source->m_sharers.append(QPointer<Key>(this));
+}
+
+
+
+
+/*!
+ * \brief Returns true if this key refers to the translations of another key.
+ * \since 1.1.0
+ */
+bool Key::isShared() const
+{
+    return m_shared != nullptr;
+}
+
+
+
+
+/*!
+ * \brief Returns the raw XML of this key that is not represented by Translation objects.
+ *
+ * Contains unknown attributes, comments and the unknown elements around the Key element and
+ * after its language elements, so that the StringtableWriter can write them back.
+ *
+ * \since 1.1.0
+ */
+PassThrough &Key::passThrough()
+{
+    return m_passThrough;
+}
+
+
+
+
+/*!
+ * \brief Returns the raw XML of this key that is not represented by Translation objects.
+ * \since 1.1.0
+ */
+const PassThrough &Key::passThrough() const
+{
+    return m_passThrough;
+}
+
+
+
+
+/*!
+ * \brief Copies the shared translations into this key and stops sharing them.
+ * \since 1.1.0
+ */
+void Key::detach()
+{
+    if (!m_shared) {
+        return;
+    }
+
+    Key *source = m_shared;
+    m_shared = nullptr;
+    source->m_sharers.removeAll(QPointer<Key>(this));
+
+    const QList<Translation *> ts = source->getAllTranslations();
+
+    for (int i = 0; i < ts.size(); ++i) {
+        if (!findChild<Translation *>(ts.at(i)->objectName(), Qt::FindDirectChildrenOnly)) {
+            new Translation(ts.at(i)->objectName(), ts.at(i)->string(), this);
+        }
+    }
+}
+
+
+
+
+/*!
+ * \brief Detaches all keys that share the translations of this key.
+ * \since 1.1.0
+ */
+void Key::detachSharers()
+{
+    while (!m_sharers.isEmpty()) {
+        QPointer<Key> k = m_sharers.takeLast();
+        if (k) {
+            k->detach();
+        }
+    }
 }
 
 
@@ -122,6 +289,7 @@ QList<Translation *> Key::getAllTranslations() const
  * \brief Converts this object into an XML entity.
  *
  * When converting to XML, all children will be converted to XML too and will be child nodes of this node.
+ * The raw markup kept in passThrough() is not part of the document, it is only written by the StringtableWriter.
  *
  * \since 1.0.0
  * \return XML document
@@ -158,13 +326,23 @@ QDomDocument Key::toXml() const
  *
  * When converting to XLIFF, all children will be converted to XLIFF too and will be child nodes of this node.
  *
+ * If \a since is not a null pointer, an empty document will be returned if the original string
+ * of this key and of its duplicates equals the original string of the same keys in the \a since
+ * project. Otherwise the unit will be marked as changed, or as new if none of the keys exists in
+ * the \a since project.
+ *
  * \since 1.0.0
  *
  * \param lang          The target language of the XLIFF document.
  * \param version2      Set to true if the output should be XLIFF 2.0 compatible.
+ * \param since         Baseline project for delta exports, see Project::toXliff().
+ * \param memory        Translation memory for untranslated keys. For XLIFF 1.2 the match is added
+ *                      to the unit, for XLIFF 2.0 it has to be added to the unit by the container.
+ * \param duplicates    If this key is the representative of a group of duplicates, the paths of the
+ *                      other keys of the group are added to the unit, see Project::toXliff().
  * \return              XML document
  */
-QDomDocument Key::toXliff(const QString &lang, bool version2) const
+QDomDocument Key::toXliff(const QString &lang, bool version2, const Project *since, const TranslationMemory *memory, const DuplicateFinder *duplicates) const
 {
     QDomDocument xml;
 
@@ -174,6 +352,50 @@ QDomDocument Key::toXliff(const QString &lang, bool version2) const
         return xml;
     }
 
+    // the unit of a group of duplicates stands for all keys of the group
+    const QVector<Key*> dups = duplicates ? duplicates->duplicatesOf(this) : QVector<Key*>();
+
+    bool added = false;
+
+    if (since) {
+        QVector<const Key*> group(1, this);
+        for (int i = 0; i < dups.size(); ++i) {
+            group.append(dups.at(i));
+        }
+
+        bool changed = false;
+        added = true;
+
+        for (int i = 0; i < group.size(); ++i) {
+            const QObject *c = group.at(i)->parent();
+            const QObject *p = c ? c->parent() : nullptr;
+
+            Translation *baseline = nullptr;
+
+            if (c && p) {
+                const QList<Translation*> bts = since->getAllTranslations(p->objectName(), c->objectName(), group.at(i)->objectName());
+                for (int j = 0; j < bts.size(); ++j) {
+                    if (bts.at(j)->objectName() == QLatin1String("Original")) {
+                        baseline = bts.at(j);
+                        break;
+                    }
+                }
+            }
+
+            if (baseline) {
+                added = false;
+            }
+
+            if (!baseline || baseline->string() != o->string()) {
+                changed = true;
+            }
+        }
+
+        if (!changed) {
+            return xml;
+        }
+    }
+
     QDomElement e;
 
     if (!version2) {
@@ -188,15 +410,118 @@ QDomDocument Key::toXliff(const QString &lang, bool version2) const
     e.setAttribute(QStringLiteral("id"), id);
     xml.appendChild(e);
 
+    if (!dups.isEmpty()) {
+        // the names are percent encoded, as they can contain slashes and spaces
+        QStringList paths;
+        for (int i = 0; i < dups.size(); ++i) {
+            const QObject *c = dups.at(i)->parent();
+            const QObject *p = c ? c->parent() : nullptr;
+            QStringList parts;
+            parts.append(QString::fromLatin1(QUrl::toPercentEncoding(p ? p->objectName() : QString())));
+            parts.append(QString::fromLatin1(QUrl::toPercentEncoding(c ? c->objectName() : QString())));
+            parts.append(QString::fromLatin1(QUrl::toPercentEncoding(dups.at(i)->objectName())));
+            paths.append(parts.join(QLatin1Char('/')));
+        }
+        e.setAttribute(QStringLiteral("a3t:duplicates"), paths.join(QLatin1Char(' ')));
+    }
+
+    if (since && version2) {
+        e.setAttribute(QStringLiteral("state"), QStringLiteral("initial"));
+        e.setAttribute(QStringLiteral("subState"), added ? QStringLiteral("a3t:new") : QStringLiteral("a3t:changed"));
+    }
+
     e.appendChild(o->toXliff());
 
     if (!lang.isEmpty()) {
         Translation *t = getTranslation(lang);
 
-        if (t) {
-            e.appendChild(t->toXliff());
+        // empty language elements of the stringtable are loaded as empty translations, they are not translated
+        if (t && !t->string().isEmpty()) {
+            QDomDocument target = t->toXliff();
+            if (since && !version2) {
+                target.documentElement().setAttribute(QStringLiteral("state"), QStringLiteral("needs-review-translation"));
+            }
+            e.appendChild(target);
+        } else if (since && !version2) {
+            QDomElement target = xml.createElement(QStringLiteral("target"));
+            target.setAttribute(QStringLiteral("state"), added ? QStringLiteral("new") : QStringLiteral("needs-translation"));
+            e.appendChild(target);
         }
+
+        if (!version2 && memory) {
+            QDomDocument m = toXliffMatch(lang, version2, memory);
+            if (m.hasChildNodes()) {
+                e.appendChild(m);
+            }
+        }
+    }
+
+    return xml;
+}
+
+
+
+
+/*!
+ * \brief Returns the best match from the translation \a memory if this key has no translation into \a lang.
+ *
+ * For XLIFF 1.2, the match is an \c alt-trans element, for XLIFF 2.0 an \c mtc:match element that
+ * refers to the segment of this key. Matches are only proposals for the translators, they are not
+ * imported back into the stringtable. Returns an empty document if there is no match.
+ *
+ * \since 1.1.0
+ *
+ * \param lang          The language name of the translation, like \c German.
+ * \param version2      Set to true if the output should be XLIFF 2.0 compatible.
+ * \param memory        The translation memory to search.
+ * \return              XML document
+ */
+QDomDocument Key::toXliffMatch(const QString &lang, bool version2, const TranslationMemory *memory) const
+{
+    QDomDocument xml;
+
+    Translation *o = getTranslation(QStringLiteral("Original"));
+
+    if (!memory || !o || lang.isEmpty()) {
+        return xml;
     }
 
+    Translation *t = getTranslation(lang);
+
+    if (t && !t->string().isEmpty()) {
+        return xml;
+    }
+
+    TranslationMemory::Match m;
+
+    if (!memory->match(o->string(), lang, &m)) {
+        return xml;
+    }
+
+    QDomElement e;
+
+    if (!version2) {
+        e = xml.createElement(QStringLiteral("alt-trans"));
+        e.setAttribute(QStringLiteral("match-quality"), m.similarity);
+        e.setAttribute(QStringLiteral("origin"), QStringLiteral("a3trans"));
+    } else {
+        QString id = objectName().simplified();
+        id.replace(QChar(' '), QLatin1String("_"));
+        e = xml.createElement(QStringLiteral("mtc:match"));
+        e.setAttribute(QStringLiteral("ref"), QLatin1Char('#') + id);
+        e.setAttribute(QStringLiteral("similarity"), m.similarity);
+        e.setAttribute(QStringLiteral("origin"), QStringLiteral("a3trans"));
+    }
+
+    xml.appendChild(e);
+
+    QDomElement source = xml.createElement(QStringLiteral("source"));
+    source.appendChild(xml.createTextNode(m.source));
+    e.appendChild(source);
+
+    QDomElement target = xml.createElement(QStringLiteral("target"));
+    target.appendChild(xml.createTextNode(m.target));
+    e.appendChild(target);
+
     return xml;
 }
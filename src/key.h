@@ -21,14 +21,21 @@
 
 #include <QObject>
 #include <QDomDocument>
+#include <QPointer>
+#include "passthrough.h"
+#include "a3trans_global.h"
 
 class Translation;
+class Project;
+class TranslationMemory;
+class DuplicateFinder;
 
-class Key : public QObject
+class A3TRANS_EXPORT Key : public QObject
 {
     Q_OBJECT
 public:
     explicit Key(const QString &id, QObject *parent = nullptr);
+    ~Key();
 
     void setTranslation(const QString &lang, const QString &string = QString());
 
@@ -36,12 +43,29 @@ public:
 
     QList<Translation *> getAllTranslations() const;
 
+    void shareTranslations(Key *source);
+
+    bool isShared() const;
+
+    PassThrough &passThrough();
+
+    const PassThrough &passThrough() const;
+
     QDomDocument toXml() const;
 
-    QDomDocument toXliff(const QString &lang, bool version2 = false) const;
+    QDomDocument toXliff(const QString &lang, bool version2 = false, const Project *since = nullptr, const TranslationMemory *memory = nullptr, const DuplicateFinder *duplicates = nullptr) const;
+
+    QDomDocument toXliffMatch(const QString &lang, bool version2, const TranslationMemory *memory) const;
 
 private:
     Q_DISABLE_COPY(Key)
+
+    Key *m_shared;
+    QList<QPointer<Key> > m_sharers;
+    PassThrough m_passThrough;
+
+    void detach();
+    void detachSharers();
 };
 
 #endif // KEY_H
@@ -0,0 +1,246 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "keyindex.h"
+#include "project.h"
+#include "package.h"
+#include "container.h"
+#include "key.h"
+#include <algorithm>
+
+
+
+/*!
+ * \class KeyIndex
+ * \brief Case insensitive lookup table for the keys of a Project.
+ *
+ * Key ids are case insensitive in the game, so the index maps the case folded id to the Key object.
+ * If a project contains the same id in several containers, the first one in document order is used.
+ *
+ * For completion and range queries, the ids are additionally kept in a sorted array, that is sorted
+ * on the first query after keys have been added. It supports enumerating all keys with a prefix,
+ * like \c STR_MOD_UI_, finding the key that is the longest prefix of an id and iterating the keys in
+ * id order, all without a linear scan over the keys.
+ *
+ * The index does not track changes of the project, it has to be rebuilt or updated via insert()
+ * if keys are added later. It is not thread-safe.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new KeyIndex object containing the keys of \a project.
+ * \since 1.1.0
+ */
+KeyIndex::KeyIndex(const Project *project) : m_isSorted(true)
+{
+    if (project) {
+        build(project);
+    }
+}
+
+
+
+/*!
+ * \brief Clears the index and adds all keys of \a project.
+ * \since 1.1.0
+ */
+void KeyIndex::build(const Project *project)
+{
+    m_keys.clear();
+    m_sorted.clear();
+    m_isSorted = true;
+
+    if (!project) {
+        return;
+    }
+
+    const QList<Package*> packages = project->findChildren<Package*>(QString(), Qt::FindDirectChildrenOnly);
+
+    for (int i = 0; i < packages.size(); ++i) {
+        const QList<Container*> containers = packages.at(i)->findChildren<Container*>(QString(), Qt::FindDirectChildrenOnly);
+        for (int j = 0; j < containers.size(); ++j) {
+            const QList<Key*> keys = containers.at(j)->findChildren<Key*>(QString(), Qt::FindDirectChildrenOnly);
+            for (int k = 0; k < keys.size(); ++k) {
+                insert(keys.at(k));
+            }
+        }
+    }
+}
+
+
+
+/*!
+ * \brief Adds \a key to the index, if no key with the same id is already part of it.
+ * \since 1.1.0
+ */
+void KeyIndex::insert(Key *key)
+{
+    const QString id = normalize(key->objectName());
+
+    if (!m_keys.contains(id)) {
+        m_keys.insert(id, key);
+        m_sorted.append(qMakePair(id, key));
+        m_isSorted = false;
+    }
+}
+
+
+
+/*!
+ * \brief Returns the key with the case insensitive \a id or a null pointer if it is not part of the index.
+ * \since 1.1.0
+ */
+Key *KeyIndex::find(const QString &id) const
+{
+    return m_keys.value(normalize(id), nullptr);
+}
+
+
+
+/*!
+ * \brief Returns the keys whose ids start with the case insensitive \a prefix, ordered by id.
+ *
+ * If \a limit is greater than 0, at most \a limit keys are returned.
+ *
+ * \since 1.1.0
+ */
+QVector<Key*> KeyIndex::withPrefix(const QString &prefix, int limit) const
+{
+    sort();
+
+    const QString p = normalize(prefix);
+
+    QVector<Key*> ks;
+
+    QVector<Entry>::const_iterator it = std::lower_bound(m_sorted.constBegin(), m_sorted.constEnd(), p, [](const Entry &e, const QString &v) { return e.first < v; });
+
+    while (it != m_sorted.constEnd() && it->first.startsWith(p) && (limit <= 0 || ks.size() < limit)) {
+        ks.append(it->second);
+        ++it;
+    }
+
+    return ks;
+}
+
+
+
+/*!
+ * \brief Returns the key whose id is the longest case insensitive prefix of \a id or a null pointer if there is none.
+ *
+ * If a key with \a id exists, it is returned.
+ *
+ * \since 1.1.0
+ */
+Key *KeyIndex::longestPrefix(const QString &id) const
+{
+    sort();
+
+    QString s = normalize(id);
+
+    while (!s.isEmpty()) {
+
+        // the greatest id not greater than s is either a prefix of s or shares the longest prefix with it
+        QVector<Entry>::const_iterator it = std::upper_bound(m_sorted.constBegin(), m_sorted.constEnd(), s, [](const QString &v, const Entry &e) { return v < e.first; });
+
+        if (it == m_sorted.constBegin()) {
+            return nullptr;
+        }
+
+        --it;
+
+        if (s.startsWith(it->first)) {
+            return it->second;
+        }
+
+        int common = 0;
+        const int max = qMin(s.size(), it->first.size());
+        while (common < max && s.at(common) == it->first.at(common)) {
+            common++;
+        }
+
+        s.truncate(common);
+    }
+
+    return nullptr;
+}
+
+
+
+/*!
+ * \brief Returns all keys of the index ordered by their case folded id.
+ * \since 1.1.0
+ */
+QVector<Key*> KeyIndex::sorted() const
+{
+    sort();
+
+    QVector<Key*> ks;
+    ks.reserve(m_sorted.size());
+
+    for (int i = 0; i < m_sorted.size(); ++i) {
+        ks.append(m_sorted.at(i).second);
+    }
+
+    return ks;
+}
+
+
+
+/*!
+ * \brief Returns the number of unique key ids in the index.
+ * \since 1.1.0
+ */
+int KeyIndex::size() const
+{
+    return m_keys.size();
+}
+
+
+
+/*!
+ * \brief Returns the case folded form of \a id used for lookups.
+ * \since 1.1.0
+ */
+QString KeyIndex::normalize(const QString &id)
+{
+    return id.toCaseFolded();
+}
+
+
+
+/*!
+ * \brief Sorts the array of ids if keys have been added since the last query.
+ * \since 1.1.0
+ */
+void KeyIndex::sort() const
+{
+    if (m_isSorted) {
+        return;
+    }
+
+    std::sort(m_sorted.begin(), m_sorted.end(), [](const Entry &a, const Entry &b) { return a.first < b.first; });
+
+    m_isSorted = true;
+}
@@ -0,0 +1,62 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KEYINDEX_H
+#define KEYINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <QPair>
+#include "a3trans_global.h"
+
+class Project;
+class Key;
+
+class A3TRANS_EXPORT KeyIndex
+{
+public:
+    explicit KeyIndex(const Project *project = nullptr);
+
+    void build(const Project *project);
+
+    void insert(Key *key);
+
+    Key *find(const QString &id) const;
+
+    QVector<Key*> withPrefix(const QString &prefix, int limit = 0) const;
+
+    Key *longestPrefix(const QString &id) const;
+
+    QVector<Key*> sorted() const;
+
+    int size() const;
+
+    static QString normalize(const QString &id);
+
+private:
+    typedef QPair<QString, Key*> Entry;
+
+    QHash<QString, Key*> m_keys;
+    mutable QVector<Entry> m_sorted;
+    mutable bool m_isSorted;
+
+    void sort() const;
+};
+
+#endif // KEYINDEX_H
@@ -0,0 +1,73 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "languages.h"
+#include <QHash>
+
+
+
+/*!
+ * \class Languages
+ * \brief Provides the table of languages supported by ArmA 3.
+ *
+ * The table is initialized only once per process and can be shared between threads.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Returns the list of supported ISO 639-1 language codes.
+ * \since 1.1.0
+ */
+const QStringList &Languages::supported()
+{
+    static const QStringList langs({QStringLiteral("en"), QStringLiteral("cz"), QStringLiteral("fr"), QStringLiteral("es"), QStringLiteral("it"), QStringLiteral("pl"), QStringLiteral("pt"), QStringLiteral("ru"), QStringLiteral("de"), QStringLiteral("ko"), QStringLiteral("ja")});
+    return langs;
+}
+
+
+
+/*!
+ * \brief Returns the language name used by ArmA that is associated to the ISO 639-1 code.
+ * \since 1.1.0
+ * \param code  ISO 639-1 language code.
+ * \return      ArmA language name or a null string if the code is not supported.
+ */
+QString Languages::codeToString(const QString &code)
+{
+    static const QHash<QString, QString> names({
+                                                   {QStringLiteral("en"), QStringLiteral("English")},
+                                                   {QStringLiteral("cz"), QStringLiteral("Czech")},
+                                                   {QStringLiteral("fr"), QStringLiteral("French")},
+                                                   {QStringLiteral("es"), QStringLiteral("Spanish")},
+                                                   {QStringLiteral("it"), QStringLiteral("Italian")},
+                                                   {QStringLiteral("pl"), QStringLiteral("Polish")},
+                                                   {QStringLiteral("pt"), QStringLiteral("Portuguese")},
+                                                   {QStringLiteral("ru"), QStringLiteral("Russian")},
+                                                   {QStringLiteral("de"), QStringLiteral("German")},
+                                                   {QStringLiteral("ko"), QStringLiteral("Korean")},
+                                                   {QStringLiteral("ja"), QStringLiteral("Japanese")}
+                                               });
+    return names.value(code.toLower());
+}
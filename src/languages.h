@@ -0,0 +1,36 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LANGUAGES_H
+#define LANGUAGES_H
+
+#include <QStringList>
+#include "a3trans_global.h"
+
+class A3TRANS_EXPORT Languages
+{
+public:
+    static const QStringList &supported();
+
+    static QString codeToString(const QString &code);
+
+private:
+    Languages() {}
+};
+
+#endif // LANGUAGES_H
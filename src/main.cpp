@@ -21,14 +21,19 @@
 #include <QCommandLineOption>
 #include <QDir>
 #include <QStringList>
-#include <QDirIterator>
 #include <QFile>
-
-#include "scriptparser.h"
-#include "stringtableparser.h"
-#include "project.h"
-#include "filewriter.h"
-#include "xliffparser.h"
+#include <QFileInfo>
+#include <QTextStream>
+#include <QThreadPool>
+
+#include "job.h"
+#include "languages.h"
+#include "report.h"
+#include "workspace.h"
+#include "server.h"
+#include "keyindex.h"
+#include "artifactcache.h"
+#include "key.h"
 
 int main(int argc, char *argv[])
 {
@@ -36,7 +41,7 @@ int main(int argc, char *argv[])
     a.setApplicationName(QStringLiteral("a3trans"));
     a.setOrganizationDomain(QStringLiteral("buschmann23.de"));
     a.setOrganizationName(QStringLiteral("Buschtrommel"));
-    a.setApplicationVersion(QStringLiteral("0.0.1"));
+    a.setApplicationVersion(QStringLiteral(A3TRANS_VERSION));
 
     QString desc(QCoreApplication::translate("main", "a3trans is a translation string extractor for ArmA 3 script files."));
     desc.append(QLatin1String("\n"));
@@ -44,28 +49,35 @@ int main(int argc, char *argv[])
     desc.append(QCoreApplication::translate("main","This program is distributed in the hope that it will be useful,\nbut WITHOUT ANY WARRANTY; without even the implied warranty of\nMERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the\nGNU General Public License for more details."));
     desc.append(QLatin1String("\nhttp://www.gnu.org/licenses/gpl-3.0.html"));
 
-    QString dirPath = QDir::currentPath();
-    QString projectName;
-    QString srcLng = QStringLiteral("en");
-    QStringList supportedLangs({QStringLiteral("en"), QStringLiteral("cz"), QStringLiteral("fr"), QStringLiteral("es"), QStringLiteral("it"), QStringLiteral("pl"), QStringLiteral("pt"), QStringLiteral("ru"), QStringLiteral("de"), QStringLiteral("ko"), QStringLiteral("ja")});
-    int convertToXliff = 0;
-    bool createBackup = false;
-    bool sourceLangOnly = false;
-    bool x2s = false;
-    bool extract = false;
+    QStringList dirPaths;
+    JobOptions options;
+    int maxJobs = 0;
+    Report report;
+    QString reportPath;
 
     QCommandLineParser clparser;
     clparser.setApplicationDescription(desc);
     clparser.addHelpOption();
     clparser.addVersionOption();
 
+    clparser.addPositionalArgument(QStringLiteral("command"), QCoreApplication::translate("main", "Optional command. extract-file extracts the given script and config files, and the files included by them, into the artifact file set by --output. link merges the strings of the given artifact files into the stringtable.xml file of the working directory, like --extract does for the script files."), QStringLiteral("[extract-file|link] [files...]"));
+
     QCommandLineOption extractOption(QStringList() << QStringLiteral("e") << QStringLiteral("extract"), QCoreApplication::translate("main", "Start extracting translation strings from script files found in the workin directory an the subdirectories."));
     clparser.addOption(extractOption);
 
-    QCommandLineOption directoryOption(QStringList() << QStringLiteral("d") << QStringLiteral("directory"), QCoreApplication::translate("main", "Sets the working directory. If omitted, the current directoy will be used."));
+    QCommandLineOption outputOption(QStringList() << QStringLiteral("o") << QStringLiteral("output"), QCoreApplication::translate("main", "Sets the artifact file written by the extract-file command."), QStringLiteral("file"));
+    clparser.addOption(outputOption);
+
+    QCommandLineOption directoryOption(QStringList() << QStringLiteral("d") << QStringLiteral("directory"), QCoreApplication::translate("main", "Sets the working directory. If omitted, the current directoy will be used. Can be given multiple times to process several working directories in one run."), QStringLiteral("directory"));
     clparser.addOption(directoryOption);
 
-    QCommandLineOption srcLngOption(QStringList() << QStringLiteral("s") << QStringLiteral("sourceLang"), QCoreApplication::translate("main", "Sets the source language by ISO 639-1 code. Default: en. Supported languages: English (en), Czech (cz), French (fr), Spanish (es), Italian (it), Polish (pl), Portuguese (pt), Russian (ru), German (de), Korean (ko), Japanese (ja)"));
+    QCommandLineOption batchOption(QStringList() << QStringLiteral("batch"), QCoreApplication::translate("main", "Reads the working directories to process from the given manifest file. The manifest contains one directory per line, relative paths are resolved against the directory of the manifest. Empty lines and lines starting with # are ignored."), QStringLiteral("manifest"));
+    clparser.addOption(batchOption);
+
+    QCommandLineOption jobsOption(QStringList() << QStringLiteral("j") << QStringLiteral("jobs"), QCoreApplication::translate("main", "Sets the maximum number of working directories that are processed in parallel. Default: number of CPU cores."), QStringLiteral("number"));
+    clparser.addOption(jobsOption);
+
+    QCommandLineOption srcLngOption(QStringList() << QStringLiteral("s") << QStringLiteral("sourceLang"), QCoreApplication::translate("main", "Sets the source language by ISO 639-1 code. Default: en. Supported languages: English (en), Czech (cz), French (fr), Spanish (es), Italian (it), Polish (pl), Portuguese (pt), Russian (ru), German (de), Korean (ko), Japanese (ja)"), QStringLiteral("lang"));
     clparser.addOption(srcLngOption);
 
     QCommandLineOption backupOption(QStringList() << QStringLiteral("b") << QStringLiteral("backup"), QCoreApplication::translate("main", "Create a backup of the stringtable.xml file before writing the new file."));
@@ -83,110 +95,283 @@ int main(int argc, char *argv[])
     QCommandLineOption xliff2xmlOption(QStringList() << QStringLiteral("x2s") << QStringLiteral("xliff2stringtable"), QCoreApplication::translate("main", "Converts language specific XLIFF files into a single stringtable.xml file. Expects the XLIFF file to be in a l10n subdirectory of the working directory."));
     clparser.addOption(xliff2xmlOption);
 
+    QCommandLineOption sinceOption(QStringList() << QStringLiteral("since"), QCoreApplication::translate("main", "When converting to XLIFF, only export strings that have been added or changed compared to the given baseline stringtable.xml file."), QStringLiteral("baseline"));
+    clparser.addOption(sinceOption);
+
+    QCommandLineOption ancestorOption(QStringList() << QStringLiteral("ancestor"), QCoreApplication::translate("main", "When extracting, performs a three-way merge of the extracted strings and the current stringtable.xml file, using the given stringtable.xml file as common ancestor."), QStringLiteral("file"));
+    clparser.addOption(ancestorOption);
+
+    QCommandLineOption fuzzyOption(QStringList() << QStringLiteral("fuzzy"), QCoreApplication::translate("main", "When converting to XLIFF, proposes the translation of the most similar translated string for untranslated strings, if the similarity in percent is at least the given threshold. The proposals are written as alternative translations that have to be reviewed."), QStringLiteral("threshold"));
+    clparser.addOption(fuzzyOption);
+
+    QCommandLineOption memoryOption(QStringList() << QStringLiteral("memory"), QCoreApplication::translate("main", "Adds the translations of the given stringtable.xml file to the translation memory used by --fuzzy. Can be given multiple times."), QStringLiteral("file"));
+    clparser.addOption(memoryOption);
+
+    QCommandLineOption duplicatesOption(QStringList() << QStringLiteral("duplicates"), QCoreApplication::translate("main", "Reports keys whose source strings only differ in white space and case."));
+    clparser.addOption(duplicatesOption);
+
+    QCommandLineOption collapseOption(QStringList() << QStringLiteral("collapse-duplicates"), QCoreApplication::translate("main", "When converting to XLIFF, exports keys with identical source strings as a single unit. The translation will be copied to all keys when converting the XLIFF files back."));
+    clparser.addOption(collapseOption);
+
+    QCommandLineOption validateOption(QStringList() << QStringLiteral("validate"), QCoreApplication::translate("main", "Reports translations whose placeholders (%1, %2, ...) or structured text tags differ from the original string. Always enabled when converting XLIFF files into the stringtable.xml file."));
+    clparser.addOption(validateOption);
+
+    QCommandLineOption includeOption(QStringList() << QStringLiteral("i") << QStringLiteral("include"), QCoreApplication::translate("main", "Adds a wildcard pattern for files to extract strings from. Matching is case insensitive, patterns containing a slash are matched against the path relative to the working directory. Prefix the pattern with script: or config: to select the scanner. Can be given multiple times. Default: *.sqf, *.inc, description.ext, mission.sqm, config.cpp, *.hpp, *.h"), QStringLiteral("pattern"));
+    clparser.addOption(includeOption);
+
+    QCommandLineOption excludeOption(QStringList() << QStringLiteral("x") << QStringLiteral("exclude"), QCoreApplication::translate("main", "Adds a wildcard pattern for files and directories to skip when extracting. Patterns ending with a slash only match directories. Can be given multiple times."), QStringLiteral("pattern"));
+    clparser.addOption(excludeOption);
+
+    QCommandLineOption cacheDirOption(QStringList() << QStringLiteral("cache-dir"), QCoreApplication::translate("main", "When extracting, fetches the strings of unchanged files from the given cache directory instead of parsing them, and stores the strings of parsed files in it. The directory can be shared between machines."), QStringLiteral("directory"));
+    clparser.addOption(cacheDirOption);
+
+    QCommandLineOption cacheSizeOption(QStringList() << QStringLiteral("cache-size"), QCoreApplication::translate("main", "Sets the maximum size of the cache directory in MiB, 0 for no limit. The least recently used entries are removed if the cache grows larger. Default: 512"), QStringLiteral("size"));
+    clparser.addOption(cacheSizeOption);
+
+    QCommandLineOption sortOption(QStringList() << QStringLiteral("sort"), QCoreApplication::translate("main", "Writes packages, containers and keys sorted by name instead of in the order they have been found, so that the output does not depend on the file system order."));
+    clparser.addOption(sortOption);
+
+    QCommandLineOption reportOption(QStringList() << QStringLiteral("report"), QCoreApplication::translate("main", "Writes the report of the findings, like IDs without localization, to the given file instead of stderr."), QStringLiteral("file"));
+    clparser.addOption(reportOption);
+
+    QCommandLineOption reportFormatOption(QStringList() << QStringLiteral("report-format"), QCoreApplication::translate("main", "Sets the format of the report. Supported formats: text, json, sarif. Default: text"), QStringLiteral("format"));
+    clparser.addOption(reportFormatOption);
+
+    QCommandLineOption maxDiagnosticsOption(QStringList() << QStringLiteral("max-diagnostics"), QCoreApplication::translate("main", "Sets the maximum number of occurrences written to the report. Default: 0 (no limit)"), QStringLiteral("number"));
+    clparser.addOption(maxDiagnosticsOption);
+
+    QCommandLineOption listKeysOption(QStringList() << QStringLiteral("list-keys"), QCoreApplication::translate("main", "Prints the IDs of the stringtable.xml file in the working directory that start with the given prefix, ordered by ID. Use an empty prefix to print all IDs."), QStringLiteral("prefix"));
+    clparser.addOption(listKeysOption);
+
+    QCommandLineOption serveOption(QStringList() << QStringLiteral("serve"), QCoreApplication::translate("main", "Starts a JSON-RPC server for editor integrations that keeps the stringtable.xml file of the working directory in memory. Requests and responses are exchanged one per line on stdin and stdout."));
+    clparser.addOption(serveOption);
+
+    QCommandLineOption socketOption(QStringList() << QStringLiteral("socket"), QCoreApplication::translate("main", "When serving, listens on the given local socket instead of using stdin and stdout."), QStringLiteral("name"));
+    clparser.addOption(socketOption);
+
     clparser.process(a);
 
     if (argc > 1) {
 
-        if (clparser.isSet(directoryOption)) {
-            dirPath = clparser.value(directoryOption);
+        dirPaths = clparser.values(directoryOption);
+
+        if (clparser.isSet(batchOption)) {
+            QFile manifest(clparser.value(batchOption));
+            if (!manifest.open(QIODevice::ReadOnly|QIODevice::Text)) {
+                qCritical("%s", qUtf8Printable(QCoreApplication::translate("main", "Failed to open manifest file: %1").arg(manifest.fileName())));
+                return 1;
+            }
+            const QDir manifestDir = QFileInfo(manifest).absoluteDir();
+            QTextStream in(&manifest);
+            in.setCodec("UTF-8");
+            while (!in.atEnd()) {
+                const QString line = in.readLine().trimmed();
+                if (!line.isEmpty() && !line.startsWith(QLatin1Char('#'))) {
+                    dirPaths.append(manifestDir.absoluteFilePath(line));
+                }
+            }
+        }
+
+        if (clparser.isSet(jobsOption)) {
+            maxJobs = clparser.value(jobsOption).toInt();
         }
 
         if (clparser.isSet(srcLngOption)) {
             QString lng = clparser.value(srcLngOption);
-            if (supportedLangs.contains(lng)) {
-                srcLng = lng;
+            if (Languages::supported().contains(lng)) {
+                options.srcLang = lng;
             } else {
                 qDebug("%s",qUtf8Printable(QCoreApplication::translate("main", "The language code %1 is not supported. Using default language English.").arg(lng)));
             }
         }
 
         if (clparser.isSet(xliffOption)) {
-            convertToXliff = 1;
+            options.mode = JobOptions::ConvertToXliff;
         } else if (clparser.isSet(xliff2Option)) {
-            convertToXliff = 2;
+            options.mode = JobOptions::ConvertToXliff;
+            options.xliffVersion2 = true;
+        } else if (clparser.isSet(xliff2xmlOption)) {
+            options.mode = JobOptions::XliffToStringtable;
+        } else if (clparser.isSet(extractOption)) {
+            options.mode = JobOptions::Extract;
         }
 
-        createBackup = clparser.isSet(backupOption);
+        const QStringList args = clparser.positionalArguments();
 
-        sourceLangOnly = clparser.isSet(srcLngOnlyOption);
+        if (!args.isEmpty()) {
+            if (args.first() == QLatin1String("extract-file")) {
+                options.mode = JobOptions::ExtractFile;
+            } else if (args.first() == QLatin1String("link")) {
+                options.mode = JobOptions::Link;
+            } else {
+                qCritical("%s", qUtf8Printable(QCoreApplication::translate("main", "Unknown command: %1").arg(args.first())));
+                return 1;
+            }
 
-        x2s = clparser.isSet(xliff2xmlOption);
+            for (int i = 1; i < args.size(); ++i) {
+                options.files.append(QFileInfo(args.at(i)).absoluteFilePath());
+            }
 
-        extract = clparser.isSet(extractOption);
+            if (clparser.isSet(outputOption)) {
+                options.artifactPath = QFileInfo(clparser.value(outputOption)).absoluteFilePath();
+            }
+        }
 
-    } else {
+        options.backup = clparser.isSet(backupOption);
 
-        clparser.showHelp();
+        options.sorted = clparser.isSet(sortOption);
 
-    }
+        options.sourceLangOnly = clparser.isSet(srcLngOnlyOption);
 
-    QDir dir(dirPath);
+        options.sincePath = clparser.value(sinceOption);
 
-    qInfo("%s", qUtf8Printable(QCoreApplication::translate("main", "Working directory: %1").arg(dirPath)));
+        options.ancestorPath = clparser.value(ancestorOption);
 
-    Project *stringTableProject = nullptr;
+        if (clparser.isSet(fuzzyOption)) {
+            options.fuzzy = qBound(0, clparser.value(fuzzyOption).toInt(), 100);
+        }
 
-    if (!x2s) {
+        options.memoryPaths = clparser.values(memoryOption);
 
-        qInfo("%s", qUtf8Printable(QCoreApplication::translate("main", "Start parsing stringtable.xml file.")));
+        options.duplicates = clparser.isSet(duplicatesOption);
 
-        StringtableParser stp(dir.absoluteFilePath(QStringLiteral("stringtable.xml")));
-        stringTableProject = stp.parse();
+        options.collapseDuplicates = clparser.isSet(collapseOption);
 
-    }
+        options.validate = clparser.isSet(validateOption);
 
-    if (convertToXliff > 0) {
+        options.includes = clparser.values(includeOption);
 
-        qInfo("%s", qUtf8Printable(QCoreApplication::translate("main", "Start converting stringtable.xml into XLIFF files.")));
+        options.excludes = clparser.values(excludeOption);
 
-        FileWriter fw(dir, stringTableProject);
+        if (clparser.isSet(cacheDirOption)) {
+            options.cacheDir = QFileInfo(clparser.value(cacheDirOption)).absoluteFilePath();
+        }
 
-        if (sourceLangOnly) {
-            fw.writeXliff(QStringList(), srcLng, convertToXliff > 1);
-        } else {
-            fw.writeXliff(supportedLangs, srcLng, convertToXliff > 1);
+        if (clparser.isSet(cacheSizeOption)) {
+            options.cacheSize = qMax(0, clparser.value(cacheSizeOption).toInt());
         }
 
-    } else if (x2s || extract) {
+        reportPath = clparser.value(reportOption);
 
-        if (projectName.isEmpty() && stringTableProject) {
-            projectName = stringTableProject->objectName();
+        if (clparser.isSet(reportFormatOption)) {
+            bool ok = false;
+            report.setFormat(Report::formatFromString(clparser.value(reportFormatOption), &ok));
+            if (!ok) {
+                qDebug("%s",qUtf8Printable(QCoreApplication::translate("main", "The report format %1 is not supported. Using text format.").arg(clparser.value(reportFormatOption))));
+            }
         }
 
-        if (projectName.isEmpty()) {
-            projectName = QStringLiteral("My Project");
+        if (clparser.isSet(maxDiagnosticsOption)) {
+            report.setMaxDiagnostics(clparser.value(maxDiagnosticsOption).toInt());
         }
 
-        Project *currentProject = new Project(projectName);
+    } else {
 
-        if (x2s) {
+        clparser.showHelp();
 
-            qInfo("%s", qUtf8Printable(QCoreApplication::translate("main", "Start converting XLIFF files into stringtable.xml.")));
+    }
 
-            XliffParser xp(dir, currentProject);
-            xp.parse();
+    if (dirPaths.isEmpty()) {
+        dirPaths.append(QDir::currentPath());
+    }
 
+    if (clparser.isSet(listKeysOption)) {
+        if (dirPaths.size() > 1) {
+            qCritical("%s", qUtf8Printable(QCoreApplication::translate("main", "IDs can only be listed for a single working directory.")));
+            return 1;
+        }
+        Workspace workspace(dirPaths.first());
+        const KeyIndex *index = workspace.keyIndex();
+        if (!index) {
+            qCritical("%s", qUtf8Printable(QCoreApplication::translate("main", "Can not list IDs without a valid stringtable.xml file.")));
+            return 1;
+        }
+        QTextStream out(stdout);
+        out.setCodec("UTF-8");
+        const QVector<Key*> keys = index->withPrefix(clparser.value(listKeysOption));
+        for (int i = 0; i < keys.size(); ++i) {
+            out << keys.at(i)->objectName() << '\n';
+        }
+        return 0;
+    }
 
-        } else if (extract) {
+    if (clparser.isSet(serveOption)) {
+        if (dirPaths.size() > 1) {
+            qCritical("%s", qUtf8Printable(QCoreApplication::translate("main", "The server can only serve a single working directory.")));
+            return 1;
+        }
+        Workspace workspace(dirPaths.first());
+        workspace.setOptions(options);
+        Server server(&workspace);
+        QObject::connect(&server, &Server::finished, &a, &QCoreApplication::quit);
+        if (clparser.isSet(socketOption)) {
+            if (!server.listen(clparser.value(socketOption))) {
+                return 1;
+            }
+        } else {
+            server.serveStdio();
+        }
+        return a.exec();
+    }
 
-            qInfo("%s", qUtf8Printable(QCoreApplication::translate("main", "Start parsing script files.")));
+    if (dirPaths.size() == 1) {
+        Job job(dirPaths.first(), options);
+        job.setReport(&report);
+        job.run();
+        if (!report.isEmpty() || !reportPath.isEmpty()) {
+            report.write(reportPath);
+        }
+        return job.succeeded() ? 0 : 1;
+    }
 
+    QThreadPool pool;
+    if (maxJobs > 0) {
+        pool.setMaxThreadCount(maxJobs);
+    }
 
-            QDirIterator it(dirPath, QStringList() << QStringLiteral("*.sqf") << QStringLiteral("*.SQF") << QStringLiteral("description.ext") << QStringLiteral("mission.sqm"), QDir::Files, QDirIterator::Subdirectories);
-            while (it.hasNext()) {
-                QString fp = it.next();
-                QString fn = fp;
-                fn.remove(dirPath);
-                fn.remove(0, 1);
-                qInfo("%s", qUtf8Printable(QCoreApplication::translate("main", "Parsing file: %1").arg(fn)));
-                ScriptParser sp(fp, stringTableProject, currentProject);
-                sp.parse();
-            }
+    qInfo("%s", qUtf8Printable(QCoreApplication::translate("main", "Processing %1 working directories with up to %2 parallel jobs.").arg(dirPaths.size()).arg(pool.maxThreadCount())));
+
+    // the cache directory is shared by all jobs, so it is pruned once after all of them have finished
+    options.pruneCache = false;
+
+    QList<Job*> jobs;
+    for (int i = 0; i < dirPaths.size(); ++i) {
+        Job *job = new Job(dirPaths.at(i), options, &a);
+        job->setReport(&report);
+        jobs.append(job);
+        pool.start(job);
+    }
+
+    pool.waitForDone();
+
+    if (!options.cacheDir.isEmpty()) {
+        ArtifactCache cache(options.cacheDir, QString());
+        cache.setMaxSize(qint64(options.cacheSize) * 1024 * 1024);
+        const int removed = cache.prune();
+        if (removed > 0) {
+            qInfo("%s", qUtf8Printable(QCoreApplication::translate("main", "Removed %1 least recently used entries from the artifact cache.").arg(removed)));
+        }
+    }
+
+    int failed = 0;
+    int files = 0;
+
+    qInfo("%s", qUtf8Printable(QCoreApplication::translate("main", "Batch report:")));
+
+    for (int i = 0; i < jobs.size(); ++i) {
+        const Job *job = jobs.at(i);
+        if (!job->succeeded()) {
+            failed++;
         }
+        files += job->filesParsed();
+        qInfo("%s", qUtf8Printable(QCoreApplication::translate("main", "  [%1] %2 (%3 files, %4 ms)").arg(job->succeeded() ? QStringLiteral("OK") : QStringLiteral("FAILED"), job->workingDir(), QString::number(job->filesParsed()), QString::number(job->elapsed()))));
+    }
+
+    qInfo("%s", qUtf8Printable(QCoreApplication::translate("main", "%1 of %2 working directories processed successfully, %3 files parsed.").arg(jobs.size() - failed).arg(jobs.size()).arg(files)));
 
-        FileWriter fw(dir, currentProject);
-        fw.writeStringTable(createBackup);
+    if (!report.isEmpty() || !reportPath.isEmpty()) {
+        report.write(reportPath);
     }
 
-    return 0;
+    return failed > 0 ? 1 : 0;
 }
@@ -18,6 +18,7 @@
 
 #include "package.h"
 #include "container.h"
+#include "key.h"
 #include "translation.h"
 #ifdef QT_DEBUG
 #include <QDebug>
@@ -143,11 +144,27 @@ QList<Translation *> Package::getAllTranslations(const QString &container, const
  */
 QDomDocument Package::toXml() const
 {
-    QDomDocument xml;
+    return toXml(keys());
+}
+
+
+
 
-    QList<Container*> cs = findChildren<Container*>(QString(), Qt::FindDirectChildrenOnly);
 
-    if (cs.isEmpty()) {
+/*!
+ * \brief Converts this object into an XML entity, containing the \a keys in the given order.
+ *
+ * \a keys have to be descendants of this package. Consecutive keys of the same container are
+ * grouped into one container element.
+ *
+ * \since 1.1.0
+ * \return XML document
+ */
+QDomDocument Package::toXml(const QVector<Key *> &keys) const
+{
+    QDomDocument xml;
+
+    if (keys.isEmpty()) {
         return xml;
     }
 
@@ -155,11 +172,20 @@ QDomDocument Package::toXml() const
     e.setAttribute(QStringLiteral("name"), objectName());
     xml.appendChild(e);
 
-    for (int i = 0; i < cs.size(); ++i) {
-        QDomDocument c = cs.at(i)->toXml();
-        if (c.hasChildNodes()) {
-            e.appendChild(c);
+    int i = 0;
+    while (i < keys.size()) {
+        const QObject *c = keys.at(i)->parent();
+        int end = i + 1;
+        while (end < keys.size() && keys.at(end)->parent() == c) {
+            end++;
         }
+
+        QDomDocument cd = qobject_cast<const Container*>(c)->toXml(keys.mid(i, end - i));
+        if (cd.hasChildNodes()) {
+            e.appendChild(cd);
+        }
+
+        i = end;
     }
 
     return xml;
@@ -178,15 +204,34 @@ QDomDocument Package::toXml() const
  *
  * \param lang          The target language of the XLIFF document.
  * \param version2      Set to true if the output should be XLIFF 2.0 compatible.
+ * \param since         Baseline project for delta exports, see Project::toXliff().
+ * \param memory        Translation memory to propose matches for untranslated keys from, see Key::toXliffMatch().
+ * \param duplicates    Duplicate source strings to collapse, see Project::toXliff().
  * \return              XML document
  */
-QDomDocument Package::toXliff(const QString &lang, bool version2) const
+QDomDocument Package::toXliff(const QString &lang, bool version2, const Project *since, const TranslationMemory *memory, const DuplicateFinder *duplicates) const
 {
-    QDomDocument xml;
+    return toXliff(keys(), lang, version2, since, memory, duplicates);
+}
+
+
 
-    QList<Container*> cs = findChildren<Container*>(QString(), Qt::FindDirectChildrenOnly);
 
-    if (cs.isEmpty()) {
+
+/*!
+ * \brief Converts this object into an XLIFF compatible xml entity, containing the \a keys in the given order.
+ *
+ * \a keys have to be descendants of this package. Consecutive keys of the same container are
+ * grouped into one container element. See toXliff() for the other parameters.
+ *
+ * \since 1.1.0
+ * \return XML document
+ */
+QDomDocument Package::toXliff(const QVector<Key *> &keys, const QString &lang, bool version2, const Project *since, const TranslationMemory *memory, const DuplicateFinder *duplicates) const
+{
+    QDomDocument xml;
+
+    if (keys.isEmpty()) {
         return xml;
     }
 
@@ -198,12 +243,76 @@ QDomDocument Package::toXliff(const QString &lang, bool version2) const
     e.setAttribute(QStringLiteral("id"), id);
     xml.appendChild(e);
 
-    for (int i = 0; i < cs.size(); ++i) {
-        QDomDocument c = cs.at(i)->toXliff(lang, version2);
-        if (c.hasChildNodes()) {
-            e.appendChild(c);
+    int i = 0;
+    while (i < keys.size()) {
+        const QObject *c = keys.at(i)->parent();
+        int end = i + 1;
+        while (end < keys.size() && keys.at(end)->parent() == c) {
+            end++;
         }
+
+        QDomDocument cd = qobject_cast<const Container*>(c)->toXliff(keys.mid(i, end - i), lang, version2, since, memory, duplicates);
+        if (cd.hasChildNodes()) {
+            e.appendChild(cd);
+        }
+
+        i = end;
+    }
+
+    if (!e.hasChildNodes()) {
+        return QDomDocument();
     }
 
     return xml;
 }
+
+
+
+
+
+/*!
+ * \brief Returns the keys of all containers of this package, in creation order.
+ * \since 1.1.0
+ */
+QVector<Key*> Package::keys() const
+{
+    QVector<Key*> ks;
+
+    const QList<Container*> cs = findChildren<Container*>(QString(), Qt::FindDirectChildrenOnly);
+
+    for (int i = 0; i < cs.size(); ++i) {
+        ks += cs.at(i)->keys();
+    }
+
+    return ks;
+}
+
+
+
+
+
+/*!
+ * \brief Returns the raw XML of this package that is not represented by the object model.
+ *
+ * Contains unknown attributes and the comments and unknown elements around its children, so
+ * that the StringtableWriter can write them back.
+ *
+ * \since 1.1.0
+ */
+PassThrough &Package::passThrough()
+{
+    return m_passThrough;
+}
+
+
+
+
+
+/*!
+ * \brief Returns the raw XML of this package that is not represented by the object model.
+ * \since 1.1.0
+ */
+const PassThrough &Package::passThrough() const
+{
+    return m_passThrough;
+}
@@ -21,10 +21,17 @@
 
 #include <QObject>
 #include <QDomDocument>
+#include <QVector>
+#include "passthrough.h"
+#include "a3trans_global.h"
 
 class Translation;
+class Project;
+class TranslationMemory;
+class DuplicateFinder;
+class Key;
 
-class Package : public QObject
+class A3TRANS_EXPORT Package : public QObject
 {
     Q_OBJECT
 public:
@@ -38,10 +45,22 @@ public:
 
     QDomDocument toXml() const;
 
-    QDomDocument toXliff(const QString &lang, bool version2 = false) const;
+    QDomDocument toXml(const QVector<Key*> &keys) const;
+
+    QDomDocument toXliff(const QString &lang, bool version2 = false, const Project *since = nullptr, const TranslationMemory *memory = nullptr, const DuplicateFinder *duplicates = nullptr) const;
+
+    QDomDocument toXliff(const QVector<Key*> &keys, const QString &lang, bool version2 = false, const Project *since = nullptr, const TranslationMemory *memory = nullptr, const DuplicateFinder *duplicates = nullptr) const;
+
+    QVector<Key*> keys() const;
+
+    PassThrough &passThrough();
+
+    const PassThrough &passThrough() const;
 
 private:
     Q_DISABLE_COPY(Package)
+
+    PassThrough m_passThrough;
 };
 
 #endif // PACKAGE_H
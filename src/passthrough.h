@@ -0,0 +1,56 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PASSTHROUGH_H
+#define PASSTHROUGH_H
+
+#include <QString>
+#include <QStringList>
+
+/*!
+ * \brief Raw XML of a stringtable element that is not represented by the object model.
+ *
+ * \c attributes contains the unknown attributes of the element as read, including a leading space
+ * per attribute. \c before contains the comments, processing instructions and unknown elements
+ * preceding the element, \c end the ones following its last known child element. The markup is
+ * kept as it has been read, except for line breaks, which are normalized to \c \\n. The
+ * StringtableWriter writes it back without escaping it again, but does not keep the whitespace
+ * between the elements.
+ *
+ * \since 1.1.0
+ */
+struct PassThrough
+{
+    QString attributes;
+    QStringList before;
+    QStringList end;
+
+    bool isEmpty() const
+    {
+        return attributes.isEmpty() && before.isEmpty() && end.isEmpty();
+    }
+
+    void append(const PassThrough &other)
+    {
+        attributes.append(other.attributes);
+        before.append(other.before);
+        end.append(other.end);
+    }
+};
+
+#endif // PASSTHROUGH_H
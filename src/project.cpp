@@ -18,7 +18,13 @@
 
 #include "project.h"
 #include "package.h"
+#include "container.h"
+#include "key.h"
 #include "translation.h"
+#include "languages.h"
+#include "duplicatefinder.h"
+#include <QPair>
+#include <algorithm>
 #ifdef QT_DEBUG
 #include <QDebug>
 #endif
@@ -33,6 +39,10 @@
  * As the project node is the root node in the XML file, this object is the root object
  * for all other objects.
  *
+ * To fill a project with many translations, like when parsing files, use insert(). It remembers
+ * the last used package, container and key, so that consecutive entries belonging to the same
+ * node do not have to be looked up again from the top of the tree.
+ *
  * \since 1.0.0
  * \version 1.0.0
  * \date 2016-09-05
@@ -62,6 +72,50 @@ Project::Project(const QString &name, QObject *parent) : QObject(parent)
 
 
 
+/*!
+ * \brief Inserts a translation, creating missing Package, Container and Key objects.
+ *
+ * Works like setTranslation(), but reuses the nodes of the previous insert if the \a entry
+ * belongs to the same package, container or key. Keys are looked up through the hash index
+ * of the container.
+ *
+ * \since 1.1.0
+ * \return Pointer to the key the translation has been inserted into.
+ */
+Key *Project::insert(const Entry &entry)
+{
+    if (!m_lastPackage || m_lastPackage->objectName() != entry.package) {
+        Package *p = findChild<Package *>(entry.package, Qt::FindDirectChildrenOnly);
+        if (!p) {
+            p = new Package(entry.package, this);
+        }
+        m_lastPackage = p;
+        m_lastContainer = nullptr;
+        m_lastKey = nullptr;
+    }
+
+    if (!m_lastContainer || m_lastContainer->objectName() != entry.container) {
+        Container *c = m_lastPackage->findChild<Container *>(entry.container, Qt::FindDirectChildrenOnly);
+        if (!c) {
+            c = new Container(entry.container, m_lastPackage.data());
+        }
+        m_lastContainer = c;
+        m_lastKey = nullptr;
+    }
+
+    if (!m_lastKey || QString::compare(m_lastKey->objectName(), entry.key, Qt::CaseInsensitive) != 0) {
+        m_lastKey = m_lastContainer->key(entry.key, true);
+    }
+
+    m_lastKey->setTranslation(entry.lang, entry.text);
+
+    return m_lastKey.data();
+}
+
+
+
+
+
 /*!
  * \brief Sets a new translation belonging to this project.
  *
@@ -137,21 +191,59 @@ QList<Translation *> Project::getAllTranslations(const QString &package, const Q
 
 
 
+/*!
+ * \brief Returns the key identified by package, container and key id.
+ *
+ * If \a create is true, missing Package, Container and Key objects will be created,
+ * otherwise a null pointer is returned if one of them does not exist.
+ *
+ * \since 1.1.0
+ */
+Key *Project::key(const QString &package, const QString &container, const QString &key, bool create)
+{
+    Package *p = findChild<Package *>(package, Qt::FindDirectChildrenOnly);
+
+    if (!p) {
+        if (!create) {
+            return nullptr;
+        }
+        p = new Package(package, this);
+    }
+
+    Container *c = p->findChild<Container *>(container, Qt::FindDirectChildrenOnly);
+
+    if (!c) {
+        if (!create) {
+            return nullptr;
+        }
+        c = new Container(container, p);
+    }
+
+    return c->key(key, create);
+}
+
+
+
+
+
 /*!
  * \brief Converts this object into an XML entity.
  *
  * When converting to XML, all children will be converted to XML too and will be child nodes of this node.
  *
+ * If \a sorted is true, packages, containers and keys are written in the canonical order of sortedKeys(),
+ * otherwise in creation order.
+ *
  * \since 1.0.0
  * \return XML document
  */
-QDomDocument Project::toXml() const
+QDomDocument Project::toXml(bool sorted) const
 {
     QDomDocument xml;
 
-    QList<Package*> ps = findChildren<Package*>(QString(), Qt::FindDirectChildrenOnly);
+    const QVector<Key*> ks = sorted ? sortedKeys() : keys();
 
-    if (ps.isEmpty()) {
+    if (ks.isEmpty()) {
         return xml;
     }
 
@@ -162,11 +254,20 @@ QDomDocument Project::toXml() const
     e.setAttribute(QStringLiteral("name"), objectName());
     xml.appendChild(e);
 
-    for (int i = 0; i < ps.size(); ++i) {
-        QDomDocument p = ps.at(i)->toXml();
-        if (p.hasChildNodes()) {
-            e.appendChild(p);
+    int i = 0;
+    while (i < ks.size()) {
+        const Package *p = packageOf(ks.at(i));
+        int end = i + 1;
+        while (end < ks.size() && packageOf(ks.at(end)) == p) {
+            end++;
+        }
+
+        QDomDocument pd = p->toXml(ks.mid(i, end - i));
+        if (pd.hasChildNodes()) {
+            e.appendChild(pd);
         }
+
+        i = end;
     }
 
     return xml;
@@ -181,23 +282,44 @@ QDomDocument Project::toXml() const
  *
  * When converting to XLIFF, all children will be converted to XLIFF too and will be child nodes of this node.
  *
+ * If XliffOptions::since is not a null pointer, only keys that have been added or whose original string has
+ * changed compared to the baseline project will be exported and marked with their state. The file
+ * element will be marked as delta, so that the XliffParser can merge it into an existing stringtable.
+ *
+ * If XliffOptions::sorted is true, the units are written in the canonical order of sortedKeys().
+ *
+ * If XliffOptions::duplicates is not a null pointer, only the representative of every group of keys
+ * with the same source string is exported. Its unit lists the paths of the other keys of the group
+ * in the \c a3t:duplicates attribute, so that the XliffParser can copy the translation to them. In
+ * delta exports, the unit is exported if any key of the group has been added or changed.
+ *
+ * If XliffOptions::memory is not a null pointer, the best fuzzy match from the translation memory is
+ * added to every key without translation into \a lang, see Key::toXliffMatch().
+ *
  * \since 1.0.0
  *
  * \param lang          The target language of the XLIFF document.
- * \param srcLng        The source language of this project. Default: en
- * \param version2      Set to true if the output should be XLIFF 2.0 compatible. Default: false
+ * \param options       The source language, XLIFF version, baseline project, order, translation memory and duplicates to use.
  * \return              XML document
  */
-QDomDocument Project::toXliff(const QString &lang, const QString &srcLng, bool version2) const
+QDomDocument Project::toXliff(const QString &lang, const XliffOptions &options) const
 {
     QDomDocument xml;
 
-    QList<Package*> ps = findChildren<Package*>(QString(), Qt::FindDirectChildrenOnly);
+    QVector<Key*> ks = options.sorted ? sortedKeys() : keys();
+
+    if (options.duplicates) {
+        const DuplicateFinder *df = options.duplicates;
+        ks.erase(std::remove_if(ks.begin(), ks.end(), [df](const Key *k) { return df->isDuplicate(k); }), ks.end());
+    }
 
-    if (ps.isEmpty()) {
+    if (ks.isEmpty()) {
         return xml;
     }
 
+    const bool version2 = options.version2;
+    const Project *since = options.since;
+
     QDomProcessingInstruction pi = xml.createProcessingInstruction(QStringLiteral("xml"), QStringLiteral("version=\"1.0\" encoding=\"utf-8\" "));
     xml.appendChild(pi);
 
@@ -209,10 +331,18 @@ QDomDocument Project::toXliff(const QString &lang, const QString &srcLng, bool v
     } else {
         xliff = xml.createElementNS(QStringLiteral("urn:oasis:names:tc:xliff:document:2.0"), QStringLiteral("xliff"));
         xliff.setAttribute(QStringLiteral("version"), QStringLiteral("2.0"));
-        xliff.setAttribute(QStringLiteral("srcLang"), srcLng);
+        xliff.setAttribute(QStringLiteral("srcLang"), options.srcLang);
         xliff.setAttribute(QStringLiteral("trgLang"), lang);
     }
 
+    if (since || options.duplicates) {
+        xliff.setAttribute(QStringLiteral("xmlns:a3t"), QStringLiteral("urn:buschmann23.de:a3trans"));
+    }
+
+    if (version2 && options.memory && !lang.isEmpty()) {
+        xliff.setAttribute(QStringLiteral("xmlns:mtc"), QStringLiteral("urn:oasis:names:tc:xliff:matches:2.0"));
+    }
+
     xml.appendChild(xliff);
 
     QDomElement file = xml.createElement(QStringLiteral("file"));
@@ -222,7 +352,7 @@ QDomDocument Project::toXliff(const QString &lang, const QString &srcLng, bool v
 
     if (!version2) {
         file.setAttribute(QStringLiteral("original"), id);
-        file.setAttribute(QStringLiteral("source-language"), srcLng);
+        file.setAttribute(QStringLiteral("source-language"), options.srcLang);
         if (!lang.isEmpty()) {
             file.setAttribute(QStringLiteral("target-language"), lang);
         }
@@ -231,35 +361,123 @@ QDomDocument Project::toXliff(const QString &lang, const QString &srcLng, bool v
         file.setAttribute(QStringLiteral("id"), id);
     }
 
+    if (since) {
+        file.setAttribute(QStringLiteral("a3t:delta"), QStringLiteral("yes"));
+    }
+
     xliff.appendChild(file);
 
-    if (!version2) {
+    QDomElement parent = file;
 
+    if (!version2) {
         QDomElement body = xml.createElement(QStringLiteral("body"));
         file.appendChild(body);
+        parent = body;
+    }
 
-        for (int i = 0; i < ps.size(); ++i) {
-            QDomDocument p = ps.at(i)->toXliff(langCodeToString(lang), version2);
-            if (p.hasChildNodes()) {
-                body.appendChild(p);
-            }
-        }
+    const QString langName = langCodeToString(lang);
 
-    } else {
+    int i = 0;
+    while (i < ks.size()) {
+        const Package *p = packageOf(ks.at(i));
+        int end = i + 1;
+        while (end < ks.size() && packageOf(ks.at(end)) == p) {
+            end++;
+        }
 
-        for (int i = 0; i < ps.size(); ++i) {
-            QDomDocument p = ps.at(i)->toXliff(langCodeToString(lang), version2);
-            if (p.hasChildNodes()) {
-                file.appendChild(p);
-            }
+        QDomDocument pd = p->toXliff(ks.mid(i, end - i), langName, version2, since, options.memory, options.duplicates);
+        if (pd.hasChildNodes()) {
+            parent.appendChild(pd);
         }
 
+        i = end;
     }
 
     return xml;
 }
 
 
+
+
+
+/*!
+ * \brief Returns all keys of this project in creation order.
+ * \since 1.1.0
+ */
+QVector<Key*> Project::keys() const
+{
+    QVector<Key*> ks;
+
+    const QList<Package*> ps = findChildren<Package*>(QString(), Qt::FindDirectChildrenOnly);
+
+    for (int i = 0; i < ps.size(); ++i) {
+        ks += ps.at(i)->keys();
+    }
+
+    return ks;
+}
+
+
+
+
+
+/*!
+ * \brief Returns all keys of this project in canonical order.
+ *
+ * Keys are ordered by package name, container name and case insensitive key id. The order does
+ * not depend on the order the keys have been created in, so that the output of multiple runs
+ * over the same data is identical. The flat key list is sorted once, instead of sorting the
+ * children of every node.
+ *
+ * \since 1.1.0
+ */
+QVector<Key*> Project::sortedKeys() const
+{
+    const QVector<Key*> ks = keys();
+
+    QVector<QPair<QString, Key*> > sortable;
+    sortable.reserve(ks.size());
+
+    for (int i = 0; i < ks.size(); ++i) {
+        Key *k = ks.at(i);
+        const QObject *c = k->parent();
+        const QObject *p = c->parent();
+        QString sortKey = p->objectName();
+        sortKey.append(QChar(0x1f)).append(c->objectName()).append(QChar(0x1f)).append(k->objectName().toCaseFolded());
+        sortable.append(qMakePair(sortKey, k));
+    }
+
+    std::stable_sort(sortable.begin(), sortable.end(), [](const QPair<QString, Key*> &a, const QPair<QString, Key*> &b) {
+        return a.first < b.first;
+    });
+
+    QVector<Key*> sorted;
+    sorted.reserve(sortable.size());
+
+    for (int i = 0; i < sortable.size(); ++i) {
+        sorted.append(sortable.at(i).second);
+    }
+
+    return sorted;
+}
+
+
+
+
+
+/*!
+ * \brief Returns the package \a key belongs to.
+ * \since 1.1.0
+ */
+const Package *Project::packageOf(const Key *key)
+{
+    return qobject_cast<const Package*>(key->parent()->parent());
+}
+
+
+
+
+
 /*!
  * \brief Returns the language name used by ArmA that is associated to the ISO 639-1 code.
  * \param code  ISO 639-1 language code.
@@ -267,30 +485,35 @@ QDomDocument Project::toXliff(const QString &lang, const QString &srcLng, bool v
  */
 QString Project::langCodeToString(const QString &code) const
 {
-    QString c = code.toLower();
-    if (c == QLatin1String("en")) {
-        return QStringLiteral("English");
-    } else if (c == QLatin1String("cz")) {
-        return QStringLiteral("Czech");
-    } else if (c == QLatin1String("fr")) {
-        return QStringLiteral("French");
-    } else if (c == QLatin1String("es")) {
-        return QStringLiteral("Spanish");
-    } else if (c == QLatin1String("it")) {
-        return QStringLiteral("Italian");
-    } else if (c == QLatin1String("pl")) {
-        return QStringLiteral("Polish");
-    } else if (c == QLatin1String("pt")) {
-        return QStringLiteral("Portuguese");
-    } else if (c == QLatin1String("ru")) {
-        return QStringLiteral("Russian");
-    } else if (c == QLatin1String("de")) {
-        return QStringLiteral("German");
-    } else if (c == QLatin1String("ko")) {
-        return QStringLiteral("Korean");
-    } else if (c == QLatin1String("ja")) {
-        return QStringLiteral("Japanese");
-    } else {
-        return QString();
-    }
+    return Languages::codeToString(code);
+}
+
+
+
+
+
+/*!
+ * \brief Returns the raw XML of this project that is not represented by the object model.
+ *
+ * Contains unknown attributes and the comments and unknown elements around its children, so
+ * that the StringtableWriter can write them back.
+ *
+ * \since 1.1.0
+ */
+PassThrough &Project::passThrough()
+{
+    return m_passThrough;
+}
+
+
+
+
+
+/*!
+ * \brief Returns the raw XML of this project that is not represented by the object model.
+ * \since 1.1.0
+ */
+const PassThrough &Project::passThrough() const
+{
+    return m_passThrough;
 }
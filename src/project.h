@@ -21,29 +21,76 @@
 
 #include <QObject>
 #include <QDomDocument>
+#include <QVector>
+#include <QPointer>
+#include "passthrough.h"
+#include "a3trans_global.h"
 
 class Translation;
+class Key;
+class Package;
+class Container;
+class Project;
+class TranslationMemory;
+class DuplicateFinder;
 
-class Project : public QObject
+struct XliffOptions
+{
+    QString srcLang = QStringLiteral("en");
+    bool version2 = false;
+    const Project *since = nullptr;
+    bool sorted = false;
+    const TranslationMemory *memory = nullptr;
+    const DuplicateFinder *duplicates = nullptr;
+};
+
+class A3TRANS_EXPORT Project : public QObject
 {
     Q_OBJECT
 public:
+    struct Entry {
+        QString package;
+        QString container;
+        QString key;
+        QString lang;
+        QString text;
+    };
+
     explicit Project(const QString &name, QObject *parent = nullptr);
 
+    Key *insert(const Entry &entry);
+
     void setTranslation(const QString &package, const QString &container, const QString &key, const QString &lang, const QString &translation);
 
     Translation *getTranslation(const QString &package, const QString &container, const QString &key, const QString &lang);
 
     QList<Translation *> getAllTranslations(const QString &package, const QString &container, const QString &key) const;
 
-    QDomDocument toXml() const;
+    Key *key(const QString &package, const QString &container, const QString &key, bool create = false);
+
+    QDomDocument toXml(bool sorted = false) const;
 
-    QDomDocument toXliff(const QString &lang, const QString &srcLng = QStringLiteral("en"), bool version2 = false) const;
+    QDomDocument toXliff(const QString &lang, const XliffOptions &options = XliffOptions()) const;
+
+    QVector<Key*> keys() const;
+
+    QVector<Key*> sortedKeys() const;
 
     QString langCodeToString(const QString &code) const;
 
+    PassThrough &passThrough();
+
+    const PassThrough &passThrough() const;
+
 private:
     Q_DISABLE_COPY(Project)
+
+    PassThrough m_passThrough;
+    QPointer<Package> m_lastPackage;
+    QPointer<Container> m_lastContainer;
+    QPointer<Key> m_lastKey;
+
+    static const Package *packageOf(const Key *key);
 };
 
 #endif // PROJECT_H
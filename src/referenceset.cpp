@@ -0,0 +1,198 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "referenceset.h"
+#include "keyindex.h"
+#include "project.h"
+#include "package.h"
+#include "container.h"
+#include "key.h"
+#include "report.h"
+#include <QDir>
+
+
+
+/*!
+ * \class ReferenceSet
+ * \brief Collects the localization key ids used in script files and resolves them in one pass.
+ *
+ * A key id is often used in many places of a code base. Instead of searching the projects for every
+ * single occurrence, the occurrences are collected in a set that is deduplicated by the case folded
+ * key id, while the positions of all occurrences are kept for diagnostics. After all files have been
+ * parsed, resolve() looks up every unique id exactly once in hash indexes of the projects.
+ *
+ * The set also records the files whose references have been added, see addFile(), so that the
+ * references of a file that is included by several files, or that is matched and included at the
+ * same time, are only collected and reported once.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new empty ReferenceSet object.
+ * \since 1.1.0
+ */
+ReferenceSet::ReferenceSet(QObject *parent) : QObject(parent), m_occurrences(0)
+{
+
+}
+
+
+
+/*!
+ * \brief Adds an occurrence of a key id.
+ * \since 1.1.0
+ */
+void ReferenceSet::add(const Reference &reference)
+{
+    const QString id = KeyIndex::normalize(reference.key);
+
+    QHash<QString, int>::const_iterator it = m_index.constFind(id);
+
+    if (it != m_index.constEnd()) {
+        m_entries[it.value()].occurrences.append(reference);
+    } else {
+        m_index.insert(id, m_entries.size());
+        m_entries.append({reference.key, QVector<Reference>({reference})});
+    }
+
+    m_occurrences++;
+}
+
+
+
+/*!
+ * \brief Records that the data of the file at \a filePath is being added.
+ *
+ * Returns false if the file has already been added before, in that case its data should be skipped.
+ *
+ * \since 1.1.0
+ */
+bool ReferenceSet::addFile(const QString &filePath)
+{
+    const QString path = QDir::cleanPath(filePath);
+
+    if (m_files.contains(path)) {
+        return false;
+    }
+
+    m_files.insert(path);
+
+    return true;
+}
+
+
+
+/*!
+ * \brief Returns the number of unique key ids.
+ * \since 1.1.0
+ */
+int ReferenceSet::size() const
+{
+    return m_entries.size();
+}
+
+
+
+/*!
+ * \brief Returns the number of all collected occurrences.
+ * \since 1.1.0
+ */
+int ReferenceSet::occurrenceCount() const
+{
+    return m_occurrences;
+}
+
+
+
+/*!
+ * \brief Returns all occurrences of the case insensitive \a key.
+ * \since 1.1.0
+ */
+QVector<Reference> ReferenceSet::occurrences(const QString &key) const
+{
+    const int idx = m_index.value(KeyIndex::normalize(key), -1);
+    return idx < 0 ? QVector<Reference>() : m_entries.at(idx).occurrences;
+}
+
+
+
+/*!
+ * \brief Resolves the collected key ids against the projects.
+ *
+ * Key ids that are not defined by TR comments in the \a scriptProject are searched in the
+ * \a stringTableProject. If they are found there, the key is added to the \a scriptProject,
+ * sharing the translations of the stringtable key. Key ids that are found nowhere are added to
+ * the \a report together with all their occurrences. If \a report is a null pointer, they are
+ * printed as debug messages.
+ *
+ * \since 1.1.0
+ * \param scriptProject         The project containing the strings extracted from the script files.
+ * \param stringTableProject    The project containing the existing stringtable, can be a null pointer.
+ * \param report                Report that collects the key ids without localization, can be a null pointer.
+ * \return                      The number of key ids without localization.
+ */
+int ReferenceSet::resolve(Project *scriptProject, const Project *stringTableProject, Report *report)
+{
+    const KeyIndex spIndex(scriptProject);
+    const KeyIndex stIndex(stringTableProject);
+
+    int unresolved = 0;
+
+    for (int i = 0; i < m_entries.size(); ++i) {
+        const Entry &e = m_entries.at(i);
+
+        if (spIndex.find(e.key)) {
+            continue;
+        }
+
+        Key *k = stIndex.find(e.key);
+
+        if (k) {
+
+            Container *c = qobject_cast<Container*>(k->parent());
+            Package *p = c ? qobject_cast<Package*>(c->parent()) : nullptr;
+
+            if (c && p && !k->getAllTranslations().isEmpty()) {
+                Key *sk = scriptProject->key(p->objectName(), c->objectName(), k->objectName(), true);
+                sk->shareTranslations(k);
+            }
+
+        } else {
+
+            unresolved++;
+
+            if (report) {
+                report->add(QStringLiteral("unresolved-id"), Report::Warning, e.key, tr("ID without localization"), e.occurrences);
+                continue;
+            }
+
+            const Reference &r = e.occurrences.first();
+            qDebug("%s", qUtf8Printable(tr("ID without localization in %1 at line %2: %3 (%n occurrence(s))", "", e.occurrences.size()).arg(r.file, QString::number(r.line), e.key)));
+
+        }
+    }
+
+    return unresolved;
+}
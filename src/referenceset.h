@@ -0,0 +1,64 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REFERENCESET_H
+#define REFERENCESET_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QSet>
+#include "scriptresult.h"
+#include "a3trans_global.h"
+
+class Project;
+class Report;
+
+class A3TRANS_EXPORT ReferenceSet : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ReferenceSet(QObject *parent = nullptr);
+
+    void add(const Reference &reference);
+
+    bool addFile(const QString &filePath);
+
+    int size() const;
+
+    int occurrenceCount() const;
+
+    QVector<Reference> occurrences(const QString &key) const;
+
+    int resolve(Project *scriptProject, const Project *stringTableProject, Report *report = nullptr);
+
+private:
+    Q_DISABLE_COPY(ReferenceSet)
+
+    struct Entry {
+        QString key;
+        QVector<Reference> occurrences;
+    };
+
+    QHash<QString, int> m_index;
+    QVector<Entry> m_entries;
+    QSet<QString> m_files;
+    int m_occurrences;
+};
+
+#endif // REFERENCESET_H
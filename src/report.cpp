@@ -0,0 +1,526 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "report.h"
+#include <QMutexLocker>
+#include <QFile>
+#include <QDir>
+#include <QUrl>
+#include <QTextStream>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QCoreApplication>
+#include <stdio.h>
+
+
+
+/*!
+ * \class Report
+ * \brief Collects diagnostics during a run and writes them once at the end.
+ *
+ * Instead of printing every finding when it occurs, findings are buffered and aggregated by rule
+ * and case insensitive key id, keeping the file, line, column and class context of every occurrence.
+ * At the end of the run, the report is written as plain text, as JSON or as SARIF 2.1.0 log for
+ * code scanning tools. The number of written occurrences can be limited by setMaxDiagnostics(),
+ * omitted occurrences are counted in the summary.
+ *
+ * Diagnostics can be added from several threads at the same time, so that a single report can be
+ * shared by the jobs of a batch run. The jobs collect their findings in a report of their own and
+ * add it together with their working directory, see add(const Report&, const QString&), so that
+ * the same key id in different working directories results in separate findings.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new empty Report object.
+ * \since 1.1.0
+ */
+Report::Report(QObject *parent) : QObject(parent), m_format(Text), m_max(0)
+{
+
+}
+
+
+
+/*!
+ * \brief Sets the output format used by write(). Default: Text
+ * \since 1.1.0
+ */
+void Report::setFormat(Format format)
+{
+    m_format = format;
+}
+
+
+
+/*!
+ * \brief Sets the maximum number of occurrences written by write(). 0 means no limit, the default.
+ * \since 1.1.0
+ */
+void Report::setMaxDiagnostics(int max)
+{
+    m_max = qMax(0, max);
+}
+
+
+
+/*!
+ * \brief Adds a finding.
+ *
+ * If there is already a finding for the same \a rule and \a key, the \a occurrences are appended to it.
+ *
+ * \since 1.1.0
+ * \param rule          Identifier of the check that produced the finding, like \c unresolved-id.
+ * \param level         Severity of the finding.
+ * \param key           The key id the finding is about.
+ * \param message       Human readable description of the finding.
+ * \param occurrences   Positions in the source files the finding applies to.
+ */
+void Report::add(const QString &rule, Level level, const QString &key, const QString &message, const QVector<Reference> &occurrences)
+{
+    QMutexLocker locker(&m_mutex);
+
+    insert({rule, level, key, message, occurrences, QString()});
+}
+
+
+
+/*!
+ * \brief Adds all findings of the \a other report that have been found in the working directory \a root.
+ *
+ * Findings are only aggregated with findings of the same \a root.
+ *
+ * \since 1.1.0
+ */
+void Report::add(const Report &other, const QString &root)
+{
+    QMutexLocker otherLocker(&other.m_mutex);
+    QMutexLocker locker(&m_mutex);
+
+    for (int i = 0; i < other.m_diagnostics.size(); ++i) {
+        Diagnostic d = other.m_diagnostics.at(i);
+        d.root = root;
+        insert(d);
+    }
+}
+
+
+
+/*!
+ * \brief Adds the \a diagnostic or appends its occurrences to the finding with the same root, rule and key.
+ *
+ * The mutex has to be locked by the caller.
+ *
+ * \since 1.1.0
+ */
+void Report::insert(const Diagnostic &diagnostic)
+{
+    const QString id = diagnostic.root + QChar(0x1f) + diagnostic.rule + QChar(0x1f) + diagnostic.key.toCaseFolded();
+
+    QHash<QString, int>::const_iterator it = m_index.constFind(id);
+
+    if (it != m_index.constEnd()) {
+        m_diagnostics[it.value()].occurrences += diagnostic.occurrences;
+    } else {
+        m_index.insert(id, m_diagnostics.size());
+        m_diagnostics.append(diagnostic);
+    }
+}
+
+
+
+/*!
+ * \brief Returns the number of aggregated findings.
+ * \since 1.1.0
+ */
+int Report::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_diagnostics.size();
+}
+
+
+
+/*!
+ * \brief Returns true if the report does not contain any findings.
+ * \since 1.1.0
+ */
+bool Report::isEmpty() const
+{
+    return size() == 0;
+}
+
+
+
+/*!
+ * \brief Removes all findings, so that the report can be reused for the next run.
+ * \since 1.1.0
+ */
+void Report::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_diagnostics.clear();
+    m_index.clear();
+}
+
+
+
+/*!
+ * \brief Writes the report to the file at \a filePath or to stderr if \a filePath is empty.
+ * \since 1.1.0
+ * \return True on success.
+ */
+bool Report::write(const QString &filePath) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QFile f;
+
+    if (filePath.isEmpty()) {
+        if (!f.open(stderr, QIODevice::WriteOnly)) {
+            return false;
+        }
+    } else {
+        f.setFileName(filePath);
+        if (!f.open(QIODevice::WriteOnly|QIODevice::Truncate)) {
+            qCritical("%s", qUtf8Printable(tr("Failed to open report file: %1").arg(filePath)));
+            return false;
+        }
+    }
+
+    switch(m_format) {
+    case Json:
+        writeJson(&f);
+        break;
+    case Sarif:
+        writeSarif(&f);
+        break;
+    default:
+        writeText(&f);
+        break;
+    }
+
+    f.close();
+
+    return true;
+}
+
+
+
+/*!
+ * \brief Returns the format for the \a name text, json or sarif.
+ *
+ * If \a ok is not a null pointer, it is set to false for unknown names and Text is returned.
+ *
+ * \since 1.1.0
+ */
+Report::Format Report::formatFromString(const QString &name, bool *ok)
+{
+    const QString n = name.trimmed().toLower();
+
+    if (ok) {
+        *ok = true;
+    }
+
+    if (n == QLatin1String("json")) {
+        return Json;
+    } else if (n == QLatin1String("sarif")) {
+        return Sarif;
+    } else if (n != QLatin1String("text") && ok) {
+        *ok = false;
+    }
+
+    return Text;
+}
+
+
+
+/*!
+ * \brief Writes the findings as plain text, one block per finding with one line per occurrence.
+ * \since 1.1.0
+ */
+void Report::writeText(QIODevice *out) const
+{
+    QTextStream ts(out);
+    ts.setCodec("UTF-8");
+
+    int written = 0;
+    int omitted = 0;
+    int total = 0;
+
+    // the working directory is only printed if the findings belong to several of them
+    bool severalRoots = false;
+    for (int i = 1; i < m_diagnostics.size() && !severalRoots; ++i) {
+        severalRoots = m_diagnostics.at(i).root != m_diagnostics.at(0).root;
+    }
+
+    for (int i = 0; i < m_diagnostics.size(); ++i) {
+        const Diagnostic &d = m_diagnostics.at(i);
+        const int count = qMax(1, d.occurrences.size());
+        total += count;
+
+        if (m_max > 0 && written >= m_max) {
+            omitted += count;
+            continue;
+        }
+
+        ts << levelToString(d.level) << ": " << d.key << ": " << d.message << " [" << d.rule << "]";
+        if (severalRoots) {
+            ts << " (" << QDir::toNativeSeparators(d.root) << ')';
+        }
+        ts << '\n';
+
+        if (d.occurrences.isEmpty()) {
+            written++;
+        }
+
+        for (int j = 0; j < d.occurrences.size(); ++j) {
+            if (m_max > 0 && written >= m_max) {
+                omitted += d.occurrences.size() - j;
+                break;
+            }
+            const Reference &r = d.occurrences.at(j);
+            ts << "    " << displayPath(r.file) << ':' << r.line << ':' << r.column;
+            if (!r.context.isEmpty()) {
+                ts << " (" << r.context << ')';
+            }
+            ts << '\n';
+            written++;
+        }
+    }
+
+    ts << tr("%1 finding(s) with %2 occurrence(s).").arg(m_diagnostics.size()).arg(total);
+    if (omitted > 0) {
+        ts << ' ' << tr("%1 occurrence(s) omitted.").arg(omitted);
+    }
+    ts << '\n';
+}
+
+
+
+/*!
+ * \brief Writes the findings as JSON document.
+ * \since 1.1.0
+ */
+void Report::writeJson(QIODevice *out) const
+{
+    QJsonArray findings;
+
+    int written = 0;
+    int omitted = 0;
+
+    for (int i = 0; i < m_diagnostics.size(); ++i) {
+        const Diagnostic &d = m_diagnostics.at(i);
+
+        if (m_max > 0 && written >= m_max) {
+            omitted += qMax(1, d.occurrences.size());
+            continue;
+        }
+
+        QJsonArray occurrences;
+
+        if (d.occurrences.isEmpty()) {
+            written++;
+        }
+
+        for (int j = 0; j < d.occurrences.size(); ++j) {
+            if (m_max > 0 && written >= m_max) {
+                omitted += d.occurrences.size() - j;
+                break;
+            }
+            const Reference &r = d.occurrences.at(j);
+            QJsonObject o;
+            o.insert(QStringLiteral("file"), displayPath(r.file));
+            o.insert(QStringLiteral("line"), r.line);
+            o.insert(QStringLiteral("column"), r.column);
+            if (!r.context.isEmpty()) {
+                o.insert(QStringLiteral("context"), r.context);
+            }
+            occurrences.append(o);
+            written++;
+        }
+
+        QJsonObject f;
+        f.insert(QStringLiteral("rule"), d.rule);
+        f.insert(QStringLiteral("level"), levelToString(d.level));
+        f.insert(QStringLiteral("key"), d.key);
+        f.insert(QStringLiteral("message"), d.message);
+        if (!d.root.isEmpty()) {
+            f.insert(QStringLiteral("root"), QDir::toNativeSeparators(d.root));
+        }
+        f.insert(QStringLiteral("count"), d.occurrences.size());
+        f.insert(QStringLiteral("occurrences"), occurrences);
+        findings.append(f);
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("tool"), QCoreApplication::applicationName());
+    root.insert(QStringLiteral("version"), QCoreApplication::applicationVersion());
+    root.insert(QStringLiteral("findings"), findings);
+    root.insert(QStringLiteral("omitted"), omitted);
+
+    out->write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+}
+
+
+
+/*!
+ * \brief Writes the findings as SARIF 2.1.0 log, one result per finding.
+ *
+ * The number of occurrences omitted because of the limit set by setMaxDiagnostics() is written to
+ * the \c omitted property of the run. Results of a truncated finding contain the number of all of
+ * its occurrences in their \c count property.
+ *
+ * \since 1.1.0
+ */
+void Report::writeSarif(QIODevice *out) const
+{
+    QJsonArray rules;
+    QHash<QString, int> ruleIndex;
+    QJsonArray results;
+
+    int written = 0;
+    int omitted = 0;
+
+    for (int i = 0; i < m_diagnostics.size(); ++i) {
+        const Diagnostic &d = m_diagnostics.at(i);
+
+        if (m_max > 0 && written >= m_max) {
+            omitted += qMax(1, d.occurrences.size());
+            continue;
+        }
+
+        if (!ruleIndex.contains(d.rule)) {
+            ruleIndex.insert(d.rule, rules.size());
+            QJsonObject rule;
+            rule.insert(QStringLiteral("id"), d.rule);
+            rules.append(rule);
+        }
+
+        QJsonArray locations;
+
+        if (d.occurrences.isEmpty()) {
+            written++;
+        }
+
+        for (int j = 0; j < d.occurrences.size(); ++j) {
+            if (m_max > 0 && written >= m_max) {
+                omitted += d.occurrences.size() - j;
+                break;
+            }
+            const Reference &r = d.occurrences.at(j);
+
+            QJsonObject region;
+            region.insert(QStringLiteral("startLine"), qMax(1, r.line));
+            region.insert(QStringLiteral("startColumn"), qMax(1, r.column));
+
+            QJsonObject artifact;
+            artifact.insert(QStringLiteral("uri"), QUrl::fromLocalFile(r.file).toString());
+
+            QJsonObject physical;
+            physical.insert(QStringLiteral("artifactLocation"), artifact);
+            physical.insert(QStringLiteral("region"), region);
+
+            QJsonObject location;
+            location.insert(QStringLiteral("physicalLocation"), physical);
+            locations.append(location);
+            written++;
+        }
+
+        QJsonObject message;
+        message.insert(QStringLiteral("text"), d.key + QLatin1String(": ") + d.message);
+
+        QJsonObject result;
+        result.insert(QStringLiteral("ruleId"), d.rule);
+        result.insert(QStringLiteral("ruleIndex"), ruleIndex.value(d.rule));
+        result.insert(QStringLiteral("level"), levelToString(d.level));
+        result.insert(QStringLiteral("message"), message);
+        if (!locations.isEmpty()) {
+            result.insert(QStringLiteral("locations"), locations);
+        }
+
+        QJsonObject properties;
+        properties.insert(QStringLiteral("count"), d.occurrences.size());
+        if (!d.root.isEmpty()) {
+            properties.insert(QStringLiteral("root"), QDir::toNativeSeparators(d.root));
+        }
+        result.insert(QStringLiteral("properties"), properties);
+
+        results.append(result);
+    }
+
+    QJsonObject driver;
+    driver.insert(QStringLiteral("name"), QCoreApplication::applicationName());
+    driver.insert(QStringLiteral("version"), QCoreApplication::applicationVersion());
+    driver.insert(QStringLiteral("rules"), rules);
+
+    QJsonObject tool;
+    tool.insert(QStringLiteral("driver"), driver);
+
+    QJsonObject runProperties;
+    runProperties.insert(QStringLiteral("omitted"), omitted);
+
+    QJsonObject run;
+    run.insert(QStringLiteral("tool"), tool);
+    run.insert(QStringLiteral("results"), results);
+    run.insert(QStringLiteral("properties"), runProperties);
+
+    QJsonObject root;
+    root.insert(QStringLiteral("$schema"), QStringLiteral("https://json.schemastore.org/sarif-2.1.0.json"));
+    root.insert(QStringLiteral("version"), QStringLiteral("2.1.0"));
+    root.insert(QStringLiteral("runs"), QJsonArray({run}));
+
+    out->write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+}
+
+
+
+/*!
+ * \brief Returns the name of the \a level.
+ * \since 1.1.0
+ */
+QString Report::levelToString(Level level)
+{
+    switch(level) {
+    case Error:
+        return QStringLiteral("error");
+    case Warning:
+        return QStringLiteral("warning");
+    default:
+        return QStringLiteral("note");
+    }
+}
+
+
+
+/*!
+ * \brief Returns \a filePath relative to the current directory.
+ * \since 1.1.0
+ */
+QString Report::displayPath(const QString &filePath)
+{
+    return QDir::toNativeSeparators(QDir::current().relativeFilePath(filePath));
+}
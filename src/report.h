@@ -0,0 +1,94 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QMutex>
+#include "scriptresult.h"
+#include "a3trans_global.h"
+
+class QIODevice;
+
+class A3TRANS_EXPORT Report : public QObject
+{
+    Q_OBJECT
+public:
+    enum Format {
+        Text,
+        Json,
+        Sarif
+    };
+
+    enum Level {
+        Note,
+        Warning,
+        Error
+    };
+
+    struct Diagnostic {
+        QString rule;
+        Level level;
+        QString key;
+        QString message;
+        QVector<Reference> occurrences;
+        QString root;
+    };
+
+    explicit Report(QObject *parent = nullptr);
+
+    void setFormat(Format format);
+
+    void setMaxDiagnostics(int max);
+
+    void add(const QString &rule, Level level, const QString &key, const QString &message, const QVector<Reference> &occurrences = QVector<Reference>());
+
+    void add(const Report &other, const QString &root);
+
+    int size() const;
+
+    bool isEmpty() const;
+
+    void clear();
+
+    bool write(const QString &filePath = QString()) const;
+
+    static Format formatFromString(const QString &name, bool *ok = nullptr);
+
+private:
+    Q_DISABLE_COPY(Report)
+
+    mutable QMutex m_mutex;
+    QVector<Diagnostic> m_diagnostics;
+    QHash<QString, int> m_index;
+    Format m_format;
+    int m_max;
+
+    void insert(const Diagnostic &diagnostic);
+    void writeText(QIODevice *out) const;
+    void writeJson(QIODevice *out) const;
+    void writeSarif(QIODevice *out) const;
+
+    static QString levelToString(Level level);
+    static QString displayPath(const QString &filePath);
+};
+
+#endif // REPORT_H
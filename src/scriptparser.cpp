@@ -27,6 +27,33 @@
 #include <QRegularExpressionMatch>
 #include <QRegularExpressionMatchIterator>
 #include <QFileInfo>
+#include "includecache.h"
+#include "referenceset.h"
+
+
+
+/*!
+ * \internal
+ * \brief Returns the expression matching single line TR comments.
+ *
+ * The expressions are compiled only once and shared between all parsers and threads.
+ */
+static const QRegularExpression &singleLineExpression()
+{
+    static const QRegularExpression re(QStringLiteral("//\\s*TR\\s+([a-zA-z0-9_\\*]+)\\s+([a-zA-z0-9_\\*]+)\\s+([a-zA-z0-9_]+)\\s+\"([^\"]*)\""));
+    return re;
+}
+
+
+/*!
+ * \internal
+ * \brief Returns the expression matching the header line of multiline TR comments.
+ */
+static const QRegularExpression &multiLineMetaExpression()
+{
+    static const QRegularExpression re(QStringLiteral("/\\*\\s*TR\\s+([a-zA-z0-9_\\*]+)\\s+([a-zA-z0-9_\\*]+)\\s+([a-zA-z0-9_\\*]+)"));
+    return re;
+}
 
 
 
@@ -34,7 +61,8 @@
  * \class ScriptParser
  * \brief Provides methods and functions to extract translation strings from scripts.
  *
- * This class can extract translation strings from SQF, EXT and SQM files.
+ * This class can extract translation strings from SQF, EXT and SQM files. Include directives
+ * are followed if an IncludeCache has been set.
  *
  * \since 1.0.0
  * \version 1.0.0
@@ -53,18 +81,46 @@
  * \param scriptProject         Pointer to a Project object that will contain the extracted data.
  * \param parent                Pointer to the parent object.
  */
-ScriptParser::ScriptParser(const QString &scriptFile, Project *stringTableProject, Project *scriptProject, QObject *parent) : QObject(parent), m_st(stringTableProject), m_sp(scriptProject)
+ScriptParser::ScriptParser(const QString &scriptFile, Project *stringTableProject, Project *scriptProject, QObject *parent) : QObject(parent), m_st(stringTableProject), m_sp(scriptProject), m_cache(nullptr), m_refs(nullptr)
 {
     m_file.setFileName(scriptFile);
     m_fileBaseName = QFileInfo(m_file).baseName();
 }
 
 
+/*!
+ * \brief Sets the \a cache used to parse included files only once.
+ *
+ * If no cache is set, include directives are not followed.
+ *
+ * \since 1.1.0
+ */
+void ScriptParser::setIncludeCache(IncludeCache *cache)
+{
+    m_cache = cache;
+}
+
+
+/*!
+ * \brief Sets the set that collects the used key ids.
+ *
+ * If a set is set, key ids used in the file are only collected and have to be resolved by calling
+ * ReferenceSet::resolve() after all files have been parsed. Otherwise they are resolved at the end of parse().
+ *
+ * \since 1.1.0
+ */
+void ScriptParser::setReferenceSet(ReferenceSet *references)
+{
+    m_refs = references;
+}
+
+
 /*!
  * \brief Starts the parsing process.
  *
  * The extracted data will be part of the Project object that has been set via the scriptProject parameter
- * when creating the object.
+ * when creating the object. If an IncludeCache has been set, the data extracted from included files will
+ * be attributed to this file, too.
  *
  * \since 1.0.0
  */
@@ -75,50 +131,100 @@ void ScriptParser::parse()
         return;
     }
 
+    ReferenceSet localRefs;
+    ReferenceSet *refs = m_refs ? m_refs : &localRefs;
+
+    if (m_cache) {
+        const ScriptResult *r = m_cache->result(m_file.fileName());
+        if (r) {
+            apply(*r, refs);
+        }
+    } else {
+        apply(extract(), refs);
+    }
+
+    if (!m_refs) {
+        localRefs.resolve(m_sp, m_st);
+    }
+}
+
+
+
+/*!
+ * \brief Saves the data of an already extracted \a result instead of parsing the file.
+ *
+ * Used to link the results read from an Artifact. Included files are only followed if an
+ * IncludeCache has been set, otherwise they have to be part of the linked results themselves.
+ *
+ * \since 1.1.0
+ */
+void ScriptParser::parse(const ScriptResult &result)
+{
+    if (!m_sp) {
+        qFatal("We have no valid Project object.");
+        return;
+    }
+
+    ReferenceSet localRefs;
+    ReferenceSet *refs = m_refs ? m_refs : &localRefs;
+
+    apply(result, refs);
+
+    if (!m_refs) {
+        localRefs.resolve(m_sp, m_st);
+    }
+}
+
+
+/*!
+ * \brief Extracts the translation strings, localization key references and include directives from the file.
+ *
+ * If \a cache is not a null pointer, include directives are resolved and the included files are parsed through the cache.
+ *
+ * \since 1.1.0
+ * \param cache     Pointer to the cache used to parse included files.
+ * \return          The extracted data.
+ */
+ScriptResult ScriptParser::extract(IncludeCache *cache)
+{
+    ScriptResult result;
+    result.file = m_file.fileName();
+
     if (!m_file.open(QIODevice::ReadOnly|QIODevice::Text)) {
         qCritical("%s", qUtf8Printable(tr("Can not open script file.")));
-        return;
+        return result;
     }
 
     QTextStream in(&m_file);
     in.setCodec("UTF-8");
 
-    QRegularExpression singleLine(QStringLiteral("//\\s*TR\\s+([a-zA-z0-9_\\*]+)\\s+([a-zA-z0-9_\\*]+)\\s+([a-zA-z0-9_]+)\\s+\"([^\"]*)\""));
+    // the expressions are compiled only once and shared between all parsers and threads
+    const QRegularExpression &singleLine = singleLineExpression();
 
-    QRegularExpression multiLineStart(QStringLiteral("/\\*\\s*TR"));
-    QRegularExpression multiLineEnd(QStringLiteral("\\s*\\*/"));
-    QRegularExpression multiLineMeta(QStringLiteral("/\\*\\s*TR\\s+([a-zA-z0-9_\\*]+)\\s+([a-zA-z0-9_\\*]+)\\s+([a-zA-z0-9_\\*]+)"));
+    static const QRegularExpression multiLineStart(QStringLiteral("/\\*\\s*TR"));
+    const QRegularExpression &multiLineMeta = multiLineMetaExpression();
     bool multiLineStarted = false;
 
+    static const QRegularExpression locString(QStringLiteral("(str_[a-zA-Z0-9_]+)"), QRegularExpression::CaseInsensitiveOption);
+
+    static const QRegularExpression includeDirective(QStringLiteral("^\\s*#\\s*include\\s+[\"<]([^\">]+)[\">]"));
+
     QString multiLineHeader;    // stores the start line of a multiline translation comment
-    QString multiLine;          // stores the content string of a multiline translation comment
+    QString multiLine;          // stores the normalized content string of a multiline translation comment
+    multiLine.reserve(256);
+
+    int lineNumber = 0;
 
-    // start searching for translation comments
     while (!in.atEnd()) {
+        lineNumber++;
         QString line = in.readLine();
 
+        // search for translation comments
         QRegularExpressionMatch singleLineMatch = singleLine.match(line);
 
         if (singleLineMatch.hasMatch() && !multiLineStarted) {
 
-            QString package = singleLineMatch.captured(1);
-            if (package == QLatin1String("*")) {
-                package = QStringLiteral("Main");
-            } else {
-                package.replace(QChar('_'), QLatin1String(" "));
-            }
-
-            QString container = singleLineMatch.captured(2);
-            if (container == QLatin1String("*")) {
-                container = m_fileBaseName;
-            } else {
-                container.replace(QChar('_'), QLatin1String(" "));
-            }
-
-            QString key = singleLineMatch.captured(3);
-            QString text = singleLineMatch.captured(4);
-
-            saveTranslation(package, container, key, text);
+            result.entries.append(translationEntry(singleLineMatch.captured(1), singleLineMatch.captured(2), singleLineMatch.captured(3), singleLineMatch.captured(4), m_fileBaseName));
 
         } else {
 
@@ -127,73 +233,99 @@ void ScriptParser::parse()
                 multiLineStarted = true;
             }
 
+            const int multiLineEnd = multiLineStarted ? line.indexOf(QLatin1String("*/")) : -1;
+
             if (multiLineStarted) {
                 if (multiLineHeader.isEmpty()) {
                     multiLineHeader = line;
                 } else {
-                    multiLine.append(line).append(QLatin1String(" "));
+                    // markup is kept as it is, it will be escaped by the writers
+                    appendSimplified(multiLine, line, multiLineEnd < 0 ? line.size() : multiLineEnd);
                 }
             }
 
-            if (multiLineStarted && line.contains(multiLineEnd)) {
+            if (multiLineEnd >= 0) {
                 multiLineStarted = false;
-                multiLine.replace(QLatin1String("<"), QLatin1String("&lt;"));
-                multiLine.replace(QLatin1String(">"), QLatin1String("&gt;"));
-                multiLine.remove(multiLineEnd);
-                multiLine = multiLine.simplified();
                 multiLineHeader = multiLineHeader.simplified();
                 QRegularExpressionMatch match = multiLineMeta.match(multiLineHeader);
 
                 if (match.hasMatch()) {
-                    QString package = match.captured(1);
-                    if (package == QLatin1String("*")) {
-                        package = QStringLiteral("Main");
-                    } else {
-                        package.replace(QChar('_'), QLatin1String(" "));
-                    }
-
-                    QString container = match.captured(2);
-                    if (container == QLatin1String("*")) {
-                        container = m_fileBaseName;
-                    } else {
-                        container.replace(QChar('_'), QLatin1String(" "));
-                    }
-
-                    QString key = match.captured(3);
-
-                    saveTranslation(package, container, key, multiLine);
+                    result.entries.append(translationEntry(match.captured(1), match.captured(2), match.captured(3), multiLine, m_fileBaseName));
                 }
 
                 multiLine.clear();
+                multiLine.reserve(256);
                 multiLineHeader.clear();
             }
         }
+
+        // search for localization strings
+        QRegularExpressionMatchIterator i = locString.globalMatch(line);
+        while (i.hasNext()) {
+            QRegularExpressionMatch match = i.next();
+            result.references.append({match.captured(1), result.file, lineNumber, match.capturedStart(1) + 1});
+        }
+
+        // search for include directives
+        if (cache && line.contains(QLatin1String("include"))) {
+            QRegularExpressionMatch match = includeDirective.match(line);
+            if (match.hasMatch()) {
+                const QString included = cache->resolve(result.file, match.captured(1));
+                if (!included.isEmpty() && !result.includes.contains(included)) {
+                    result.includes.append(included);
+                }
+            }
+        }
     }
 
-    if (!in.seek(0)) {
-        qDebug("%s", qUtf8Printable(tr("Failed to reset position in file to the start.")));
+    m_file.close();
+
+    // parse the included files through the cache, so that every file is parsed only once
+    if (cache) {
+        for (int i = 0; i < result.includes.size(); ++i) {
+            cache->result(result.includes.at(i));
+        }
+    }
+
+    return result;
+}
+
+
+/*!
+ * \brief Saves the data of \a result and of all files included by it.
+ *
+ * Files that have already been added to \a refs are skipped, so that the data of every file is
+ * only applied once, no matter how many files include it or whether it has been parsed itself.
+ * Used key ids are added to \a refs.
+ *
+ * \since 1.1.0
+ */
+void ScriptParser::apply(const ScriptResult &result, ReferenceSet *refs)
+{
+    if (!refs->addFile(result.file)) {
         return;
     }
 
-    QRegularExpression locString(QStringLiteral("(str_[a-zA-Z0-9_]+)"), QRegularExpression::CaseInsensitiveOption);
+    for (int i = 0; i < result.entries.size(); ++i) {
+        const TranslationEntry &e = result.entries.at(i);
+        saveTranslation(e.package, e.container, e.key, e.text);
+    }
 
-    // start searching for localization strings without localization
-    uint lineNumber = 0;
-    while(!in.atEnd()) {
-        lineNumber++;
-        QString line = in.readLine();
+    for (int i = 0; i < result.references.size(); ++i) {
+        refs->add(result.references.at(i));
+    }
 
-        QRegularExpressionMatchIterator i = locString.globalMatch(line);
-        while (i.hasNext()) {
-            QRegularExpressionMatch match = i.next();
-            findLonelyTranslation(match.captured(1), lineNumber);
+    if (m_cache) {
+        for (int i = 0; i < result.includes.size(); ++i) {
+            const ScriptResult *included = m_cache->result(result.includes.at(i));
+            if (included) {
+                apply(*included, refs);
+            }
         }
     }
 }
 
 
-
-
 /*!
  * \brief Saves extracted translation strings.
  *
@@ -208,64 +340,136 @@ void ScriptParser::parse()
  */
 void ScriptParser::saveTranslation(const QString &package, const QString &container, const QString &key, const QString &text)
 {
-    m_sp->setTranslation(package, container, key, QStringLiteral("Original"), text);
+    Key *k = m_sp->insert({package, container, key, QStringLiteral("Original"), text});
 
-    Translation *savedOriginalTranslation = m_st->getTranslation(package, container, key, QStringLiteral("Original"));
+    if (!m_st) {
+        return;
+    }
+
+    // the translation might be owned by another key the stringtable key shares its translations with
+    Key *stKey = m_st->key(package, container, key);
+    Translation *savedOriginalTranslation = stKey ? stKey->getTranslation(QStringLiteral("Original")) : nullptr;
 
     if (savedOriginalTranslation) {
 
         if (QString::compare(savedOriginalTranslation->string(), text, Qt::CaseInsensitive) == 0) {
 
-            QList<Translation *> tl = m_st->getAllTranslations(package, container, key);
+            // the translations are shared with the stringtable instead of being copied
+            if (k) {
+                k->shareTranslations(stKey);
+            }
+        }
+    }
+}
 
-            if (!tl.isEmpty()) {
 
-                Key *k = m_sp->findChild<Package *>(package, Qt::FindDirectChildrenOnly)->findChild<Container *>(container, Qt::FindDirectChildrenOnly)->findChild<Key *>(key, Qt::FindDirectChildrenOnly);
 
-                for (int i = 0; i < tl.size(); ++i) {
-                    Translation *t = tl.at(i);
-                    if (t->objectName() != QLatin1String("Original")) {
+/*!
+ * \brief Extracts the translation string defined by a single TR \a comment.
+ *
+ * \a comment has to start with the comment marker. Block comments have to contain the whole
+ * comment including the end marker. The text of multiline comments is normalized like by extract().
+ * Used by scanners that find the comments themselves, like the ConfigScanner.
+ *
+ * \since 1.1.0
+ * \param comment         The comment text.
+ * \param fileBaseName    The base name of the file the comment is part of, used as container for \c *.
+ * \param entry           Pointer to the entry to set.
+ * \return                True if \a comment is a valid TR comment.
+ */
+bool ScriptParser::extractComment(const QString &comment, const QString &fileBaseName, TranslationEntry *entry)
+{
+    if (comment.startsWith(QLatin1String("//"))) {
 
-                        Translation *trans = new Translation(t->objectName(), t->string(), k);
-                        Q_UNUSED(trans)
+        const QRegularExpressionMatch match = singleLineExpression().match(comment);
 
-                    }
-                }
-            }
+        if (!match.hasMatch()) {
+            return false;
         }
+
+        *entry = translationEntry(match.captured(1), match.captured(2), match.captured(3), match.captured(4), fileBaseName);
+
+        return true;
+    }
+
+    // the meta data is read from the first line, the text from the following lines
+    const int headerEnd = comment.indexOf(QLatin1Char('\n'));
+
+    const QRegularExpressionMatch match = multiLineMetaExpression().match(comment.left(headerEnd < 0 ? comment.size() : headerEnd).simplified());
+
+    if (!match.hasMatch()) {
+        return false;
     }
+
+    QString text;
+
+    if (headerEnd >= 0) {
+        const int textEnd = comment.endsWith(QLatin1String("*/")) ? comment.size() - 2 : comment.size();
+        text.reserve(textEnd - headerEnd);
+        appendSimplified(text, comment.mid(headerEnd + 1), textEnd - headerEnd - 1);
+    }
+
+    *entry = translationEntry(match.captured(1), match.captured(2), match.captured(3), text, fileBaseName);
+
+    return true;
 }
 
 
+
 /*!
- * \brief Searches for translations in the stringtable.xml file and outputs strings without translation.
- * \since 1.0.0
- * \param key           ID of the translation key.
- * \param lineNumber    Current line number in the parsed file, for status messages.
+ * \brief Returns a new entry for the TR comment fields, with the \c * placeholders replaced.
+ *
+ * A \c * \a package is the \c Main package, a \c * \a container is the \a fileBaseName. Underscores
+ * in package and container names are replaced by spaces.
+ *
+ * \since 1.1.0
  */
-void ScriptParser::findLonelyTranslation(const QString &key, uint lineNumber)
+TranslationEntry ScriptParser::translationEntry(const QString &package, const QString &container, const QString &key, const QString &text, const QString &fileBaseName)
 {
-    // try to find the key in the current project object hierarchy
-    QList<Key*> spKeys = m_sp->findChildren<Key*>(QRegularExpression(key, QRegularExpression::CaseInsensitiveOption), Qt::FindChildrenRecursively);
+    TranslationEntry e{package, container, key, text};
 
-    if (spKeys.isEmpty()) {
+    if (e.package == QLatin1String("*")) {
+        e.package = QStringLiteral("Main");
+    } else {
+        e.package.replace(QChar('_'), QLatin1String(" "));
+    }
 
-        // try to find the key in the stringtable object hierarchy
-        QList<Key*> stKeys = m_st->findChildren<Key*>(QRegularExpression(key, QRegularExpression::CaseInsensitiveOption), Qt::FindChildrenRecursively);
+    if (e.container == QLatin1String("*")) {
+        e.container = fileBaseName;
+    } else {
+        e.container.replace(QChar('_'), QLatin1String(" "));
+    }
 
-        if (!stKeys.isEmpty()) {
-            Key *k = stKeys.first();
-            QList<Translation*> translations = k->findChildren<Translation*>(QString(), Qt::FindDirectChildrenOnly);
-            Container *c = qobject_cast<Container*>(k->parent());
-            Package *p = qobject_cast<Package*>(c->parent());
+    return e;
+}
 
-            if (!translations.isEmpty() && c && p) {
-                for (int i = 0; i < translations.size(); ++i) {
-                    m_sp->setTranslation(p->objectName(), c->objectName(), k->objectName(), translations.at(i)->objectName(), translations.at(i)->string());
-                }
-            }
+
+
+/*!
+ * \brief Appends the first \a length characters of \a line to \a buffer with normalized white space.
+ *
+ * Leading and trailing white space is dropped and every sequence of white space, including the
+ * line break to the text already in the buffer, is replaced by a single space. The result equals
+ * QString::simplified() on the joined lines, without building intermediate strings.
+ *
+ * \since 1.1.0
+ */
+void ScriptParser::appendSimplified(QString &buffer, const QString &line, int length)
+{
+    const QChar *c = line.constData();
+    const QChar *end = c + length;
+
+    bool space = !buffer.isEmpty();
+
+    for (; c != end; ++c) {
+        if (c->isSpace()) {
+            space = !buffer.isEmpty();
         } else {
-            qDebug("%s", qUtf8Printable(tr("ID without localization at line %1: %2").arg(QString::number(lineNumber), key)));
+            if (space) {
+                buffer.append(QLatin1Char(' '));
+                space = false;
+            }
+            buffer.append(*c);
         }
     }
 }
@@ -21,25 +21,46 @@
 
 #include <QObject>
 #include <QFile>
+#include "scriptresult.h"
+#include "a3trans_global.h"
 
 class Project;
+class IncludeCache;
+class ReferenceSet;
 
-class ScriptParser : public QObject
+class A3TRANS_EXPORT ScriptParser : public QObject
 {
     Q_OBJECT
 public:
     explicit ScriptParser(const QString &scriptFile, Project *stringTableProject, Project *scriptProject, QObject *parent = nullptr);
 
+    void setIncludeCache(IncludeCache *cache);
+
+    void setReferenceSet(ReferenceSet *references);
+
     void parse();
 
+    void parse(const ScriptResult &result);
+
+    ScriptResult extract(IncludeCache *cache = nullptr);
+
+    static bool extractComment(const QString &comment, const QString &fileBaseName, TranslationEntry *entry);
+
 private:
     QFile m_file;
     Project *m_st;
     Project *m_sp;
+    IncludeCache *m_cache;
+    ReferenceSet *m_refs;
     QString m_fileBaseName;
 
+    void apply(const ScriptResult &result, ReferenceSet *refs);
+
     void saveTranslation(const QString &package, const QString &container, const QString &key, const QString &text);
-    void findLonelyTranslation(const QString &key, uint lineNumber);
+
+    static TranslationEntry translationEntry(const QString &package, const QString &container, const QString &key, const QString &text, const QString &fileBaseName);
+
+    static void appendSimplified(QString &buffer, const QString &line, int length);
 };
 
 #endif // SCRIPTPARSER_H
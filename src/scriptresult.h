@@ -0,0 +1,69 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCRIPTRESULT_H
+#define SCRIPTRESULT_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/*!
+ * \brief A translation string defined by a TR comment.
+ * \since 1.1.0
+ */
+struct TranslationEntry
+{
+    QString package;
+    QString container;
+    QString key;
+    QString text;
+};
+
+/*!
+ * \brief An occurrence of a localization key id in a script file.
+ *
+ * For config files, \c context contains the path of the class the key is used in, like \c CfgVehicles/MyCar.
+ *
+ * \since 1.1.0
+ */
+struct Reference
+{
+    QString key;
+    QString file;
+    int line;
+    int column;
+    QString context;
+};
+
+/*!
+ * \brief The data extracted from a single script file.
+ *
+ * \c includes contains the absolute paths of all resolved files included by the script file.
+ *
+ * \since 1.1.0
+ */
+struct ScriptResult
+{
+    QString file;
+    QVector<TranslationEntry> entries;
+    QVector<Reference> references;
+    QStringList includes;
+};
+
+#endif // SCRIPTRESULT_H
@@ -0,0 +1,666 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server.h"
+#include "workspace.h"
+#include "key.h"
+#include "translation.h"
+#include "keyindex.h"
+#include "languages.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QThread>
+#include <QFileInfo>
+#include <QDir>
+#include <QSet>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QQueue>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+
+
+/*!
+ * \internal
+ * \brief Reads requests line by line from stdin and passes them to the Server in its thread.
+ *
+ * Reading stdin is done in a thread of its own, because there is no portable way to get notified
+ * about available data on stdin by the event loop. The thread only reads if data is available and
+ * checks for an interruption request in between, so that it can be stopped without terminating it.
+ */
+class StdinReader : public QThread
+{
+public:
+    explicit StdinReader(Server *server) : QThread(server), m_server(server) {}
+
+protected:
+    void run() override
+    {
+        QByteArray buffer;
+        QByteArray data;
+
+        while (!isInterruptionRequested()) {
+
+            if (!read(&data)) {
+                break;
+            }
+
+            buffer.append(data);
+
+            int end;
+            while ((end = buffer.indexOf('\n')) >= 0) {
+                QMetaObject::invokeMethod(m_server, "readStdin", Qt::QueuedConnection, Q_ARG(QByteArray, buffer.left(end + 1)));
+                buffer.remove(0, end + 1);
+            }
+        }
+
+        if (!isInterruptionRequested()) {
+            if (!buffer.isEmpty()) {
+                QMetaObject::invokeMethod(m_server, "readStdin", Qt::QueuedConnection, Q_ARG(QByteArray, buffer));
+            }
+            QMetaObject::invokeMethod(m_server, "stdinClosed", Qt::QueuedConnection);
+        }
+    }
+
+private:
+    Server *m_server;
+
+    /*!
+     * Waits up to 100 milliseconds for data on stdin and stores it in \a data, that is empty if
+     * there is none. Returns false if stdin has been closed.
+     */
+    static bool read(QByteArray *data)
+    {
+        data->clear();
+
+        char buf[4096];
+
+#ifdef Q_OS_WIN
+        HANDLE h = GetStdHandle(STD_INPUT_HANDLE);
+        DWORD available = 0;
+
+        if (GetFileType(h) == FILE_TYPE_PIPE) {
+            if (!PeekNamedPipe(h, nullptr, 0, nullptr, &available, nullptr)) {
+                return false;
+            }
+            if (available == 0) {
+                QThread::msleep(100);
+                return true;
+            }
+        } else if (GetFileType(h) == FILE_TYPE_CHAR && WaitForSingleObject(h, 100) != WAIT_OBJECT_0) {
+            return true;
+        }
+
+        DWORD r = 0;
+        if (!ReadFile(h, buf, available > 0 ? qMin<DWORD>(available, sizeof(buf)) : sizeof(buf), &r, nullptr) || r == 0) {
+            return false;
+        }
+#else
+        pollfd p;
+        p.fd = STDIN_FILENO;
+        p.events = POLLIN;
+        p.revents = 0;
+
+        const int ready = ::poll(&p, 1, 100);
+
+        if (ready == 0 || (ready < 0 && errno == EINTR)) {
+            return true;
+        }
+
+        ssize_t r;
+        do {
+            r = ::read(STDIN_FILENO, buf, sizeof(buf));
+        } while (r < 0 && errno == EINTR);
+
+        if (r <= 0) {
+            return false;
+        }
+#endif
+
+        data->append(buf, static_cast<int>(r));
+
+        return true;
+    }
+};
+
+
+
+/*!
+ * \class Server
+ * \brief Answers JSON-RPC 2.0 requests of editor integrations from a warm in-memory index.
+ *
+ * The server keeps the stringtable.xml project of a Workspace and its key index loaded and answers
+ * requests that are sent as one JSON object per line, either on stdin/stdout or on a local socket.
+ * Responses are written as one JSON object per line, too. Notifications, requests without id,
+ * are processed but not answered.
+ *
+ * Supported methods:
+ * \li \c lookup with parameter \c id returns the package, container and translations of a key or null.
+ * \li \c complete with parameter \c prefix and optional \c limit returns the keys starting with the prefix.
+ * \li \c diagnostics with parameter \c file returns the key ids used in the file that have no localization.
+ * \li \c shutdown stops the server.
+ *
+ * The stringtable.xml file and all files diagnostics have been requested for are watched. If the
+ * stringtable.xml file changes, it is loaded again right away, if a script or config file changes,
+ * only this file will be parsed again on the next request.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new Server object for the \a workspace and loads its stringtable.xml file.
+ * \since 1.1.0
+ * \param workspace The workspace to answer requests for. The server does not take ownership.
+ * \param parent    Pointer to the parent object.
+ */
+Server::Server(Workspace *workspace, QObject *parent) :
+    QObject(parent), m_workspace(workspace), m_server(nullptr), m_reader(nullptr), m_includes(workspace->workingDir())
+{
+    m_stringTablePath = QDir(workspace->workingDir()).absoluteFilePath(QStringLiteral("stringtable.xml"));
+
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &Server::fileChanged);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &Server::directoryChanged);
+
+    // requests only use the loaded project, so a stringtable.xml file created later has to be noticed, too
+    m_watcher.addPath(workspace->workingDir());
+
+    if (QFileInfo::exists(m_stringTablePath)) {
+        watch(m_stringTablePath);
+    }
+
+    m_workspace->stringTable();
+}
+
+
+
+/*!
+ * \brief Deconstructs the Server object.
+ */
+Server::~Server()
+{
+    if (m_reader) {
+        // the reader checks for the interruption at least every 100 milliseconds
+        m_reader->requestInterruption();
+        m_reader->wait();
+    }
+}
+
+
+
+/*!
+ * \brief Starts listening for clients on the local socket \a socketName.
+ *
+ * On Unix, \a socketName can be the path of the socket file. A stale socket file of a crashed
+ * server will be removed, but the socket of a server that is still running is not taken over.
+ *
+ * \since 1.1.0
+ * \return True on success.
+ */
+bool Server::listen(const QString &socketName)
+{
+    if (!m_server) {
+        m_server = new QLocalServer(this);
+        connect(m_server, &QLocalServer::newConnection, this, &Server::newConnection);
+    }
+
+    {
+        QLocalSocket probe;
+        probe.connectToServer(socketName);
+        if (probe.waitForConnected(1000)) {
+            probe.disconnectFromServer();
+            qCritical("%s", qUtf8Printable(tr("Failed to listen on socket %1: %2").arg(socketName, tr("Another server is already listening."))));
+            return false;
+        }
+    }
+
+    // nobody is listening anymore, so the socket is left over by a crashed server
+    QLocalServer::removeServer(socketName);
+
+    if (!m_server->listen(socketName)) {
+        qCritical("%s", qUtf8Printable(tr("Failed to listen on socket %1: %2").arg(socketName, m_server->errorString())));
+        return false;
+    }
+
+    qInfo("%s", qUtf8Printable(tr("Listening on socket: %1").arg(m_server->fullServerName())));
+
+    return true;
+}
+
+
+
+/*!
+ * \brief Starts reading requests from stdin and writing responses to stdout.
+ *
+ * The finished() signal is emitted when stdin has been closed.
+ *
+ * \since 1.1.0
+ */
+void Server::serveStdio()
+{
+    if (m_reader) {
+        return;
+    }
+
+    m_stdout.open(stdout, QIODevice::WriteOnly);
+
+    m_reader = new StdinReader(this);
+    m_reader->start();
+}
+
+
+
+/*!
+ * \brief Processes a single JSON-RPC \a message and returns the response.
+ *
+ * Returns an empty byte array for notifications. The response does not contain a trailing new line.
+ *
+ * \since 1.1.0
+ */
+QByteArray Server::handle(const QByteArray &message)
+{
+    QJsonParseError pe;
+    const QJsonDocument doc = QJsonDocument::fromJson(message, &pe);
+
+    if (pe.error != QJsonParseError::NoError || !doc.isObject()) {
+        return error(QJsonValue(), -32700, QStringLiteral("Parse error"));
+    }
+
+    const QJsonObject req = doc.object();
+    const QJsonValue id = req.value(QStringLiteral("id"));
+    const bool notification = !req.contains(QStringLiteral("id"));
+    const QString method = req.value(QStringLiteral("method")).toString();
+    const QJsonObject params = req.value(QStringLiteral("params")).toObject();
+
+    QJsonValue result;
+    QByteArray err;
+
+    if (method == QLatin1String("lookup")) {
+
+        if (!params.value(QStringLiteral("id")).isString()) {
+            err = error(id, -32602, QStringLiteral("Missing parameter: id"));
+        } else {
+            result = lookup(params);
+        }
+
+    } else if (method == QLatin1String("complete")) {
+
+        if (!params.value(QStringLiteral("prefix")).isString()) {
+            err = error(id, -32602, QStringLiteral("Missing parameter: prefix"));
+        } else {
+            result = complete(params);
+        }
+
+    } else if (method == QLatin1String("diagnostics")) {
+
+        if (!params.value(QStringLiteral("file")).isString()) {
+            err = error(id, -32602, QStringLiteral("Missing parameter: file"));
+        } else {
+            bool ok = true;
+            result = diagnostics(params, &ok);
+            if (!ok) {
+                err = error(id, -32602, QStringLiteral("File not found: %1").arg(params.value(QStringLiteral("file")).toString()));
+            }
+        }
+
+    } else if (method == QLatin1String("shutdown")) {
+
+        QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+
+    } else if (method.isEmpty()) {
+
+        err = error(id, -32600, QStringLiteral("Invalid request"));
+
+    } else {
+
+        err = error(id, -32601, QStringLiteral("Method not found: %1").arg(method));
+
+    }
+
+    // notifications are never answered, not even with an error
+    if (notification) {
+        return QByteArray();
+    }
+
+    return err.isEmpty() ? response(id, result) : err;
+}
+
+
+
+/*!
+ * \brief Accepts new clients on the local socket.
+ * \since 1.1.0
+ */
+void Server::newConnection()
+{
+    while (m_server->hasPendingConnections()) {
+        QLocalSocket *s = m_server->nextPendingConnection();
+        connect(s, &QLocalSocket::readyRead, this, &Server::readClient);
+        connect(s, &QLocalSocket::disconnected, s, &QObject::deleteLater);
+    }
+}
+
+
+
+/*!
+ * \brief Answers all complete requests a client has sent.
+ * \since 1.1.0
+ */
+void Server::readClient()
+{
+    QLocalSocket *s = qobject_cast<QLocalSocket*>(sender());
+
+    if (!s) {
+        return;
+    }
+
+    while (s->canReadLine()) {
+        const QByteArray line = s->readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        const QByteArray r = handle(line);
+        if (!r.isEmpty()) {
+            s->write(r);
+            s->write("\n");
+        }
+    }
+}
+
+
+
+/*!
+ * \brief Answers a request \a line read from stdin.
+ * \since 1.1.0
+ */
+void Server::readStdin(const QByteArray &line)
+{
+    const QByteArray l = line.trimmed();
+
+    if (l.isEmpty()) {
+        return;
+    }
+
+    const QByteArray r = handle(l);
+
+    if (!r.isEmpty()) {
+        m_stdout.write(r);
+        m_stdout.write("\n");
+        m_stdout.flush();
+    }
+}
+
+
+
+/*!
+ * \brief Stops serving when stdin has been closed by the client.
+ * \since 1.1.0
+ */
+void Server::stdinClosed()
+{
+    emit finished();
+}
+
+
+
+/*!
+ * \brief Updates the index when the watched file at \a path has changed.
+ * \since 1.1.0
+ */
+void Server::fileChanged(const QString &path)
+{
+    if (path == m_stringTablePath) {
+        qInfo("%s", qUtf8Printable(tr("Reloading changed file: %1").arg(path)));
+        m_workspace->invalidate();
+        m_workspace->stringTable();
+    } else {
+        m_includes.remove(path);
+    }
+
+    // files replaced by renaming another file are no longer watched
+    if (QFileInfo::exists(path)) {
+        watch(path);
+    }
+}
+
+
+
+/*!
+ * \brief Loads the stringtable.xml file if it has been created in the watched working directory at \a path.
+ * \since 1.1.0
+ */
+void Server::directoryChanged(const QString &path)
+{
+    Q_UNUSED(path)
+
+    if (!m_watcher.files().contains(m_stringTablePath) && QFileInfo::exists(m_stringTablePath)) {
+        fileChanged(m_stringTablePath);
+    }
+}
+
+
+
+/*!
+ * \brief Returns the package, container and translations of the key given by the \c id parameter.
+ * \since 1.1.0
+ */
+QJsonValue Server::lookup(const QJsonObject &params)
+{
+    // the watcher reloads the changed stringtable.xml file, so the file is not checked per request
+    const KeyIndex *index = m_workspace->loadedKeyIndex();
+    const Key *k = index ? index->find(params.value(QStringLiteral("id")).toString()) : nullptr;
+
+    if (!k) {
+        return QJsonValue(QJsonValue::Null);
+    }
+
+    const QObject *c = k->parent();
+    const QObject *p = c ? c->parent() : nullptr;
+
+    QJsonObject translations;
+    const QList<Translation*> ts = k->getAllTranslations();
+    for (int i = 0; i < ts.size(); ++i) {
+        translations.insert(ts.at(i)->objectName(), ts.at(i)->string());
+    }
+
+    QJsonObject o;
+    o.insert(QStringLiteral("id"), k->objectName());
+    o.insert(QStringLiteral("package"), p ? p->objectName() : QString());
+    o.insert(QStringLiteral("container"), c ? c->objectName() : QString());
+    o.insert(QStringLiteral("file"), m_stringTablePath);
+    o.insert(QStringLiteral("translations"), translations);
+
+    return o;
+}
+
+
+
+/*!
+ * \brief Returns the keys starting with the \c prefix parameter together with their source language text.
+ *
+ * The prefix is compared case insensitive, the keys are ordered by id. At most \c limit keys are returned, 100 by default, 0 for no limit.
+ *
+ * \since 1.1.0
+ */
+QJsonValue Server::complete(const QJsonObject &params)
+{
+    const QString prefix = params.value(QStringLiteral("prefix")).toString();
+    const int limit = params.value(QStringLiteral("limit")).toInt(100);
+    const QString srcLang = Languages::codeToString(m_workspace->options().srcLang);
+
+    QJsonArray items;
+
+    const KeyIndex *index = m_workspace->loadedKeyIndex();
+
+    if (!index) {
+        return items;
+    }
+
+    const QVector<Key*> ks = index->withPrefix(prefix, limit);
+
+    for (int i = 0; i < ks.size(); ++i) {
+        const Key *k = ks.at(i);
+        const Translation *t = k->getTranslation(srcLang);
+        QJsonObject o;
+        o.insert(QStringLiteral("id"), k->objectName());
+        o.insert(QStringLiteral("text"), t ? t->string() : QString());
+        items.append(o);
+    }
+
+    return items;
+}
+
+
+
+/*!
+ * \brief Returns the key ids used in the file given by the \c file parameter that have no localization.
+ *
+ * Ids are resolved against the stringtable.xml file and the TR comments of the file and all files it includes directly or indirectly.
+ * Relative paths are resolved against the working directory. \a ok is set to false if the file does not exist.
+ *
+ * \since 1.1.0
+ */
+QJsonValue Server::diagnostics(const QJsonObject &params, bool *ok)
+{
+    const QFileInfo fi(QDir(m_workspace->workingDir()), params.value(QStringLiteral("file")).toString());
+
+    if (!fi.isFile()) {
+        *ok = false;
+        return QJsonValue();
+    }
+
+    const QString path = QDir::cleanPath(fi.absoluteFilePath());
+
+    watch(path);
+
+    QJsonArray ds;
+
+    const ScriptResult *r = m_includes.result(path);
+
+    if (!r) {
+        return ds;
+    }
+
+    const KeyIndex *index = m_workspace->loadedKeyIndex();
+
+    // ids defined by TR comments will be added to the stringtable.xml file on the next extraction,
+    // the files included by included files are followed, too
+    QSet<QString> defined;
+    QSet<QString> visited({path});
+    QQueue<const ScriptResult*> pending;
+    pending.enqueue(r);
+
+    while (!pending.isEmpty()) {
+        const ScriptResult *ir = pending.dequeue();
+        for (int i = 0; i < ir->entries.size(); ++i) {
+            defined.insert(KeyIndex::normalize(ir->entries.at(i).key));
+        }
+        for (int i = 0; i < ir->includes.size(); ++i) {
+            const QString &include = ir->includes.at(i);
+            if (visited.contains(include)) {
+                continue;
+            }
+            visited.insert(include);
+            watch(include);
+            const ScriptResult *next = m_includes.result(include);
+            if (next) {
+                pending.enqueue(next);
+            }
+        }
+    }
+
+    for (int i = 0; i < r->references.size(); ++i) {
+        const Reference &ref = r->references.at(i);
+        if (defined.contains(KeyIndex::normalize(ref.key)) || (index && index->find(ref.key))) {
+            continue;
+        }
+        QJsonObject d;
+        d.insert(QStringLiteral("rule"), QStringLiteral("unresolved-id"));
+        d.insert(QStringLiteral("level"), QStringLiteral("warning"));
+        d.insert(QStringLiteral("key"), ref.key);
+        d.insert(QStringLiteral("message"), tr("ID without localization"));
+        d.insert(QStringLiteral("line"), ref.line);
+        d.insert(QStringLiteral("column"), ref.column);
+        if (!ref.context.isEmpty()) {
+            d.insert(QStringLiteral("context"), ref.context);
+        }
+        ds.append(d);
+    }
+
+    return ds;
+}
+
+
+
+/*!
+ * \brief Adds the file at \a path to the watched files if it is not watched already.
+ * \since 1.1.0
+ */
+void Server::watch(const QString &path)
+{
+    if (!m_watcher.files().contains(path)) {
+        m_watcher.addPath(path);
+    }
+}
+
+
+
+/*!
+ * \brief Returns the compact JSON-RPC response with \a result for the request with \a id.
+ * \since 1.1.0
+ */
+QByteArray Server::response(const QJsonValue &id, const QJsonValue &result)
+{
+    QJsonObject o;
+    o.insert(QStringLiteral("jsonrpc"), QStringLiteral("2.0"));
+    o.insert(QStringLiteral("id"), id);
+    o.insert(QStringLiteral("result"), result);
+
+    return QJsonDocument(o).toJson(QJsonDocument::Compact);
+}
+
+
+
+/*!
+ * \brief Returns the compact JSON-RPC error response with \a code and \a message for the request with \a id.
+ * \since 1.1.0
+ */
+QByteArray Server::error(const QJsonValue &id, int code, const QString &message)
+{
+    QJsonObject e;
+    e.insert(QStringLiteral("code"), code);
+    e.insert(QStringLiteral("message"), message);
+
+    QJsonObject o;
+    o.insert(QStringLiteral("jsonrpc"), QStringLiteral("2.0"));
+    o.insert(QStringLiteral("id"), id.isUndefined() ? QJsonValue(QJsonValue::Null) : id);
+    o.insert(QStringLiteral("error"), e);
+
+    return QJsonDocument(o).toJson(QJsonDocument::Compact);
+}
@@ -0,0 +1,78 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <QObject>
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QJsonObject>
+#include <QJsonValue>
+#include "includecache.h"
+#include "a3trans_global.h"
+
+class Workspace;
+class QLocalServer;
+class QThread;
+
+class A3TRANS_EXPORT Server : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Server(Workspace *workspace, QObject *parent = nullptr);
+    ~Server();
+
+    bool listen(const QString &socketName);
+
+    void serveStdio();
+
+    QByteArray handle(const QByteArray &message);
+
+signals:
+    void finished();
+
+private slots:
+    void newConnection();
+    void readClient();
+    void readStdin(const QByteArray &line);
+    void stdinClosed();
+    void fileChanged(const QString &path);
+    void directoryChanged(const QString &path);
+
+private:
+    Q_DISABLE_COPY(Server)
+
+    Workspace *m_workspace;
+    QLocalServer *m_server;
+    QThread *m_reader;
+    QFile m_stdout;
+    QFileSystemWatcher m_watcher;
+    IncludeCache m_includes;
+    QString m_stringTablePath;
+
+    QJsonValue lookup(const QJsonObject &params);
+    QJsonValue complete(const QJsonObject &params);
+    QJsonValue diagnostics(const QJsonObject &params, bool *ok);
+    void watch(const QString &path);
+
+    static QByteArray response(const QJsonValue &id, const QJsonValue &result);
+    static QByteArray error(const QJsonValue &id, int code, const QString &message);
+};
+
+#endif // SERVER_H
@@ -0,0 +1,302 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stringtablemerger.h"
+#include "project.h"
+#include "package.h"
+#include "container.h"
+#include "key.h"
+#include "translation.h"
+#include <QStringList>
+#include <algorithm>
+
+
+
+/*!
+ * \class StringtableMerger
+ * \brief Merges freshly extracted translation strings into an existing stringtable project.
+ *
+ * Instead of regenerating the whole stringtable, the merger computes the per key operations
+ * (add, remove, change and conflict) that are needed to bring the stringtable project in line
+ * with the extracted project and applies only these operations. All projects are flattened into
+ * key streams sorted by package, container and case folded key id, so that the operations can be
+ * computed in a single linear walk over the streams.
+ *
+ * If an ancestor project is given, a three-way merge is performed: keys that have only been
+ * changed or added in the stringtable are kept and keys that have only been removed from it stay
+ * removed. Keys that have been changed on both sides, or changed on one side and removed on the
+ * other, are reported as conflicts. Changes are resolved in favor of the extracted strings, and
+ * removed keys are kept or added again.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new StringtableMerger object.
+ * \since 1.1.0
+ * \param stringTableProject    Pointer to the project containing the current stringtable.xml data. The merge result will be stored in it.
+ * \param extractedProject      Pointer to the project containing the strings extracted from the script files.
+ * \param ancestorProject       Pointer to the project containing the common ancestor of both. Default: nullptr
+ * \param parent                Pointer to the parent object.
+ */
+StringtableMerger::StringtableMerger(Project *stringTableProject, Project *extractedProject, Project *ancestorProject, QObject *parent) :
+    QObject(parent), m_st(stringTableProject), m_ex(extractedProject), m_anc(ancestorProject)
+{
+
+}
+
+
+
+/*!
+ * \brief Computes the delta between the projects and applies it to the stringtable project.
+ * \since 1.1.0
+ */
+void StringtableMerger::merge()
+{
+    if (!m_st || !m_ex) {
+        qFatal("We have no valid Project object.");
+        return;
+    }
+
+    compute();
+    apply();
+
+    qInfo("%s", qUtf8Printable(tr("Merged stringtable: %1 added, %2 removed, %3 changed, %4 conflicts.").arg(count(Add)).arg(count(Remove)).arg(count(Change)).arg(count(Conflict))));
+}
+
+
+
+/*!
+ * \brief Returns the number of computed operations of type \a op.
+ * \since 1.1.0
+ */
+int StringtableMerger::count(Operation op) const
+{
+    int c = 0;
+    for (int i = 0; i < m_deltas.size(); ++i) {
+        if (m_deltas.at(i).op == op) {
+            c++;
+        }
+    }
+    return c;
+}
+
+
+
+/*!
+ * \brief Returns all keys of the project \a prj, sorted by package, container and case folded key id.
+ * \since 1.1.0
+ */
+QVector<StringtableMerger::Entry> StringtableMerger::flatten(Project *prj)
+{
+    QVector<Entry> entries;
+
+    if (!prj) {
+        return entries;
+    }
+
+    const QList<Package*> ps = prj->findChildren<Package*>(QString(), Qt::FindDirectChildrenOnly);
+    for (int i = 0; i < ps.size(); ++i) {
+        const QList<Container*> cs = ps.at(i)->findChildren<Container*>(QString(), Qt::FindDirectChildrenOnly);
+        for (int j = 0; j < cs.size(); ++j) {
+            const QList<Key*> ks = cs.at(j)->findChildren<Key*>(QString(), Qt::FindDirectChildrenOnly);
+            for (int k = 0; k < ks.size(); ++k) {
+                Entry e;
+                e.sortKey = ps.at(i)->objectName() + QChar(0x1f) + cs.at(j)->objectName() + QChar(0x1f) + ks.at(k)->objectName().toCaseFolded();
+                e.key = ks.at(k);
+                entries.append(e);
+            }
+        }
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.sortKey < b.sortKey;
+    });
+
+    return entries;
+}
+
+
+
+/*!
+ * \brief Returns the original string of \a key or a null string if there is none.
+ * \since 1.1.0
+ */
+QString StringtableMerger::original(const Key *key)
+{
+    Translation *t = key ? key->getTranslation(QStringLiteral("Original")) : nullptr;
+    return t ? t->string() : QString();
+}
+
+
+
+/*!
+ * \brief Walks the sorted key streams and computes the operations needed to merge them.
+ * \since 1.1.0
+ */
+void StringtableMerger::compute()
+{
+    m_deltas.clear();
+
+    const QVector<Entry> st = flatten(m_st);
+    const QVector<Entry> ex = flatten(m_ex);
+    const QVector<Entry> anc = flatten(m_anc);
+
+    int s = 0;
+    int e = 0;
+    int a = 0;
+
+    while (s < st.size() || e < ex.size()) {
+
+        QString current;
+        if (s >= st.size()) {
+            current = ex.at(e).sortKey;
+        } else if (e >= ex.size()) {
+            current = st.at(s).sortKey;
+        } else {
+            current = qMin(st.at(s).sortKey, ex.at(e).sortKey);
+        }
+
+        Key *stKey = (s < st.size() && st.at(s).sortKey == current) ? st.at(s).key : nullptr;
+        Key *exKey = (e < ex.size() && ex.at(e).sortKey == current) ? ex.at(e).key : nullptr;
+
+        while (a < anc.size() && anc.at(a).sortKey < current) {
+            a++;
+        }
+        Key *ancKey = (a < anc.size() && anc.at(a).sortKey == current) ? anc.at(a).key : nullptr;
+
+        if (stKey) {
+            s++;
+        }
+        if (exKey) {
+            e++;
+        }
+
+        if (exKey && !stKey) {
+
+            if (!m_anc || !ancKey) {
+                m_deltas.append({Add, nullptr, exKey, true});
+            } else if (original(ancKey) != original(exKey)) {
+                qWarning("%s", qUtf8Printable(tr("Conflict: %1 has been removed from the stringtable but changed in the scripts. Adding it again.").arg(exKey->objectName())));
+                m_deltas.append({Conflict, nullptr, exKey, true});
+            }
+            // if the scripts still contain the string of the ancestor, the key has only been removed from the stringtable
+
+        } else if (stKey && !exKey) {
+
+            if (!m_anc) {
+                m_deltas.append({Remove, stKey, nullptr, false});
+            } else if (ancKey && original(ancKey) == original(stKey)) {
+                m_deltas.append({Remove, stKey, nullptr, false});
+            } else if (ancKey) {
+                qWarning("%s", qUtf8Printable(tr("Conflict: %1 has been changed in the stringtable but removed from the scripts. Keeping it.").arg(stKey->objectName())));
+                m_deltas.append({Conflict, stKey, nullptr, true});
+            }
+            // if the ancestor does not know the key, it has only been added to the stringtable
+
+        } else {
+
+            const QString stOrig = original(stKey);
+            const QString exOrig = original(exKey);
+
+            if (stOrig == exOrig) {
+                continue;
+            }
+
+            const bool keep = QString::compare(stOrig, exOrig, Qt::CaseInsensitive) == 0;
+
+            if (!m_anc) {
+                m_deltas.append({Change, stKey, exKey, keep});
+            } else {
+                const QString ancOrig = original(ancKey);
+                if (ancKey && stOrig == ancOrig) {
+                    m_deltas.append({Change, stKey, exKey, keep});
+                } else if (ancKey && exOrig == ancOrig) {
+                    // only changed in the stringtable, keep it
+                } else {
+                    qWarning("%s", qUtf8Printable(tr("Conflict: %1 has been changed in the stringtable and in the scripts. Using the string from the scripts.").arg(stKey->objectName())));
+                    m_deltas.append({Conflict, stKey, exKey, keep});
+                }
+            }
+        }
+    }
+}
+
+
+
+/*!
+ * \brief Applies the computed operations to the stringtable project.
+ * \since 1.1.0
+ */
+void StringtableMerger::apply()
+{
+    for (int i = 0; i < m_deltas.size(); ++i) {
+        const Delta &d = m_deltas.at(i);
+
+        if (d.op == Add || (d.op == Conflict && !d.existing)) {
+
+            Container *c = qobject_cast<Container*>(d.extracted->parent());
+            Package *p = c ? qobject_cast<Package*>(c->parent()) : nullptr;
+
+            if (c && p) {
+                const QList<Translation*> ts = d.extracted->getAllTranslations();
+                for (int j = 0; j < ts.size(); ++j) {
+                    m_st->setTranslation(p->objectName(), c->objectName(), d.extracted->objectName(), ts.at(j)->objectName(), ts.at(j)->string());
+                }
+            }
+
+        } else if (d.op == Remove) {
+
+            Container *c = qobject_cast<Container*>(d.existing->parent());
+            delete d.existing;
+
+            if (c && c->children().isEmpty()) {
+                QObject *p = c->parent();
+                delete c;
+                if (p && p->children().isEmpty()) {
+                    delete p;
+                }
+            }
+
+        } else if (d.extracted) {
+
+            // Change or Conflict resolved in favor of the extracted strings
+            d.existing->setTranslation(QStringLiteral("Original"), original(d.extracted));
+
+            if (!d.keepTranslations) {
+                // the languages are copied first, removing a translation detaches shared ones
+                QStringList langs;
+                const QList<Translation*> ts = d.existing->getAllTranslations();
+                for (int j = 0; j < ts.size(); ++j) {
+                    if (ts.at(j)->objectName() != QLatin1String("Original")) {
+                        langs.append(ts.at(j)->objectName());
+                    }
+                }
+                for (int j = 0; j < langs.size(); ++j) {
+                    d.existing->setTranslation(langs.at(j), QString());
+                }
+            }
+        }
+    }
+}
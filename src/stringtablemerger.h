@@ -0,0 +1,73 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STRINGTABLEMERGER_H
+#define STRINGTABLEMERGER_H
+
+#include <QObject>
+#include <QVector>
+#include "a3trans_global.h"
+
+class Project;
+class Key;
+
+class A3TRANS_EXPORT StringtableMerger : public QObject
+{
+    Q_OBJECT
+public:
+    enum Operation {
+        Add,
+        Remove,
+        Change,
+        Conflict
+    };
+
+    explicit StringtableMerger(Project *stringTableProject, Project *extractedProject, Project *ancestorProject = nullptr, QObject *parent = nullptr);
+
+    void merge();
+
+    int count(Operation op) const;
+
+private:
+    Q_DISABLE_COPY(StringtableMerger)
+
+    struct Entry {
+        QString sortKey;
+        Key *key;
+    };
+
+    struct Delta {
+        Operation op;
+        Key *existing;
+        Key *extracted;
+        bool keepTranslations;
+    };
+
+    Project *m_st;
+    Project *m_ex;
+    Project *m_anc;
+    QVector<Delta> m_deltas;
+
+    static QVector<Entry> flatten(Project *prj);
+    static QString original(const Key *key);
+
+    void compute();
+    void apply();
+};
+
+#endif // STRINGTABLEMERGER_H
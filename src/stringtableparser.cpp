@@ -18,23 +18,35 @@
 
 #include "stringtableparser.h"
 #include "project.h"
-#include "package.h"
-#include "container.h"
 #include "key.h"
+#include "container.h"
+#include "package.h"
 #include "translation.h"
-#include <QDomDocument>
-#include <QDomNodeList>
-#include <QDomElement>
-#include <QTextStream>
+#include <QXmlStreamReader>
+#include <QTextCodec>
 
 
 /*!
  * \class StringtableParser
  * \brief Provides methods and functions to extract translation strings from a stringtable.xml file.
  *
+ * The file is read as a stream of XML tokens, without building a document tree. If a language
+ * projection has been set via setLanguages(), elements of other languages are skipped while
+ * reading and no Translation objects are created for them.
+ *
+ * The loaded project reflects the file: every Package, Container and Key element is loaded into
+ * an object of its own, so keys whose ids only differ in case or that are used twice are not
+ * merged, empty language elements are loaded as empty translations and containers without keys
+ * and packages without containers are kept. Package, Container and Key elements nested in unknown
+ * elements are found, too. Their enclosing unknown elements are not kept, only the markup inside
+ * of them.
+ *
+ * The file is decoded with the encoding of its byte order mark or its XML declaration, UTF-8
+ * is assumed if there is neither.
+ *
  * \since 1.0.0
- * \version 1.0.0
- * \date 2016-09-05
+ * \version 1.1.0
+ * \date 2016-10-18
  * \author Buschmann
  * \copyright GNU GENERAL PUBLIC LICENSE Version 3
  */
@@ -51,106 +63,345 @@ StringtableParser::StringtableParser(const QString &stringTable, QObject *parent
 }
 
 
+/*!
+ * \brief Only loads the translations into the \a languages given by name, like \c Original or \c German.
+ *
+ * An empty list loads all languages, what is the default. The elements of other languages are
+ * not kept, so a project loaded with a language projection must not be written back.
+ *
+ * \since 1.1.0
+ */
+void StringtableParser::setLanguages(const QStringList &languages)
+{
+    m_languages = languages;
+}
+
+
 /*!
  * \brief Starts the parsing process and returns a pointer to a Project object.
+ *
+ * Comments, processing instructions, unknown elements and unknown attributes are kept as raw
+ * markup in the PassThrough data of the following Package, Container or Key object, or of the
+ * enclosing one if they follow its last child.
+ *
  * \return Project object containing the extracted data.
  */
 Project *StringtableParser::parse()
 {
-    if (!m_stringtable.open(QIODevice::ReadOnly|QIODevice::Text)) {
+    if (!m_stringtable.open(QIODevice::ReadOnly)) {
         qCritical("%s", qUtf8Printable(tr("Failed to open file.")));
         return nullptr;
     }
 
-    QDomDocument st(QStringLiteral("stringtable"));
+    // the decoded data is kept, so that raw markup can be sliced out of it by the character offsets
+    QString data = decode(m_stringtable.readAll());
 
-    if (!st.setContent(&m_stringtable)) {
-        qCritical("%s", qUtf8Printable(tr("Failed to parse XML data.")));
-        m_stringtable.close();
-        return nullptr;
-    }
-    
     m_stringtable.close();
 
-    QDomElement project = st.documentElement();
-
-    if (project.isNull() || !project.hasChildNodes() || project.tagName() != QLatin1String("Project")) {
-        qCritical("%s", qUtf8Printable(tr("Failed to parse XML data.")));
-        return nullptr;
+    if (data.startsWith(QChar(0xFEFF))) {
+        data.remove(0, 1);
     }
 
-    QString projectName = project.attribute(QStringLiteral("name"), QStringLiteral("My Project"));
-
-    Project *proj = new Project(projectName);
+    // line breaks are normalized by the XML parser anyway, the StringtableWriter writes raw markup with the line breaks of the platform
+    data.replace(QLatin1String("\r\n"), QLatin1String("\n"));
 
+    QXmlStreamReader xml(data);
 
-    QDomNodeList packages = project.elementsByTagName(QStringLiteral("Package"));
+    QStringList raw;
 
-    if (packages.isEmpty()) {
-        qWarning("%s", qUtf8Printable(tr("Can not find Package node elements.")));
-        delete proj;
+    if (!nextChild(xml, data, QString(), raw) || xml.name() != QLatin1String("Project")) {
+        qCritical("%s", qUtf8Printable(tr("Failed to parse XML data.")));
         return nullptr;
     }
 
-    for (int i = 0; i < packages.size(); ++i) {
-        QDomElement package = packages.at(i).toElement();
-        if (!package.isNull() && package.hasChildNodes()) {
+    const QStringRef nameAttribute = xml.attributes().value(QStringLiteral("name"));
+
+    Project *proj = new Project(nameAttribute.isNull() ? QStringLiteral("My Project") : nameAttribute.toString());
+    proj->passThrough().before = raw;
+    proj->passThrough().attributes = unknownAttributes(xml, data, QStringLiteral("name"));
+    raw.clear();
 
-            Package *pac = new Package(package.attribute(QStringLiteral("name")), proj);
+    bool hasPackages = false;
+    int packageWrappers = 0;
 
-            QDomNodeList containers = package.elementsByTagName(QStringLiteral("Container"));
+    // every element is loaded into its own object, like it is in the file, also if its name or id is used more than once
+    while (nextChild(xml, data, QStringLiteral("Package"), raw, &packageWrappers)) {
 
-            if (containers.isEmpty()) {
-                delete pac;
-            } else {
+        hasPackages = true;
 
-                for (int j = 0; j < containers.size(); ++j) {
-                    QDomElement container = containers.at(j).toElement();
+        Package *package = new Package(xml.attributes().value(QStringLiteral("name")).toString(), proj);
+        package->passThrough().before = raw;
+        package->passThrough().attributes = unknownAttributes(xml, data, QStringLiteral("name"));
+        raw.clear();
 
-                    if (!container.isNull() && container.hasChildNodes()) {
+        int containerWrappers = 0;
 
-                        Container *cont = new Container(container.attribute(QStringLiteral("name")), pac);
+        while (nextChild(xml, data, QStringLiteral("Container"), raw, &containerWrappers)) {
 
-                        QDomNodeList keys = container.elementsByTagName(QStringLiteral("Key"));
+            Container *container = new Container(xml.attributes().value(QStringLiteral("name")).toString(), package);
+            container->passThrough().before = raw;
+            container->passThrough().attributes = unknownAttributes(xml, data, QStringLiteral("name"));
+            raw.clear();
 
-                        if (keys.isEmpty()) {
-                            delete cont;
-                        } else {
+            int keyWrappers = 0;
 
-                            for (int k = 0; k < keys.size(); ++k) {
-                                QDomElement currentKey = keys.at(k).toElement();
-                                QString id = currentKey.attribute(QStringLiteral("ID"));
-                                if (!id.isEmpty() && currentKey.hasChildNodes()) {
+            while (nextChild(xml, data, QStringLiteral("Key"), raw, &keyWrappers)) {
 
-                                    Key *key = new Key(id, cont);
+                const QString id = xml.attributes().value(QStringLiteral("ID")).toString();
 
-                                    QDomNodeList translations = currentKey.childNodes();
+                if (id.isEmpty()) {
+                    raw.append(skipElement(xml, data));
+                    continue;
+                }
+
+                Key *key = new Key(id, container);
+                PassThrough &keyRaw = key->passThrough();
+                keyRaw.before = raw;
+                keyRaw.attributes = unknownAttributes(xml, data, QStringLiteral("ID"));
+                raw.clear();
 
-                                    if (translations.isEmpty()) {
-                                        delete key;
-                                    } else {
+                while (nextChild(xml, data, QString(), keyRaw.end)) {
 
-                                        for (int l = 0; l < translations.size(); ++l) {
-                                            QDomElement translation = translations.at(l).toElement();
+                    const QString lang = xml.name().toString();
 
-                                            Translation *trans = new Translation(translation.tagName(), translation.text(), key);
-                                            Q_UNUSED(trans)
-                                        }
-                                    }
-                                }
-                            }
-                        }
+                    if (m_languages.isEmpty() || m_languages.contains(lang)) {
+                        // empty elements are kept as empty translations
+                        new Translation(lang, xml.readElementText(QXmlStreamReader::IncludeChildElements), key);
+                    } else {
+                        xml.skipCurrentElement();
                     }
                 }
             }
+
+            container->passThrough().end = raw;
+            raw.clear();
         }
+
+        package->passThrough().end = raw;
+        raw.clear();
     }
 
-    if (proj->children().size() < 1) {
-        qWarning("%s", qUtf8Printable(tr("Can not find any nodes.")));
+    proj->passThrough().end = raw;
+
+    if (xml.hasError()) {
+        qCritical("%s", qUtf8Printable(tr("Failed to parse XML data.")));
+        delete proj;
+        return nullptr;
+    }
+
+    if (!hasPackages) {
+        qWarning("%s", qUtf8Printable(tr("Can not find Package node elements.")));
         delete proj;
         return nullptr;
     }
 
     return proj;
 }
+
+
+/*!
+ * \brief Decodes the file \a content with the encoding of its byte order mark or XML declaration.
+ *
+ * UTF-8 is used if there is neither or if the declared encoding is not supported.
+ *
+ * \since 1.1.0
+ */
+QString StringtableParser::decode(const QByteArray &content)
+{
+    QTextCodec *codec = QTextCodec::codecForUtfText(content, nullptr);
+
+    if (!codec) {
+        QXmlStreamReader declaration(content);
+        if (declaration.readNext() == QXmlStreamReader::StartDocument && !declaration.documentEncoding().isEmpty()) {
+            codec = QTextCodec::codecForName(declaration.documentEncoding().toLatin1());
+        }
+    }
+
+    if (!codec) {
+        codec = QTextCodec::codecForName("UTF-8");
+    }
+
+    return codec->toUnicode(content);
+}
+
+
+/*!
+ * \brief Reads up to the next element with the given \a name inside of the current element.
+ *
+ * Comments, processing instructions and child elements with another name are appended to
+ * \a raw as they have been read. If \a name is empty, every child element is returned.
+ * Returns false if the end of the current element has been reached.
+ *
+ * If \a wrappers is not a null pointer, elements with another name that contain an element
+ * with the given \a name are entered instead of being appended to \a raw. Their start and end
+ * tags are dropped, \a wrappers counts the entered elements that have not been left yet.
+ *
+ * \since 1.1.0
+ */
+bool StringtableParser::nextChild(QXmlStreamReader &xml, const QString &data, const QString &name, QStringList &raw, int *wrappers)
+{
+    while (!xml.atEnd()) {
+        switch (xml.readNext()) {
+        case QXmlStreamReader::StartElement:
+            if (name.isEmpty() || xml.name() == name) {
+                return true;
+            }
+            if (wrappers && containsElement(data, data.lastIndexOf(QLatin1Char('<'), int(xml.characterOffset()) - 1), name)) {
+                ++(*wrappers);
+                break;
+            }
+            raw.append(skipElement(xml, data));
+            break;
+        case QXmlStreamReader::Comment:
+        {
+            const int end = int(xml.characterOffset());
+            const int start = data.lastIndexOf(QLatin1String("<!--"), end - 1);
+            raw.append(data.mid(start, end - start));
+            break;
+        }
+        case QXmlStreamReader::ProcessingInstruction:
+        {
+            const int end = int(xml.characterOffset());
+            const int start = data.lastIndexOf(QLatin1String("<?"), end - 1);
+            raw.append(data.mid(start, end - start));
+            break;
+        }
+        case QXmlStreamReader::EndElement:
+            if (wrappers && *wrappers > 0) {
+                --(*wrappers);
+                break;
+            }
+            return false;
+        default:
+            break;
+        }
+    }
+
+    return false;
+}
+
+
+/*!
+ * \brief Returns true if the element starting at the offset \a start in \a data contains an element with the given \a name.
+ * \since 1.1.0
+ */
+bool StringtableParser::containsElement(const QString &data, int start, const QString &name)
+{
+    // the data is added in chunks, so that only the element itself is read
+    QXmlStreamReader xml;
+    xml.setNamespaceProcessing(false);
+    xml.addData(data.mid(start, 4096));
+
+    int position = start + 4096;
+    int depth = 0;
+
+    while (!xml.hasError() || xml.error() == QXmlStreamReader::PrematureEndOfDocumentError) {
+        switch (xml.readNext()) {
+        case QXmlStreamReader::Invalid:
+            if (xml.error() != QXmlStreamReader::PrematureEndOfDocumentError || position >= data.size()) {
+                return false;
+            }
+            xml.addData(data.mid(position, 4096));
+            position += 4096;
+            break;
+        case QXmlStreamReader::StartElement:
+            if (depth > 0 && xml.name() == name) {
+                return true;
+            }
+            ++depth;
+            break;
+        case QXmlStreamReader::EndElement:
+            if (--depth == 0) {
+                return false;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    return false;
+}
+
+
+/*!
+ * \brief Skips the current element and returns its markup as it has been read.
+ * \since 1.1.0
+ */
+QString StringtableParser::skipElement(QXmlStreamReader &xml, const QString &data)
+{
+    // attribute values can not contain a '<', so the last one before the offset starts the element
+    const int start = data.lastIndexOf(QLatin1Char('<'), int(xml.characterOffset()) - 1);
+
+    xml.skipCurrentElement();
+
+    return data.mid(start, int(xml.characterOffset()) - start);
+}
+
+
+/*!
+ * \brief Returns the attributes of the current start element except the \a known one as they have been read.
+ *
+ * Every attribute is prefixed by a single space. Returns an empty string if there are no other attributes.
+ *
+ * \since 1.1.0
+ */
+QString StringtableParser::unknownAttributes(const QXmlStreamReader &xml, const QString &data, const QString &known)
+{
+    const QXmlStreamAttributes attributes = xml.attributes();
+
+    if (attributes.isEmpty() || (attributes.size() == 1 && attributes.hasAttribute(known))) {
+        return QString();
+    }
+
+    QString result;
+
+    const int end = int(xml.characterOffset());
+    int i = data.lastIndexOf(QLatin1Char('<'), end - 1) + 1;
+
+    // skip the element name
+    while (i < end && !data.at(i).isSpace() && data.at(i) != QLatin1Char('/') && data.at(i) != QLatin1Char('>')) {
+        ++i;
+    }
+
+    while (i < end) {
+
+        while (i < end && data.at(i).isSpace()) {
+            ++i;
+        }
+
+        if (i >= end || data.at(i) == QLatin1Char('/') || data.at(i) == QLatin1Char('>')) {
+            break;
+        }
+
+        const int attributeStart = i;
+
+        while (i < end && data.at(i) != QLatin1Char('=') && !data.at(i).isSpace()) {
+            ++i;
+        }
+
+        const QStringRef attributeName = data.midRef(attributeStart, i - attributeStart);
+
+        while (i < end && data.at(i) != QLatin1Char('"') && data.at(i) != QLatin1Char('\'')) {
+            ++i;
+        }
+
+        if (i >= end) {
+            break;
+        }
+
+        i = data.indexOf(data.at(i), i + 1);
+
+        if (i < 0 || i >= end) {
+            break;
+        }
+
+        ++i;
+
+        if (attributeName != known) {
+            result.append(QLatin1Char(' ')).append(data.midRef(attributeStart, i - attributeStart));
+        }
+    }
+
+    return result;
+}
@@ -21,20 +21,31 @@
 
 #include <QObject>
 #include <QFile>
+#include <QStringList>
+#include "a3trans_global.h"
 
 class Project;
+class QXmlStreamReader;
 
-class StringtableParser : public QObject
+class A3TRANS_EXPORT StringtableParser : public QObject
 {
     Q_OBJECT
 public:
     explicit StringtableParser(const QString &stringTable, QObject *parent = nullptr);
 
+    void setLanguages(const QStringList &languages);
+
     Project *parse();
 
 private:
     QFile m_stringtable;
+    QStringList m_languages;
 
+    static QString decode(const QByteArray &content);
+    static bool nextChild(QXmlStreamReader &xml, const QString &data, const QString &name, QStringList &raw, int *wrappers = nullptr);
+    static bool containsElement(const QString &data, int start, const QString &name);
+    static QString skipElement(QXmlStreamReader &xml, const QString &data);
+    static QString unknownAttributes(const QXmlStreamReader &xml, const QString &data, const QString &known);
 };
 
 #endif // STRINGTABLEPARSER_H
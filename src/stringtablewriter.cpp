@@ -0,0 +1,365 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stringtablewriter.h"
+#include "key.h"
+#include "container.h"
+#include "package.h"
+#include "translation.h"
+#include <algorithm>
+
+
+
+/*!
+ * \class StringtableWriter
+ * \brief Writes a stringtable.xml file key by key.
+ *
+ * Instead of building the document from a Project object, keys are written one after another
+ * as soon as they are available. Package and Container elements are opened and closed when the
+ * package or container of the written key changes, so keys of the same container have to be
+ * written consecutively. The file is written via QSaveFile and only replaces the existing file
+ * when commit() is called.
+ *
+ * Packages of a loaded project are written with writePackage(), together with the PassThrough
+ * data of the package and of its containers and keys. The raw markup is spliced into the output
+ * without escaping it again, so that comments, unknown attributes and unknown elements survive
+ * a round-trip through the object model. The formatting is not kept: every raw markup starts on
+ * a new line with the indentation of the writer, and line breaks are written as the line breaks
+ * of the platform.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new StringtableWriter object that writes to \a filePath.
+ * \since 1.1.0
+ */
+StringtableWriter::StringtableWriter(const QString &filePath, QObject *parent) :
+    QObject(parent), m_file(filePath), m_packageOpen(false), m_containerOpen(false)
+{
+
+}
+
+
+
+/*!
+ * \brief Opens the file and writes the document start and the Project element.
+ *
+ * If \a passThrough is not a null pointer, the raw markup of the project is written, too.
+ *
+ * \since 1.1.0
+ * \return True on success.
+ */
+bool StringtableWriter::open(const QString &projectName, const PassThrough *passThrough)
+{
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning("%s", qUtf8Printable(tr("Failed to open file for writing: %1").arg(m_file.fileName())));
+        return false;
+    }
+
+    m_file.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+
+    if (passThrough) {
+        writeRaw(0, passThrough->before);
+        writeLine(0, QLatin1String("<Project name=\"") + escape(projectName, true) + QLatin1Char('"') + passThrough->attributes + QLatin1Char('>'));
+        m_projectEnd = passThrough->end;
+    } else {
+        writeLine(0, QLatin1String("<Project name=\"") + escape(projectName, true) + QLatin1String("\">"));
+    }
+
+    return true;
+}
+
+
+
+/*!
+ * \brief Writes a single key with its \a translations.
+ *
+ * \a translations contains pairs of language name, like \c Original or \c German, and string.
+ * Empty strings are skipped, keys without any string are not written.
+ *
+ * \since 1.1.0
+ */
+void StringtableWriter::writeKey(const QString &package, const QString &container, const QString &id, const QVector<QPair<QString, QString> > &translations)
+{
+    bool hasStrings = false;
+    for (int i = 0; i < translations.size() && !hasStrings; ++i) {
+        if (!translations.at(i).second.isEmpty()) {
+            hasStrings = true;
+        }
+    }
+
+    if (!hasStrings) {
+        return;
+    }
+
+    if (m_packageOpen && package != m_package) {
+        closePackage();
+    }
+
+    if (m_containerOpen && container != m_container) {
+        closeContainer();
+    }
+
+    if (!m_packageOpen) {
+        writeLine(1, QLatin1String("<Package name=\"") + escape(package, true) + QLatin1String("\">"));
+        m_package = package;
+        m_packageOpen = true;
+    }
+
+    if (!m_containerOpen) {
+        writeLine(2, QLatin1String("<Container name=\"") + escape(container, true) + QLatin1String("\">"));
+        m_container = container;
+        m_containerOpen = true;
+    }
+
+    writeLine(3, QLatin1String("<Key ID=\"") + escape(id, true) + QLatin1String("\">"));
+
+    for (int i = 0; i < translations.size(); ++i) {
+        const QString &lang = translations.at(i).first;
+        if (!translations.at(i).second.isEmpty()) {
+            writeLine(4, QLatin1Char('<') + lang + QLatin1Char('>') + escape(translations.at(i).second) + QLatin1String("</") + lang + QLatin1Char('>'));
+        }
+    }
+
+    writeLine(3, QStringLiteral("</Key>"));
+}
+
+
+
+/*!
+ * \brief Writes the \a package with all of its containers and keys and their raw markup.
+ *
+ * Every object is written as an element of its own, also containers without keys, packages
+ * without containers and keys without translations. Empty translations are written as empty
+ * language elements. If \a sorted is true, the containers are written ordered by name and the
+ * keys ordered by their case folded id, otherwise they are written in the order of the model.
+ *
+ * \since 1.1.0
+ */
+void StringtableWriter::writePackage(const Package *package, bool sorted)
+{
+    closePackage();
+
+    const PassThrough &packageRaw = package->passThrough();
+
+    writeRaw(1, packageRaw.before);
+    writeLine(1, QLatin1String("<Package name=\"") + escape(package->objectName(), true) + QLatin1Char('"') + packageRaw.attributes + QLatin1Char('>'));
+
+    QList<Container*> cs = package->findChildren<Container*>(QString(), Qt::FindDirectChildrenOnly);
+
+    if (sorted) {
+        std::stable_sort(cs.begin(), cs.end(), [](const Container *a, const Container *b) {
+            return a->objectName() < b->objectName();
+        });
+    }
+
+    for (int i = 0; i < cs.size(); ++i) {
+
+        const Container *c = cs.at(i);
+        const PassThrough &containerRaw = c->passThrough();
+
+        writeRaw(2, containerRaw.before);
+        writeLine(2, QLatin1String("<Container name=\"") + escape(c->objectName(), true) + QLatin1Char('"') + containerRaw.attributes + QLatin1Char('>'));
+
+        QVector<Key*> ks = c->keys();
+
+        if (sorted) {
+            std::stable_sort(ks.begin(), ks.end(), [](const Key *a, const Key *b) {
+                return a->objectName().toCaseFolded() < b->objectName().toCaseFolded();
+            });
+        }
+
+        for (int j = 0; j < ks.size(); ++j) {
+            writeKeyElement(ks.at(j));
+        }
+
+        writeRaw(3, containerRaw.end);
+        writeLine(2, QStringLiteral("</Container>"));
+    }
+
+    writeRaw(2, packageRaw.end);
+    writeLine(1, QStringLiteral("</Package>"));
+}
+
+
+
+/*!
+ * \brief Finishes the document and replaces the existing file.
+ * \since 1.1.0
+ * \return True on success.
+ */
+bool StringtableWriter::commit()
+{
+    closePackage();
+
+    writeRaw(1, m_projectEnd);
+    writeLine(0, QStringLiteral("</Project>"));
+
+    if (!m_file.commit()) {
+        qWarning("%s", qUtf8Printable(tr("Failed to write data to file: %1").arg(m_file.fileName())));
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/*!
+ * \brief Discards the written data, the existing file will not be touched.
+ * \since 1.1.0
+ */
+void StringtableWriter::cancel()
+{
+    m_file.cancelWriting();
+    m_file.commit();
+}
+
+
+
+/*!
+ * \brief Writes the Key element of \a key with its translations and raw markup.
+ * \since 1.1.0
+ */
+void StringtableWriter::writeKeyElement(const Key *key)
+{
+    const PassThrough &keyRaw = key->passThrough();
+
+    writeRaw(3, keyRaw.before);
+    writeLine(3, QLatin1String("<Key ID=\"") + escape(key->objectName(), true) + QLatin1Char('"') + keyRaw.attributes + QLatin1Char('>'));
+
+    const QList<Translation*> ts = key->getAllTranslations();
+
+    for (int i = 0; i < ts.size(); ++i) {
+        const QString &lang = ts.at(i)->objectName();
+        writeLine(4, QLatin1Char('<') + lang + QLatin1Char('>') + escape(ts.at(i)->string()) + QLatin1String("</") + lang + QLatin1Char('>'));
+    }
+
+    writeRaw(4, keyRaw.end);
+    writeLine(3, QStringLiteral("</Key>"));
+}
+
+
+
+/*!
+ * \brief Closes the open Container element.
+ * \since 1.1.0
+ */
+void StringtableWriter::closeContainer()
+{
+    if (!m_containerOpen) {
+        return;
+    }
+
+    writeLine(2, QStringLiteral("</Container>"));
+    m_containerOpen = false;
+}
+
+
+
+/*!
+ * \brief Closes the open Package element and its open Container element.
+ * \since 1.1.0
+ */
+void StringtableWriter::closePackage()
+{
+    if (!m_packageOpen) {
+        return;
+    }
+
+    closeContainer();
+
+    writeLine(1, QStringLiteral("</Package>"));
+    m_packageOpen = false;
+}
+
+
+
+/*!
+ * \brief Writes \a text on a new line, indented by 8 spaces per \a depth.
+ * \since 1.1.0
+ */
+void StringtableWriter::writeLine(int depth, const QString &text)
+{
+    m_file.write(QByteArray(depth * 8, ' '));
+    m_file.write(text.toUtf8());
+    m_file.write("\n");
+}
+
+
+
+/*!
+ * \brief Writes every raw \a markup on its own line, indented by \a depth.
+ *
+ * Only the first line of multi-line markup is indented, the following lines keep their
+ * original indentation.
+ *
+ * \since 1.1.0
+ */
+void StringtableWriter::writeRaw(int depth, const QStringList &markup)
+{
+    for (int i = 0; i < markup.size(); ++i) {
+        writeLine(depth, markup.at(i));
+    }
+}
+
+
+
+/*!
+ * \brief Returns \a text with the XML special characters replaced by entities.
+ *
+ * If \a attribute is true, line breaks and tabs are replaced, too, so that they are
+ * not normalized when the attribute is read again.
+ *
+ * \since 1.1.0
+ */
+QString StringtableWriter::escape(const QString &text, bool attribute)
+{
+    QString escaped;
+    escaped.reserve(text.size());
+
+    for (int i = 0; i < text.size(); ++i) {
+        const QChar c = text.at(i);
+        if (c == QLatin1Char('<')) {
+            escaped.append(QLatin1String("&lt;"));
+        } else if (c == QLatin1Char('>')) {
+            escaped.append(QLatin1String("&gt;"));
+        } else if (c == QLatin1Char('&')) {
+            escaped.append(QLatin1String("&amp;"));
+        } else if (c == QLatin1Char('"')) {
+            escaped.append(QLatin1String("&quot;"));
+        } else if (attribute && c == QLatin1Char('\n')) {
+            escaped.append(QLatin1String("&#10;"));
+        } else if (attribute && c == QLatin1Char('\r')) {
+            escaped.append(QLatin1String("&#13;"));
+        } else if (attribute && c == QLatin1Char('\t')) {
+            escaped.append(QLatin1String("&#9;"));
+        } else {
+            escaped.append(c);
+        }
+    }
+
+    return escaped;
+}
@@ -0,0 +1,68 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STRINGTABLEWRITER_H
+#define STRINGTABLEWRITER_H
+
+#include <QObject>
+#include <QSaveFile>
+#include <QStringList>
+#include <QVector>
+#include <QPair>
+#include "passthrough.h"
+#include "a3trans_global.h"
+
+class Key;
+class Package;
+
+class A3TRANS_EXPORT StringtableWriter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StringtableWriter(const QString &filePath, QObject *parent = nullptr);
+
+    bool open(const QString &projectName, const PassThrough *passThrough = nullptr);
+
+    void writeKey(const QString &package, const QString &container, const QString &id, const QVector<QPair<QString, QString> > &translations);
+
+    void writePackage(const Package *package, bool sorted = false);
+
+    bool commit();
+
+    void cancel();
+
+private:
+    Q_DISABLE_COPY(StringtableWriter)
+
+    QSaveFile m_file;
+    QString m_package;
+    QString m_container;
+    bool m_packageOpen;
+    bool m_containerOpen;
+    QStringList m_projectEnd;
+
+    void writeKeyElement(const Key *key);
+    void closeContainer();
+    void closePackage();
+    void writeLine(int depth, const QString &text);
+    void writeRaw(int depth, const QStringList &markup);
+
+    static QString escape(const QString &text, bool attribute = false);
+};
+
+#endif // STRINGTABLEWRITER_H
@@ -21,8 +21,9 @@
 
 #include <QObject>
 #include <QDomDocument>
+#include "a3trans_global.h"
 
-class Translation : public QObject
+class A3TRANS_EXPORT Translation : public QObject
 {
     Q_OBJECT
 public:
@@ -0,0 +1,373 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "translationmemory.h"
+#include "project.h"
+#include "key.h"
+#include "translation.h"
+#include <QPair>
+#include <algorithm>
+
+
+
+/*!
+ * \class TranslationMemory
+ * \brief Proposes existing translations of similar source strings.
+ *
+ * The memory holds pairs of source strings and their translations per language, usually all
+ * translated keys of one or more stringtables. Source strings are compared after simplifying
+ * the white space and case folding.
+ *
+ * Lookups use an inverted index from the trigrams of the source strings to the units that
+ * contain them. Every edit operation changes at most three trigrams, so a source string within
+ * the edit distance allowed by the threshold has to share a minimum number of trigrams with the
+ * query. Only the candidates passing this filter and the length filter are verified by computing
+ * the edit distance within a band of the allowed distance, the most promising ones first. Trigrams
+ * that occur in a large part of the memory are not counted to bound the cost of a lookup.
+ *
+ * The similarity of a match is the percentage of characters that do not have to be edited,
+ * relative to the longer of both strings.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new empty TranslationMemory object with a threshold of 75 percent.
+ * \since 1.1.0
+ */
+TranslationMemory::TranslationMemory() : m_threshold(75)
+{
+
+}
+
+
+
+/*!
+ * \brief Sets the minimum similarity in \a percent of a match.
+ * \since 1.1.0
+ */
+void TranslationMemory::setThreshold(int percent)
+{
+    m_threshold = qBound(1, percent, 100);
+}
+
+
+
+/*!
+ * \brief Returns the minimum similarity in percent of a match.
+ * \since 1.1.0
+ */
+int TranslationMemory::threshold() const
+{
+    return m_threshold;
+}
+
+
+
+/*!
+ * \brief Adds the translation \a target of the \a source string into the language \a lang.
+ *
+ * If there is already a translation of the same source string into \a lang, it is kept.
+ *
+ * \since 1.1.0
+ * \param source    The source string.
+ * \param lang      The language name, like \c German.
+ * \param target    The translated string.
+ */
+void TranslationMemory::add(const QString &source, const QString &lang, const QString &target)
+{
+    if (target.isEmpty()) {
+        return;
+    }
+
+    const QString n = normalize(source);
+
+    if (n.isEmpty()) {
+        return;
+    }
+
+    int idx = m_sources.value(n, -1);
+
+    if (idx < 0) {
+        idx = m_units.size();
+        m_units.append({source, n, QHash<QString, QString>()});
+        m_sources.insert(n, idx);
+
+        const QVector<quint64> grams = trigrams(n);
+        for (int i = 0; i < grams.size(); ++i) {
+            m_grams[grams.at(i)].append(idx);
+        }
+    }
+
+    QHash<QString, QString> &targets = m_units[idx].targets;
+
+    if (!targets.contains(lang)) {
+        targets.insert(lang, target);
+    }
+}
+
+
+
+/*!
+ * \brief Adds the translations of all keys of \a project that have an Original string.
+ * \since 1.1.0
+ */
+void TranslationMemory::addProject(const Project *project)
+{
+    if (!project) {
+        return;
+    }
+
+    const QVector<Key*> ks = project->keys();
+
+    for (int i = 0; i < ks.size(); ++i) {
+        const Translation *o = ks.at(i)->getTranslation(QStringLiteral("Original"));
+        if (!o) {
+            continue;
+        }
+        const QList<Translation*> ts = ks.at(i)->getAllTranslations();
+        for (int j = 0; j < ts.size(); ++j) {
+            if (ts.at(j) != o) {
+                add(o->string(), ts.at(j)->objectName(), ts.at(j)->string());
+            }
+        }
+    }
+}
+
+
+
+/*!
+ * \brief Returns the number of unique source strings in the memory.
+ * \since 1.1.0
+ */
+int TranslationMemory::size() const
+{
+    return m_units.size();
+}
+
+
+
+/*!
+ * \brief Searches the translation into \a lang of the source string most similar to \a source.
+ * \since 1.1.0
+ * \param source    The source string to find a translation for.
+ * \param lang      The language name, like \c German.
+ * \param match     Will be set to the best match.
+ * \return          True if a match with a similarity of at least the threshold has been found.
+ */
+bool TranslationMemory::match(const QString &source, const QString &lang, Match *match) const
+{
+    if (!match || m_units.isEmpty()) {
+        return false;
+    }
+
+    const QString n = normalize(source);
+
+    if (n.isEmpty()) {
+        return false;
+    }
+
+    QHash<QString, int>::const_iterator exact = m_sources.constFind(n);
+
+    if (exact != m_sources.constEnd()) {
+        const Unit &u = m_units.at(exact.value());
+        QHash<QString, QString>::const_iterator t = u.targets.constFind(lang);
+        if (t != u.targets.constEnd()) {
+            *match = {u.source, t.value(), 100};
+            return true;
+        }
+    }
+
+    if (m_threshold >= 100) {
+        return false;
+    }
+
+    const QVector<quint64> grams = trigrams(n);
+    const int stopLength = qMax(1000, m_units.size() / 10);
+
+    QHash<int, int> shared;
+    int skipped = 0;
+
+    for (int i = 0; i < grams.size(); ++i) {
+        QHash<quint64, QVector<int> >::const_iterator p = m_grams.constFind(grams.at(i));
+        if (p == m_grams.constEnd()) {
+            continue;
+        }
+        if (p.value().size() > stopLength) {
+            skipped++;
+            continue;
+        }
+        const QVector<int> &units = p.value();
+        for (int j = 0; j < units.size(); ++j) {
+            shared[units.at(j)]++;
+        }
+    }
+
+    QVector<QPair<int, int> > candidates;
+
+    for (QHash<int, int>::const_iterator it = shared.constBegin(); it != shared.constEnd(); ++it) {
+        const Unit &u = m_units.at(it.key());
+        if (!u.targets.contains(lang)) {
+            continue;
+        }
+        const int maxLength = qMax(n.size(), u.normalized.size());
+        const int k = (100 - m_threshold) * maxLength / 100;
+        if (qAbs(n.size() - u.normalized.size()) > k || it.value() + skipped < grams.size() - 3 * k) {
+            continue;
+        }
+        candidates.append(qMakePair(it.value(), it.key()));
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const QPair<int, int> &a, const QPair<int, int> &b) {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    });
+
+    const int verify = qMin(candidates.size(), 64);
+    int best = -1;
+    int bestSimilarity = 0;
+
+    for (int i = 0; i < verify; ++i) {
+        const Unit &u = m_units.at(candidates.at(i).second);
+        const int maxLength = qMax(n.size(), u.normalized.size());
+        const int k = (100 - m_threshold) * maxLength / 100;
+        const int d = distance(n, u.normalized, k);
+        if (d > k) {
+            continue;
+        }
+        const int similarity = (maxLength - d) * 100 / maxLength;
+        if (similarity > bestSimilarity) {
+            best = candidates.at(i).second;
+            bestSimilarity = similarity;
+        }
+    }
+
+    if (best < 0) {
+        return false;
+    }
+
+    const Unit &u = m_units.at(best);
+    *match = {u.source, u.targets.value(lang), bestSimilarity};
+
+    return true;
+}
+
+
+
+/*!
+ * \brief Returns the form of \a source used for comparisons.
+ * \since 1.1.0
+ */
+QString TranslationMemory::normalize(const QString &source)
+{
+    return source.simplified().toCaseFolded();
+}
+
+
+
+/*!
+ * \brief Returns the sorted distinct trigrams of \a normalized, padded at the start and the end.
+ *
+ * Every trigram is packed into a single integer.
+ *
+ * \since 1.1.0
+ */
+QVector<quint64> TranslationMemory::trigrams(const QString &normalized)
+{
+    const int len = normalized.size();
+
+    QVector<quint64> grams;
+    grams.reserve(len + 2);
+
+    for (int i = -2; i < len; ++i) {
+        quint64 g = 0;
+        for (int j = i; j < i + 3; ++j) {
+            g = (g << 16) | (j >= 0 && j < len ? normalized.at(j).unicode() : 0);
+        }
+        grams.append(g);
+    }
+
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+
+    return grams;
+}
+
+
+
+/*!
+ * \brief Returns the edit distance of \a a and \a b or \a max + 1 if it is greater than \a max.
+ *
+ * Only the cells within a band of \a max around the diagonal are computed and the computation
+ * stops as soon as a row exceeds \a max.
+ *
+ * \since 1.1.0
+ */
+int TranslationMemory::distance(const QString &a, const QString &b, int max)
+{
+    const int n = a.size();
+    const int m = b.size();
+    const int inf = max + 1;
+
+    if (qAbs(n - m) > max) {
+        return inf;
+    }
+
+    QVector<int> prev(m + 1);
+    QVector<int> cur(m + 1);
+
+    for (int j = 0; j <= m; ++j) {
+        prev[j] = j <= max ? j : inf;
+    }
+
+    for (int i = 1; i <= n; ++i) {
+        const int from = qMax(1, i - max);
+        const int to = qMin(m, i + max);
+
+        cur[0] = i <= max ? i : inf;
+        if (from > 1) {
+            cur[from - 1] = inf;
+        }
+
+        int rowMin = cur[0];
+
+        for (int j = from; j <= to; ++j) {
+            const int cost = a.at(i - 1) == b.at(j - 1) ? 0 : 1;
+            const int v = qMin(qMin(prev[j - 1] + cost, prev[j] + 1), cur[j - 1] + 1);
+            cur[j] = qMin(v, inf);
+            rowMin = qMin(rowMin, cur[j]);
+        }
+
+        if (to < m) {
+            cur[to + 1] = inf;
+        }
+
+        if (rowMin > max) {
+            return inf;
+        }
+
+        prev.swap(cur);
+    }
+
+    return qMin(prev[m], inf);
+}
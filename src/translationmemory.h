@@ -0,0 +1,69 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRANSLATIONMEMORY_H
+#define TRANSLATIONMEMORY_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include "a3trans_global.h"
+
+class Project;
+
+class A3TRANS_EXPORT TranslationMemory
+{
+public:
+    struct Match {
+        QString source;
+        QString target;
+        int similarity;
+    };
+
+    TranslationMemory();
+
+    void setThreshold(int percent);
+
+    int threshold() const;
+
+    void add(const QString &source, const QString &lang, const QString &target);
+
+    void addProject(const Project *project);
+
+    int size() const;
+
+    bool match(const QString &source, const QString &lang, Match *match) const;
+
+private:
+    struct Unit {
+        QString source;
+        QString normalized;
+        QHash<QString, QString> targets;
+    };
+
+    QVector<Unit> m_units;
+    QHash<QString, int> m_sources;
+    QHash<quint64, QVector<int> > m_grams;
+    int m_threshold;
+
+    static QString normalize(const QString &source);
+    static QVector<quint64> trigrams(const QString &normalized);
+    static int distance(const QString &a, const QString &b, int max);
+};
+
+#endif // TRANSLATIONMEMORY_H
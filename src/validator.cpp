@@ -0,0 +1,354 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "validator.h"
+#include "project.h"
+#include "key.h"
+#include "translation.h"
+#include <QFile>
+#include <QXmlStreamReader>
+#include <algorithm>
+
+
+
+/*!
+ * \class Validator
+ * \brief Checks that the translations of a key keep the placeholders and structured text tags of the source string.
+ *
+ * Strings are formatted by \c format and \c parseText in the game. A translation that drops a
+ * placeholder like \c %1 or that breaks structured text tags like \c <t \c color='#ff0000'> or
+ * \c <br/> produces wrong output at runtime.
+ *
+ * Every string is tokenized once in a single pass. The translations are compared against the
+ * Original string, or the English translation if there is no Original string:
+ * \li \c placeholder-mismatch (error): the placeholders differ, compared as multiset, so the order can change.
+ * \li \c unbalanced-tags (error): closing tags do not match the opening tags.
+ * \li \c tag-mismatch (warning): the translation uses other tags than the source string.
+ *
+ * The findings of all languages of a key are combined into one finding per rule.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new Validator object that adds its findings to \a report.
+ *
+ * If \a report is a null pointer, findings are printed as warnings.
+ *
+ * \since 1.1.0
+ */
+Validator::Validator(Report *report) : m_report(report), m_violations(0)
+{
+
+}
+
+
+
+/*!
+ * \brief Validates all keys of \a project.
+ * \since 1.1.0
+ */
+void Validator::validate(const Project *project)
+{
+    if (!project) {
+        return;
+    }
+
+    const QVector<Key*> ks = project->keys();
+
+    for (int i = 0; i < ks.size(); ++i) {
+        validate(ks.at(i));
+    }
+}
+
+
+
+/*!
+ * \brief Validates the translations of \a key.
+ * \since 1.1.0
+ */
+void Validator::validate(const Key *key)
+{
+    const QList<Translation*> ts = key->getAllTranslations();
+
+    QVector<QPair<QString, QString> > translations;
+    translations.reserve(ts.size());
+
+    for (int i = 0; i < ts.size(); ++i) {
+        translations.append(qMakePair(ts.at(i)->objectName(), ts.at(i)->string()));
+    }
+
+    validate(key->objectName(), translations);
+}
+
+
+
+/*!
+ * \brief Validates the \a translations of the key with \a id.
+ * \since 1.1.0
+ * \param id            The id of the key.
+ * \param translations  Pairs of language name, like \c German or \c Original, and string.
+ */
+void Validator::validate(const QString &id, const QVector<QPair<QString, QString> > &translations)
+{
+    int ref = -1;
+
+    for (int i = 0; i < translations.size(); ++i) {
+        if (translations.at(i).first == QLatin1String("Original")) {
+            ref = i;
+            break;
+        } else if (ref < 0 && translations.at(i).first == QLatin1String("English")) {
+            ref = i;
+        }
+    }
+
+    if (ref < 0 || translations.at(ref).second.isEmpty()) {
+        return;
+    }
+
+    const Tokens rt = tokenize(translations.at(ref).second);
+
+    QStringList placeholders;
+    QStringList unbalanced;
+    QStringList tags;
+
+    if (!rt.balanced) {
+        unbalanced.append(translations.at(ref).first);
+    }
+
+    for (int i = 0; i < translations.size(); ++i) {
+        if (i == ref || translations.at(i).second.isEmpty()) {
+            continue;
+        }
+
+        const QString &lang = translations.at(i).first;
+        const Tokens tt = tokenize(translations.at(i).second);
+
+        if (tt.placeholders != rt.placeholders) {
+            placeholders.append(tr("%1 has %2 instead of %3").arg(lang, placeholderList(tt.placeholders), placeholderList(rt.placeholders)));
+        }
+
+        if (!tt.balanced) {
+            unbalanced.append(lang);
+        } else if (rt.balanced && tt.tags != rt.tags) {
+            tags.append(lang);
+        }
+    }
+
+    if (!placeholders.isEmpty()) {
+        add(QStringLiteral("placeholder-mismatch"), Report::Error, id, tr("Placeholders differ from the source string: %1").arg(placeholders.join(QStringLiteral("; "))));
+    }
+
+    if (!unbalanced.isEmpty()) {
+        add(QStringLiteral("unbalanced-tags"), Report::Error, id, tr("Unbalanced structured text tags in: %1").arg(unbalanced.join(QStringLiteral(", "))));
+    }
+
+    if (!tags.isEmpty()) {
+        add(QStringLiteral("tag-mismatch"), Report::Warning, id, tr("Structured text tags differ from the source string in: %1").arg(tags.join(QStringLiteral(", "))));
+    }
+}
+
+
+
+/*!
+ * \brief Validates all keys of the stringtable.xml file at \a filePath without loading it into a Project.
+ *
+ * Only the translations of a single key are held in memory at any time. Returns false if the file
+ * can not be read or parsed.
+ *
+ * \since 1.1.0
+ */
+bool Validator::validateStringTable(const QString &filePath)
+{
+    QFile f(filePath);
+
+    if (!f.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QXmlStreamReader xml(&f);
+
+    QVector<QPair<QString, QString> > translations;
+
+    while (!xml.atEnd()) {
+
+        if (xml.readNext() != QXmlStreamReader::StartElement || xml.name() != QLatin1String("Key")) {
+            continue;
+        }
+
+        const QString id = xml.attributes().value(QStringLiteral("ID")).toString();
+
+        translations.clear();
+        while (xml.readNextStartElement()) {
+            const QString lang = xml.name().toString();
+            translations.append(qMakePair(lang, xml.readElementText(QXmlStreamReader::IncludeChildElements)));
+        }
+
+        validate(id, translations);
+    }
+
+    return !xml.hasError();
+}
+
+
+
+/*!
+ * \brief Returns the number of findings.
+ * \since 1.1.0
+ */
+int Validator::violations() const
+{
+    return m_violations;
+}
+
+
+
+/*!
+ * \brief Extracts the placeholders and structured text tags of \a text in a single pass.
+ *
+ * Placeholders are a percent sign followed by digits. Tags are reduced to their lower case
+ * name, attributes are ignored. \c br and \c img tags, as well as tags ending with a slash,
+ * do not need to be closed. Both lists are sorted, so that they can be compared as multisets.
+ *
+ * \since 1.1.0
+ */
+Validator::Tokens Validator::tokenize(const QString &text)
+{
+    Tokens t;
+    t.balanced = true;
+
+    QStringList open;
+
+    const int len = text.size();
+
+    for (int i = 0; i < len; ++i) {
+        const QChar c = text.at(i);
+
+        if (c == QLatin1Char('%') && i + 1 < len && text.at(i + 1).isDigit()) {
+
+            int j = i + 1;
+            int number = 0;
+            while (j < len && text.at(j).isDigit()) {
+                number = number * 10 + text.at(j).digitValue();
+                j++;
+            }
+            t.placeholders.append(number);
+            i = j - 1;
+
+        } else if (c == QLatin1Char('<')) {
+
+            // a less-than sign without a closing greater-than sign
+            const int end = text.indexOf(QLatin1Char('>'), i + 1);
+            if (end < 0) {
+                continue;
+            }
+
+            int innerStart = i + 1;
+            int innerEnd = end;
+            while (innerStart < innerEnd && text.at(innerStart).isSpace()) {
+                innerStart++;
+            }
+            while (innerEnd > innerStart && text.at(innerEnd - 1).isSpace()) {
+                innerEnd--;
+            }
+
+            const bool closing = innerStart < innerEnd && text.at(innerStart) == QLatin1Char('/');
+            const bool selfClosing = innerEnd > innerStart && text.at(innerEnd - 1) == QLatin1Char('/');
+
+            const int nameStart = closing ? innerStart + 1 : innerStart;
+            int nameEnd = nameStart;
+            while (nameEnd < innerEnd && text.at(nameEnd).isLetterOrNumber()) {
+                nameEnd++;
+            }
+
+            // a less-than sign that does not start a tag
+            if (nameEnd == nameStart || !text.at(nameStart).isLetter()) {
+                continue;
+            }
+
+            const QString name = text.mid(nameStart, nameEnd - nameStart).toLower();
+
+            if (closing) {
+                if (open.isEmpty() || open.last() != name) {
+                    t.balanced = false;
+                } else {
+                    open.removeLast();
+                }
+            } else {
+                t.tags.append(name);
+                if (!selfClosing && name != QLatin1String("br") && name != QLatin1String("img")) {
+                    open.append(name);
+                }
+            }
+
+            i = end;
+        }
+    }
+
+    if (!open.isEmpty()) {
+        t.balanced = false;
+    }
+
+    std::sort(t.placeholders.begin(), t.placeholders.end());
+    std::sort(t.tags.begin(), t.tags.end());
+
+    return t;
+}
+
+
+
+/*!
+ * \brief Adds a finding to the report or prints it as warning if there is no report.
+ * \since 1.1.0
+ */
+void Validator::add(const QString &rule, Report::Level level, const QString &id, const QString &message)
+{
+    m_violations++;
+
+    if (m_report) {
+        m_report->add(rule, level, id, message);
+    } else {
+        qWarning("%s", qUtf8Printable(QStringLiteral("%1: %2").arg(id, message)));
+    }
+}
+
+
+
+/*!
+ * \brief Returns the \a placeholders as text for messages.
+ * \since 1.1.0
+ */
+QString Validator::placeholderList(const QVector<int> &placeholders)
+{
+    if (placeholders.isEmpty()) {
+        return tr("none");
+    }
+
+    QStringList l;
+    for (int i = 0; i < placeholders.size(); ++i) {
+        l.append(QLatin1Char('%') + QString::number(placeholders.at(i)));
+    }
+
+    return l.join(QLatin1Char(' '));
+}
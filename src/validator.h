@@ -0,0 +1,66 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VALIDATOR_H
+#define VALIDATOR_H
+
+#include <QCoreApplication>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPair>
+#include "report.h"
+#include "a3trans_global.h"
+
+class Project;
+class Key;
+
+class A3TRANS_EXPORT Validator
+{
+    Q_DECLARE_TR_FUNCTIONS(Validator)
+public:
+    struct Tokens {
+        QVector<int> placeholders;
+        QStringList tags;
+        bool balanced;
+    };
+
+    explicit Validator(Report *report = nullptr);
+
+    void validate(const Project *project);
+
+    void validate(const Key *key);
+
+    void validate(const QString &id, const QVector<QPair<QString, QString> > &translations);
+
+    bool validateStringTable(const QString &filePath);
+
+    int violations() const;
+
+    static Tokens tokenize(const QString &text);
+
+private:
+    Report *m_report;
+    int m_violations;
+
+    void add(const QString &rule, Report::Level level, const QString &id, const QString &message);
+
+    static QString placeholderList(const QVector<int> &placeholders);
+};
+
+#endif // VALIDATOR_H
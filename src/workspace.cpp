@@ -0,0 +1,398 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "workspace.h"
+#include "project.h"
+#include "key.h"
+#include "translation.h"
+#include "keyindex.h"
+#include "report.h"
+#include "stringtableparser.h"
+#include <QFileInfo>
+#include <QFile>
+#include <QCryptographicHash>
+
+
+
+/*!
+ * \class Workspace
+ * \brief Keeps the state of a working directory in memory for hosts that embed a3trans.
+ *
+ * A workspace is the entry point of the library for long living processes like build tools or
+ * editors. The stringtable.xml file of the working directory is loaded on first use and kept
+ * in memory between calls to extract(), exportXliff() and importXliff(), that run a Job with the
+ * loaded project instead of parsing the file again. The project is reloaded if the modification
+ * time or the size of the file has been changed on disk since it has been loaded or written. The
+ * content is only compared before an operation is run and while the file is so recent that a
+ * change would not have changed its modification time.
+ *
+ * A workspace is not thread safe, but different workspaces can be used in different threads.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new Workspace object for the \a workingDir.
+ * \since 1.1.0
+ * \param workingDir    Path to the working directory.
+ * \param parent        Pointer to the parent object.
+ */
+Workspace::Workspace(const QString &workingDir, QObject *parent) :
+    QObject(parent), m_wd(QDir(workingDir).absolutePath()), m_report(new Report(this)), m_size(-1), m_racy(false), m_filesParsed(0)
+{
+
+}
+
+
+
+/*!
+ * \brief Deconstructs the Workspace object and the loaded project.
+ */
+Workspace::~Workspace()
+{
+
+}
+
+
+
+/*!
+ * \brief Returns the absolute path of the working directory.
+ * \since 1.1.0
+ */
+QString Workspace::workingDir() const
+{
+    return m_wd.absolutePath();
+}
+
+
+
+/*!
+ * \brief Sets the \a options used for the next operations.
+ *
+ * The mode of the options is ignored, it is set by the called operation.
+ *
+ * \since 1.1.0
+ */
+void Workspace::setOptions(const JobOptions &options)
+{
+    m_options = options;
+}
+
+
+
+/*!
+ * \brief Returns the options used for the operations.
+ * \since 1.1.0
+ */
+JobOptions Workspace::options() const
+{
+    return m_options;
+}
+
+
+
+/*!
+ * \brief Returns the report that collects the findings of the operations.
+ *
+ * The findings are kept until Report::clear() is called.
+ *
+ * \since 1.1.0
+ */
+Report *Workspace::report() const
+{
+    return m_report;
+}
+
+
+
+/*!
+ * \brief Returns the project of the stringtable.xml file in the working directory.
+ *
+ * The file is loaded on first use and if its modification time or size has been changed since
+ * it has been loaded. Returns a null pointer if the file does not exist or could not be parsed.
+ * The project is owned by the workspace and is valid until the next operation is called.
+ *
+ * \since 1.1.0
+ */
+Project *Workspace::stringTable()
+{
+    return load(false);
+}
+
+
+
+/*!
+ * \brief Returns the index of the keys of the loaded project or a null pointer if there is no project.
+ *
+ * The project is loaded or reloaded like by stringTable(). The index is built on first use after
+ * the project has been loaded and is valid until the next operation is called.
+ *
+ * \since 1.1.0
+ */
+const KeyIndex *Workspace::keyIndex()
+{
+    stringTable();
+
+    return loadedKeyIndex();
+}
+
+
+
+/*!
+ * \brief Returns the index of the keys of the project that is already loaded or a null pointer if there is none.
+ *
+ * Unlike keyIndex(), the stringtable.xml file is not accessed at all. This is meant for hosts that
+ * watch the file themselves and call invalidate() when it has been changed.
+ *
+ * \since 1.1.0
+ */
+const KeyIndex *Workspace::loadedKeyIndex()
+{
+    if (!m_stringTable) {
+        return nullptr;
+    }
+
+    if (!m_index) {
+        m_index.reset(new KeyIndex(m_stringTable.data()));
+    }
+
+    return m_index.data();
+}
+
+
+
+/*!
+ * \brief Returns the key with \a id from the loaded project or a null pointer if it does not exist.
+ *
+ * Key ids are compared case insensitive.
+ *
+ * \since 1.1.0
+ */
+Key *Workspace::key(const QString &id)
+{
+    const KeyIndex *index = keyIndex();
+
+    return index ? index->find(id) : nullptr;
+}
+
+
+
+/*!
+ * \brief Returns the translation of the key with \a id into the language \a lang, like \c English.
+ *
+ * Key ids are compared case insensitive. Returns a null string if the key or the translation does not exist.
+ *
+ * \since 1.1.0
+ */
+QString Workspace::translation(const QString &id, const QString &lang)
+{
+    const Key *k = key(id);
+    const Translation *t = k ? k->getTranslation(lang) : nullptr;
+
+    return t ? t->string() : QString();
+}
+
+
+
+/*!
+ * \brief Drops the loaded project, so that it will be loaded again on next use.
+ * \since 1.1.0
+ */
+void Workspace::invalidate()
+{
+    m_index.reset();
+    m_stringTable.reset();
+    m_size = -1;
+    m_hash.clear();
+    m_racy = false;
+}
+
+
+
+/*!
+ * \brief Extracts the translation strings from the script and config files and updates the stringtable.xml file.
+ * \since 1.1.0
+ * \return True on success.
+ */
+bool Workspace::extract()
+{
+    return run(JobOptions::Extract);
+}
+
+
+
+/*!
+ * \brief Converts the stringtable.xml file into XLIFF files.
+ * \since 1.1.0
+ * \return True on success.
+ */
+bool Workspace::exportXliff()
+{
+    return run(JobOptions::ConvertToXliff);
+}
+
+
+
+/*!
+ * \brief Converts the XLIFF files into the stringtable.xml file.
+ * \since 1.1.0
+ * \return True on success.
+ */
+bool Workspace::importXliff()
+{
+    return run(JobOptions::XliffToStringtable);
+}
+
+
+
+/*!
+ * \brief Returns the number of files that have been parsed by the last extraction.
+ * \since 1.1.0
+ */
+int Workspace::filesParsed() const
+{
+    return m_filesParsed;
+}
+
+
+
+/*!
+ * \brief Runs a Job in \a mode on the loaded project.
+ * \since 1.1.0
+ * \return True on success.
+ */
+bool Workspace::run(JobOptions::Mode mode)
+{
+    JobOptions options = m_options;
+    options.mode = mode;
+
+    // the XLIFF import replaces the stringtable.xml file, so it is loaded again afterwards
+    Project *st = mode != JobOptions::XliffToStringtable ? load(true) : nullptr;
+
+    Job job(m_wd.absolutePath(), options);
+    job.setReport(m_report);
+    job.setStringTable(st);
+    job.run();
+
+    m_filesParsed = job.filesParsed();
+
+    if (mode == JobOptions::Extract && st && job.succeeded()) {
+        // the extracted strings have been merged into the loaded project that has been written
+        m_index.reset();
+        remember();
+    } else if (mode != JobOptions::ConvertToXliff) {
+        invalidate();
+    }
+
+    return job.succeeded();
+}
+
+
+
+/*!
+ * \brief Loads the stringtable.xml file if it has not been loaded or if it has been changed.
+ *
+ * Changes are detected by the modification time and the size of the file. If \a verifyContent is
+ * true, or if the file has been modified so shortly before it has been loaded that a later change
+ * might have kept its modification time, the content is compared, too.
+ *
+ * \since 1.1.0
+ */
+Project *Workspace::load(bool verifyContent)
+{
+    const QFileInfo fi(m_wd.absoluteFilePath(QStringLiteral("stringtable.xml")));
+
+    if (m_stringTable) {
+        bool changed = !fi.exists() || fi.lastModified() != m_modified || fi.size() != m_size;
+
+        if (!changed && (verifyContent || m_racy)) {
+            changed = contentHash(fi.absoluteFilePath()) != m_hash;
+            m_racy = !changed && isRacy(m_modified);
+        }
+
+        if (changed) {
+            invalidate();
+        }
+    }
+
+    if (!m_stringTable && fi.exists()) {
+        StringtableParser stp(fi.absoluteFilePath());
+        m_stringTable.reset(stp.parse());
+        remember();
+    }
+
+    return m_stringTable.data();
+}
+
+
+
+/*!
+ * \brief Stores the modification time, size and content hash of the stringtable.xml file the loaded project belongs to.
+ * \since 1.1.0
+ */
+void Workspace::remember()
+{
+    const QFileInfo fi(m_wd.absoluteFilePath(QStringLiteral("stringtable.xml")));
+    m_modified = fi.lastModified();
+    m_size = fi.size();
+    m_hash = contentHash(fi.absoluteFilePath());
+    m_racy = isRacy(m_modified);
+}
+
+
+
+/*!
+ * \brief Returns true if a file with the \a modified time could still be changed without changing its modification time.
+ *
+ * Some file systems store the modification time with a resolution of two seconds only.
+ *
+ * \since 1.1.0
+ */
+bool Workspace::isRacy(const QDateTime &modified)
+{
+    return modified.msecsTo(QDateTime::currentDateTime()) < 2000;
+}
+
+
+
+/*!
+ * \brief Returns the hash of the content of the file at \a filePath or an empty hash if it can not be read.
+ * \since 1.1.0
+ */
+QByteArray Workspace::contentHash(const QString &filePath)
+{
+    QFile f(filePath);
+
+    if (!f.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+
+    if (!hash.addData(&f)) {
+        return QByteArray();
+    }
+
+    return hash.result();
+}
@@ -0,0 +1,92 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include <QObject>
+#include <QDir>
+#include <QDateTime>
+#include <QByteArray>
+#include <QScopedPointer>
+#include "a3trans_global.h"
+#include "job.h"
+
+class Project;
+class Report;
+class KeyIndex;
+class Key;
+
+class A3TRANS_EXPORT Workspace : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Workspace(const QString &workingDir, QObject *parent = nullptr);
+    ~Workspace();
+
+    QString workingDir() const;
+
+    void setOptions(const JobOptions &options);
+
+    JobOptions options() const;
+
+    Report *report() const;
+
+    Project *stringTable();
+
+    const KeyIndex *keyIndex();
+
+    const KeyIndex *loadedKeyIndex();
+
+    Key *key(const QString &id);
+
+    QString translation(const QString &id, const QString &lang);
+
+    void invalidate();
+
+    bool extract();
+
+    bool exportXliff();
+
+    bool importXliff();
+
+    int filesParsed() const;
+
+private:
+    Q_DISABLE_COPY(Workspace)
+
+    QDir m_wd;
+    JobOptions m_options;
+    Report *m_report;
+    QScopedPointer<Project> m_stringTable;
+    QScopedPointer<KeyIndex> m_index;
+    QDateTime m_modified;
+    qint64 m_size;
+    QByteArray m_hash;
+    bool m_racy;
+    int m_filesParsed;
+
+    bool run(JobOptions::Mode mode);
+    Project *load(bool verifyContent);
+    void remember();
+
+    static QByteArray contentHash(const QString &filePath);
+    static bool isRacy(const QDateTime &modified);
+};
+
+#endif // WORKSPACE_H
@@ -22,7 +22,11 @@
 #include "container.h"
 #include "key.h"
 #include "translation.h"
+#include "languages.h"
 #include <QDomDocument>
+#include <QXmlStreamReader>
+#include <QFileInfo>
+#include <QUrl>
 
 
 
@@ -33,6 +37,15 @@
  * Results are saved into the Project object pointed to when constructing a new XliffParser object.
  * Currently XLIFF 1.0, 1.1, 1.2 and 2.0 are supported.
  *
+ * If a stringtable project is given, its keys and languages that are not part of the XLIFF files
+ * are merged into the result, so that nothing that only exists in the stringtable.xml file gets
+ * lost. This is required for XLIFF files that have been created as delta export (see
+ * Project::toXliff()), as they only contain new or changed strings. The result keeps the name
+ * of the stringtable project.
+ *
+ * Units of exports with collapsed duplicates list the keys with the same source string in the
+ * \c a3t:duplicates attribute. Source and translation of such a unit are copied to all of them.
+ *
  * \since 1.0.0
  * \version 1.0.0
  * \date 2016-09-05
@@ -51,11 +64,12 @@
  * \since 1.0.0
  * \param workingDir    The current working directory.
  * \param prj           Pointer to a Project object to store the extracted strings in.
+ * \param stringTableProject    Pointer to a Project object containing the current stringtable.xml data, that is merged into the result.
  * \param parent        Pointer to a parent object.
  */
-XliffParser::XliffParser(const QDir &workingDir, Project *prj, QObject *parent) : QObject(parent), m_wd(workingDir), m_prj(prj)
+XliffParser::XliffParser(const QDir &workingDir, Project *prj, Project *stringTableProject, QObject *parent) : QObject(parent), m_wd(workingDir), m_prj(prj), m_st(stringTableProject)
 {
-    m_supportedLangs = QStringList({QStringLiteral("en"), QStringLiteral("cz"), QStringLiteral("fr"), QStringLiteral("es"), QStringLiteral("it"), QStringLiteral("pl"), QStringLiteral("pt"), QStringLiteral("ru"), QStringLiteral("de"), QStringLiteral("ko"), QStringLiteral("ja")});
+    m_supportedLangs = Languages::supported();
 }
 
 
@@ -79,16 +93,140 @@ void XliffParser::parse()
         return;
     }
 
-    l10nDir.cd(QStringLiteral("l10n"));
+    const QStringList files = xliffFiles(m_wd);
+
+    bool delta = false;
+
+    for (int i = 0; i < files.size(); ++i) {
+        if (!delta) {
+            delta = isDelta(files.at(i));
+        }
+        qInfo("%s", qUtf8Printable(tr("Parsing file: %1").arg(QFileInfo(files.at(i)).fileName())));
+        extract(files.at(i));
+    }
+
+    if (delta && !m_st) {
+        qWarning("%s", qUtf8Printable(tr("Found delta XLIFF file but no stringtable.xml to merge it into.")));
+    }
+
+    // untouched keys are merged after the extraction, so that changed source strings are known
+    if (m_st) {
+        if (delta) {
+            qInfo("%s", qUtf8Printable(tr("Found delta XLIFF file, merging into existing stringtable.xml.")));
+        }
+        mergeStringTable();
+        m_prj->setObjectName(m_st->objectName());
+    }
+}
+
+
+
+/*!
+ * \brief Returns the full paths of the XLIFF files of all supported languages in the l10n subdirectory of \a workingDir.
+ * \since 1.1.0
+ */
+QStringList XliffParser::xliffFiles(const QDir &workingDir)
+{
+    QStringList files;
+
+    QDir l10nDir(workingDir);
+
+    if (!l10nDir.cd(QStringLiteral("l10n"))) {
+        return files;
+    }
 
-    for (int i = 0; i < m_supportedLangs.size(); ++i) {
+    const QStringList langs = Languages::supported();
+
+    for (int i = 0; i < langs.size(); ++i) {
         QString fn = QStringLiteral("strings_");
-        fn.append(m_supportedLangs.at(i));
+        fn.append(langs.at(i));
         fn.append(QLatin1String(".xlf"));
 
         if (l10nDir.exists(fn)) {
-            qInfo("%s", qUtf8Printable(tr("Parsing file: %1").arg(fn)));
-            extract(l10nDir.absoluteFilePath(fn));
+            files.append(l10nDir.absoluteFilePath(fn));
+        }
+    }
+
+    return files;
+}
+
+
+
+/*!
+ * \brief Returns true if the XLIFF file at \a filePath has been created as delta export.
+ *
+ * Only reads the file until the first file element has been found.
+ *
+ * \since 1.1.0
+ * \param filePath  Full path to the XLIFF file.
+ */
+bool XliffParser::isDelta(const QString &filePath)
+{
+    QFile f(filePath);
+
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    QXmlStreamReader xml(&f);
+
+    while (!xml.atEnd()) {
+        if (xml.readNext() == QXmlStreamReader::StartElement && xml.name() == QLatin1String("file")) {
+            return xml.attributes().value(QStringLiteral("a3t:delta")) == QLatin1String("yes");
+        }
+    }
+
+    return false;
+}
+
+
+
+/*!
+ * \brief Copies all translations of the stringtable project that are not already part of the result project.
+ *
+ * Keeps the keys and languages that are not part of the XLIFF files and the untouched keys of
+ * delta XLIFF files. The translations of keys whose original string has been changed by the
+ * XLIFF files are outdated and are not copied.
+ *
+ * The raw markup of the stringtable project and of its packages, containers and keys is copied,
+ * too, so that comments, unknown attributes and unknown elements survive the round-trip through
+ * the XLIFF files. Packages, containers and keys without strings are kept for the same reason.
+ *
+ * \since 1.1.0
+ */
+void XliffParser::mergeStringTable()
+{
+    m_prj->passThrough().append(m_st->passThrough());
+
+    const QList<Package*> ps = m_st->findChildren<Package*>(QString(), Qt::FindDirectChildrenOnly);
+    for (int i = 0; i < ps.size(); ++i) {
+        Package *rp = m_prj->findChild<Package*>(ps.at(i)->objectName(), Qt::FindDirectChildrenOnly);
+        if (!rp) {
+            rp = new Package(ps.at(i)->objectName(), m_prj);
+        }
+        rp->passThrough().append(ps.at(i)->passThrough());
+        const QList<Container*> cs = ps.at(i)->findChildren<Container*>(QString(), Qt::FindDirectChildrenOnly);
+        for (int j = 0; j < cs.size(); ++j) {
+            Container *rc = rp->findChild<Container*>(cs.at(j)->objectName(), Qt::FindDirectChildrenOnly);
+            if (!rc) {
+                rc = new Container(cs.at(j)->objectName(), rp);
+            }
+            rc->passThrough().append(cs.at(j)->passThrough());
+            const QList<Key*> ks = cs.at(j)->findChildren<Key*>(QString(), Qt::FindDirectChildrenOnly);
+            for (int k = 0; k < ks.size(); ++k) {
+                rc->key(ks.at(k)->objectName(), true)->passThrough().append(ks.at(k)->passThrough());
+                const Translation *o = m_prj->getTranslation(ps.at(i)->objectName(), cs.at(j)->objectName(), ks.at(k)->objectName(), QStringLiteral("Original"));
+                const Translation *so = ks.at(k)->getTranslation(QStringLiteral("Original"));
+                if (o && (!so || so->string() != o->string())) {
+                    continue;
+                }
+                const QList<Translation*> ts = ks.at(k)->getAllTranslations();
+                for (int l = 0; l < ts.size(); ++l) {
+                    if (!m_prj->getTranslation(ps.at(i)->objectName(), cs.at(j)->objectName(), ks.at(k)->objectName(), ts.at(l)->objectName())) {
+                        m_prj->setTranslation(ps.at(i)->objectName(), cs.at(j)->objectName(), ks.at(k)->objectName(), ts.at(l)->objectName(), ts.at(l)->string());
+                    }
+                }
+            }
         }
     }
 }
@@ -175,6 +313,8 @@ void XliffParser::extractV1(const QDomElement &e)
         return;
     }
 
+    const QString targetLangName = m_prj->langCodeToString(trgLang);
+
     QString projectName = file.attribute(QStringLiteral("original"));
     if (projectName.isEmpty()) {
         qWarning("%s", qUtf8Printable(tr("No project name / original set. Using default: %1.").arg(QStringLiteral("My Project"))));
@@ -221,8 +361,16 @@ void XliffParser::extractV1(const QDomElement &e)
                         QString source = key.firstChildElement(QStringLiteral("source")).text();
                         QString target = key.firstChildElement(QStringLiteral("target")).text();
 
-                        m_prj->setTranslation(packageName, containerName, keyId, QStringLiteral("Original"), source);
-                        m_prj->setTranslation(packageName, containerName, keyId, m_prj->langCodeToString(trgLang), target);
+                        m_prj->insert({packageName, containerName, keyId, QStringLiteral("Original"), source});
+                        // untranslated units of delta exports contain empty targets
+                        if (!target.isEmpty()) {
+                            m_prj->insert({packageName, containerName, keyId, targetLangName, target});
+                        }
+
+                        const QString duplicates = key.attribute(QStringLiteral("a3t:duplicates"));
+                        if (!duplicates.isEmpty()) {
+                            fanOut(duplicates, source, targetLangName, target);
+                        }
                     }
                 }
             }
@@ -252,6 +400,8 @@ void XliffParser::extractV2(const QDomElement &e, const QString &trgLang, const
         return;
     }
 
+    const QString targetLangName = m_prj->langCodeToString(trgLang);
+
     QString _srcLang = srcLang;
     if (_srcLang.isEmpty()) {
         qWarning("%s", qUtf8Printable(tr("No source language set. Using default: English.")));
@@ -303,11 +453,52 @@ void XliffParser::extractV2(const QDomElement &e, const QString &trgLang, const
                         QString source = key.firstChildElement(QStringLiteral("source")).text();
                         QString target = key.firstChildElement(QStringLiteral("target")).text();
 
-                        m_prj->setTranslation(packageName, containerName, keyId, QStringLiteral("Original"), source);
-                        m_prj->setTranslation(packageName, containerName, keyId, m_prj->langCodeToString(trgLang), target);
+                        m_prj->insert({packageName, containerName, keyId, QStringLiteral("Original"), source});
+                        // untranslated units of delta exports contain empty targets
+                        if (!target.isEmpty()) {
+                            m_prj->insert({packageName, containerName, keyId, targetLangName, target});
+                        }
+
+                        const QString duplicates = key.attribute(QStringLiteral("a3t:duplicates"));
+                        if (!duplicates.isEmpty()) {
+                            fanOut(duplicates, source, targetLangName, target);
+                        }
                     }
                 }
             }
         }
     }
 }
+
+
+
+/*!
+ * \brief Copies the \a source and the \a target string in \a langName to the keys listed in \a duplicates.
+ *
+ * An empty \a target is not copied, so that existing translations of the keys are kept.
+ *
+ * \since 1.1.0
+ * \param duplicates    Space separated list of keys in the form \c Package/Container/ID with percent encoded names, see Project::toXliff().
+ */
+void XliffParser::fanOut(const QString &duplicates, const QString &source, const QString &langName, const QString &target)
+{
+    const QStringList paths = duplicates.split(QLatin1Char(' '), QString::SkipEmptyParts);
+
+    for (int i = 0; i < paths.size(); ++i) {
+        const QStringList parts = paths.at(i).split(QLatin1Char('/'));
+
+        if (parts.size() != 3) {
+            qWarning("%s", qUtf8Printable(tr("Invalid duplicate key path: %1").arg(paths.at(i))));
+            continue;
+        }
+
+        const QString packageName = QUrl::fromPercentEncoding(parts.at(0).toUtf8());
+        const QString containerName = QUrl::fromPercentEncoding(parts.at(1).toUtf8());
+        const QString keyId = QUrl::fromPercentEncoding(parts.at(2).toUtf8());
+
+        m_prj->insert({packageName, containerName, keyId, QStringLiteral("Original"), source});
+        if (!target.isEmpty()) {
+            m_prj->insert({packageName, containerName, keyId, langName, target});
+        }
+    }
+}
@@ -21,15 +21,16 @@
 
 #include <QObject>
 #include <QDir>
+#include "a3trans_global.h"
 
 class Project;
 class QDomElement;
 
-class XliffParser : public QObject
+class A3TRANS_EXPORT XliffParser : public QObject
 {
     Q_OBJECT
 public:
-    explicit XliffParser(const QDir &workingDir, Project *prj, QObject *parent = nullptr);
+    explicit XliffParser(const QDir &workingDir, Project *prj, Project *stringTableProject = nullptr, QObject *parent = nullptr);
 
     void parse();
 
@@ -38,11 +39,16 @@ private:
 
     QDir m_wd;
     Project *m_prj;
+    Project *m_st;
     QStringList m_supportedLangs;
 
+    static QStringList xliffFiles(const QDir &workingDir);
+    static bool isDelta(const QString &filePath);
+    void mergeStringTable();
     void extract(const QString &filePath);
     void extractV1(const QDomElement &e);
     void extractV2(const QDomElement &e, const QString &trgLang, const QString &srcLang);
+    void fanOut(const QString &duplicates, const QString &source, const QString &langName, const QString &target);
 };
 
 #endif // XLIFFPARDER_H
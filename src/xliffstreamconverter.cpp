@@ -0,0 +1,376 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "xliffstreamconverter.h"
+#include "package.h"
+#include "container.h"
+#include "key.h"
+#include "translation.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QScopedPointer>
+#include <QDomDocument>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+
+
+/*!
+ * \class XliffStreamConverter
+ * \brief Converts a stringtable.xml file into XLIFF files without loading it into memory.
+ *
+ * The stringtable is read with a QXmlStreamReader and every key is written to the XLIFF files of all
+ * languages at once with QXmlStreamWriter objects, as soon as its end tag has been read. Only the
+ * translations of a single key are held in memory at any time, so that the memory used does not
+ * depend on the size of the stringtable. The XLIFF of every key is created by Project::toXliff()
+ * for a project that only contains this key, the converter only merges the elements around the
+ * units, so the output is the same as the one of the Project based conversion.
+ *
+ * The converter writes the keys in the order of the stringtable, sorted output requires the Project
+ * based conversion. For delta exports, the baseline project given in the XliffOptions is used for lookups.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new XliffStreamConverter object.
+ * \since 1.1.0
+ * \param workingDir    The working directory, the XLIFF files will be written to its l10n subdirectory.
+ * \param options       Source language, XLIFF version and baseline project for delta exports.
+ * \param parent        Pointer to the parent object.
+ */
+XliffStreamConverter::XliffStreamConverter(const QDir &workingDir, const XliffOptions &options, QObject *parent) :
+    QObject(parent), m_wd(workingDir), m_options(options), m_started(false), m_packageOpen(false), m_containerOpen(false)
+{
+
+}
+
+
+
+/*!
+ * \brief Discards all not finished output files.
+ */
+XliffStreamConverter::~XliffStreamConverter()
+{
+    finish(false);
+}
+
+
+
+/*!
+ * \brief Converts the \a stringTable file into XLIFF files.
+ *
+ * A source only file \c strings.xlf and a file \c strings_<lang>.xlf for every language in \a trgLangs
+ * will be written. The files are only replaced if the conversion has been successful.
+ *
+ * \since 1.1.0
+ * \param stringTable   Full path to the stringtable.xml file.
+ * \param trgLangs      ISO 639-1 codes of the target languages.
+ * \return              True on success.
+ */
+bool XliffStreamConverter::convert(const QString &stringTable, const QStringList &trgLangs)
+{
+    QFile f(stringTable);
+
+    if (!f.open(QIODevice::ReadOnly)) {
+        qCritical("%s", qUtf8Printable(tr("Failed to open file.")));
+        return false;
+    }
+
+    if (!openOutputs(trgLangs)) {
+        finish(false);
+        return false;
+    }
+
+    QXmlStreamReader xml(&f);
+
+    // the current key is written through a project that only contains this key
+    QScopedPointer<Project> project;
+    Package *package = nullptr;
+    Container *container = nullptr;
+
+    while (!xml.atEnd()) {
+
+        const QXmlStreamReader::TokenType token = xml.readNext();
+
+        if (token == QXmlStreamReader::StartElement) {
+
+            if (xml.name() == QLatin1String("Project")) {
+
+                const QStringRef nameAttribute = xml.attributes().value(QStringLiteral("name"));
+                project.reset(new Project(nameAttribute.isNull() ? QStringLiteral("My Project") : nameAttribute.toString()));
+                package = new Package(QString(), project.data());
+                container = new Container(QString(), package);
+
+            } else if (xml.name() == QLatin1String("Package") && project) {
+
+                package->setObjectName(xml.attributes().value(QStringLiteral("name")).toString());
+
+            } else if (xml.name() == QLatin1String("Container") && project) {
+
+                container->setObjectName(xml.attributes().value(QStringLiteral("name")).toString());
+
+            } else if (xml.name() == QLatin1String("Key") && project) {
+
+                const QString id = xml.attributes().value(QStringLiteral("ID")).toString();
+
+                Key *key = new Key(id, container);
+
+                while (xml.readNextStartElement()) {
+                    const QString lang = xml.name().toString();
+                    new Translation(lang, xml.readElementText(QXmlStreamReader::IncludeChildElements), key);
+                }
+
+                if (!id.isEmpty()) {
+                    writeKey(project.data());
+                }
+
+                delete key;
+            }
+
+        } else if (token == QXmlStreamReader::EndElement) {
+
+            if (xml.name() == QLatin1String("Container")) {
+                closeContainer();
+            } else if (xml.name() == QLatin1String("Package")) {
+                closeContainer();
+                closePackage();
+            }
+
+        }
+    }
+
+    if (xml.hasError() || !project) {
+        qCritical("%s", qUtf8Printable(tr("Failed to parse XML data.")));
+        finish(false);
+        return false;
+    }
+
+    return finish(true);
+}
+
+
+
+/*!
+ * \brief Opens the output files in the l10n directory.
+ * \since 1.1.0
+ */
+bool XliffStreamConverter::openOutputs(const QStringList &trgLangs)
+{
+    QDir l10nDir(m_wd);
+
+    if (!l10nDir.exists(QStringLiteral("l10n"))) {
+        l10nDir.mkdir(QStringLiteral("l10n"));
+    }
+
+    l10nDir.cd(QStringLiteral("l10n"));
+
+    QStringList langs(QString());
+    for (int i = 0; i < trgLangs.size(); ++i) {
+        langs.append(trgLangs.at(i).toLower());
+    }
+
+    for (int i = 0; i < langs.size(); ++i) {
+        const QString &l = langs.at(i);
+
+        QSaveFile *file = new QSaveFile(l10nDir.absoluteFilePath(l.isEmpty() ? QStringLiteral("strings.xlf") : QStringLiteral("strings_%1.xlf").arg(l)));
+
+        if (!file->open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qWarning("%s", qUtf8Printable(tr("Failed to open file for writing: %1").arg(m_wd.relativeFilePath(file->fileName()))));
+            delete file;
+            return false;
+        }
+
+        QXmlStreamWriter *xml = new QXmlStreamWriter(file);
+        xml->setAutoFormatting(true);
+        xml->setAutoFormattingIndent(8);
+
+        m_outputs.append({l, file, xml});
+    }
+
+    return true;
+}
+
+
+
+/*!
+ * \brief Writes the only key of the \a project to all outputs.
+ *
+ * The key is converted by Project::toXliff(), the elements around its unit are only written if
+ * they are not already open. Nothing is written if the key is not exported.
+ *
+ * \since 1.1.0
+ */
+void XliffStreamConverter::writeKey(const Project *project)
+{
+    const int headerDepth = m_options.version2 ? 2 : 3;
+
+    for (int i = 0; i < m_outputs.size(); ++i) {
+        QXmlStreamWriter *xml = m_outputs.at(i).xml;
+
+        const QDomDocument doc = project->toXliff(m_outputs.at(i).lang, m_options);
+
+        // whether a key is exported does not depend on the target language
+        if (!doc.hasChildNodes()) {
+            return;
+        }
+
+        QDomElement e = doc.documentElement();
+
+        if (!m_started) {
+            xml->writeStartDocument();
+        }
+
+        for (int depth = 0; depth < headerDepth; ++depth) {
+            if (!m_started) {
+                writeStartElement(xml, e);
+            }
+            e = e.firstChildElement();
+        }
+
+        if (!m_packageOpen) {
+            writeStartElement(xml, e);
+        }
+
+        e = e.firstChildElement();
+
+        if (!m_containerOpen) {
+            writeStartElement(xml, e);
+        }
+
+        for (QDomNode n = e.firstChild(); !n.isNull(); n = n.nextSibling()) {
+            writeNode(xml, n);
+        }
+    }
+
+    m_started = true;
+    m_packageOpen = true;
+    m_containerOpen = true;
+}
+
+
+
+/*!
+ * \brief Closes the group element of the current container in all outputs, if it has been written.
+ * \since 1.1.0
+ */
+void XliffStreamConverter::closeContainer()
+{
+    if (m_containerOpen) {
+        for (int i = 0; i < m_outputs.size(); ++i) {
+            m_outputs.at(i).xml->writeEndElement();
+        }
+        m_containerOpen = false;
+    }
+}
+
+
+
+/*!
+ * \brief Closes the group element of the current package in all outputs, if it has been written.
+ * \since 1.1.0
+ */
+void XliffStreamConverter::closePackage()
+{
+    if (m_packageOpen) {
+        for (int i = 0; i < m_outputs.size(); ++i) {
+            m_outputs.at(i).xml->writeEndElement();
+        }
+        m_packageOpen = false;
+    }
+}
+
+
+
+/*!
+ * \brief Finishes the outputs and replaces the files if \a commit is true, otherwise discards them.
+ * \since 1.1.0
+ */
+bool XliffStreamConverter::finish(bool commit)
+{
+    bool ok = true;
+
+    for (int i = 0; i < m_outputs.size(); ++i) {
+        const Output &o = m_outputs.at(i);
+
+        if (commit) {
+            if (m_started) {
+                o.xml->writeEndDocument();
+            }
+            if (o.xml->hasError() || !o.file->commit()) {
+                qWarning("%s", qUtf8Printable(tr("Failed to write data to file: %1").arg(m_wd.relativeFilePath(o.file->fileName()))));
+                ok = false;
+            }
+        } else {
+            o.file->cancelWriting();
+        }
+
+        delete o.xml;
+        delete o.file;
+    }
+
+    m_outputs.clear();
+
+    return ok;
+}
+
+
+
+/*!
+ * \brief Writes the start tag of the element \a e with its attributes.
+ * \since 1.1.0
+ */
+void XliffStreamConverter::writeStartElement(QXmlStreamWriter *xml, const QDomElement &e)
+{
+    xml->writeStartElement(e.tagName());
+
+    if (!e.namespaceURI().isEmpty()) {
+        xml->writeDefaultNamespace(e.namespaceURI());
+    }
+
+    const QDomNamedNodeMap attributes = e.attributes();
+    for (int i = 0; i < attributes.count(); ++i) {
+        const QDomAttr a = attributes.item(i).toAttr();
+        xml->writeAttribute(a.name(), a.value());
+    }
+}
+
+
+
+/*!
+ * \brief Writes the node \a n and all its children.
+ * \since 1.1.0
+ */
+void XliffStreamConverter::writeNode(QXmlStreamWriter *xml, const QDomNode &n)
+{
+    if (n.isElement()) {
+        writeStartElement(xml, n.toElement());
+        for (QDomNode c = n.firstChild(); !c.isNull(); c = c.nextSibling()) {
+            writeNode(xml, c);
+        }
+        xml->writeEndElement();
+    } else if (n.isText()) {
+        xml->writeCharacters(n.nodeValue());
+    }
+}
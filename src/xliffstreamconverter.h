@@ -0,0 +1,68 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef XLIFFSTREAMCONVERTER_H
+#define XLIFFSTREAMCONVERTER_H
+
+#include <QObject>
+#include <QDir>
+#include <QVector>
+#include "project.h"
+#include "a3trans_global.h"
+
+class QSaveFile;
+class QXmlStreamWriter;
+class QDomElement;
+class QDomNode;
+
+class A3TRANS_EXPORT XliffStreamConverter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit XliffStreamConverter(const QDir &workingDir, const XliffOptions &options = XliffOptions(), QObject *parent = nullptr);
+    ~XliffStreamConverter();
+
+    bool convert(const QString &stringTable, const QStringList &trgLangs);
+
+private:
+    Q_DISABLE_COPY(XliffStreamConverter)
+
+    struct Output {
+        QString lang;
+        QSaveFile *file;
+        QXmlStreamWriter *xml;
+    };
+
+    QDir m_wd;
+    XliffOptions m_options;
+    QVector<Output> m_outputs;
+    bool m_started;
+    bool m_packageOpen;
+    bool m_containerOpen;
+
+    bool openOutputs(const QStringList &trgLangs);
+    void writeKey(const Project *project);
+    void closeContainer();
+    void closePackage();
+    bool finish(bool commit);
+
+    static void writeStartElement(QXmlStreamWriter *xml, const QDomElement &e);
+    static void writeNode(QXmlStreamWriter *xml, const QDomNode &n);
+};
+
+#endif // XLIFFSTREAMCONVERTER_H
@@ -0,0 +1,609 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "xliffstreammerger.h"
+#include "stringtablewriter.h"
+#include "filewriter.h"
+#include "languages.h"
+#include <QFile>
+#include <QSet>
+#include <QHash>
+#include <QPair>
+#include <QXmlStreamReader>
+
+
+
+/*!
+ * \class XliffStreamMerger
+ * \brief Merges the language specific XLIFF files into a stringtable.xml file in a single pass.
+ *
+ * The XLIFF files created by a3trans contain the same units in the same order for every language.
+ * The merger reads all files in lockstep, assembles the translations of a key from the current unit
+ * of every file and writes the key directly to the new stringtable.xml file. The strings of a key are
+ * only held in memory until the key has been written.
+ *
+ * If the files do not contain the same units in the same order, if a container is split across the
+ * file or if one of the files is a delta export or contains collapsed duplicates, the merge is
+ * cancelled and Diverged is returned, so that the caller can fall back to the XliffParser. The
+ * same applies if the existing stringtable.xml file contains keys or translations that are not
+ * part of the merged files, or raw markup like comments and unknown attributes, as only the
+ * XliffParser merges them into the result. For this check, the path of every merged key is kept in
+ * memory together with a hash of its original string and the languages it has been translated to,
+ * so memory use grows with the number of keys, but not with the number or length of the strings.
+ * The existing stringtable.xml file is only replaced if the merge has been successful.
+ *
+ * Like the XliffParser, the merger keeps the project name of the existing stringtable.xml file.
+ *
+ * \since 1.1.0
+ * \version 1.1.0
+ * \date 2016-10-18
+ * \author Buschmann
+ * \copyright GNU GENERAL PUBLIC LICENSE Version 3
+ */
+
+
+
+/*!
+ * \brief Constructs a new XliffStreamMerger object.
+ * \since 1.1.0
+ * \param workingDir    The working directory, expects the XLIFF files in its l10n subdirectory.
+ * \param parent        Pointer to the parent object.
+ */
+XliffStreamMerger::XliffStreamMerger(const QDir &workingDir, QObject *parent) : QObject(parent), m_wd(workingDir)
+{
+
+}
+
+
+
+/*!
+ * \brief Closes all open input files.
+ */
+XliffStreamMerger::~XliffStreamMerger()
+{
+    closeInputs();
+}
+
+
+
+/*!
+ * \brief Merges the XLIFF files into the stringtable.xml file of the working directory.
+ * \since 1.1.0
+ * \param backup    Set to true if the current stringtable.xml file should be copied to a backup file.
+ * \return          Merged on success, Diverged if the files can not be merged in a single pass, Failed on write errors.
+ */
+XliffStreamMerger::Result XliffStreamMerger::merge(bool backup)
+{
+    if (!openInputs()) {
+        closeInputs();
+        return Diverged;
+    }
+
+    qInfo("%s", qUtf8Printable(tr("Merging %1 XLIFF files in a single pass.").arg(m_inputs.size())));
+
+    const QString stringTable = m_wd.absoluteFilePath(QStringLiteral("stringtable.xml"));
+
+    if (QFile::exists(stringTable)) {
+        const QString name = projectName(stringTable);
+        if (name.isNull()) {
+            closeInputs();
+            return Diverged;
+        }
+        m_projectName = name;
+    }
+
+    StringtableWriter writer(stringTable);
+
+    if (!writer.open(m_projectName)) {
+        closeInputs();
+        return Failed;
+    }
+
+    QVector<Unit> units(m_inputs.size());
+    QVector<QPair<QString, QString> > translations;
+    translations.reserve(m_inputs.size() + 1);
+
+    QSet<QString> finishedContainers;
+    QString currentContainer;
+
+    QHash<QString, MergedKey> merged;
+
+    bool diverged = false;
+
+    while (!diverged) {
+
+        int ended = 0;
+
+        for (int i = 0; i < m_inputs.size(); ++i) {
+            const ReadResult r = nextUnit(m_inputs[i], units[i]);
+            if (r == End) {
+                ended++;
+            } else if (r == Error) {
+                diverged = true;
+            }
+        }
+
+        if (diverged || (ended > 0 && ended < m_inputs.size())) {
+            diverged = true;
+            break;
+        }
+
+        if (ended == m_inputs.size()) {
+            break;
+        }
+
+        const Unit &first = units.at(0);
+
+        for (int i = 1; i < units.size(); ++i) {
+            const Unit &u = units.at(i);
+            if (u.id != first.id || u.container != first.container || u.package != first.package) {
+                diverged = true;
+                break;
+            }
+        }
+
+        if (diverged) {
+            break;
+        }
+
+        // keys of the same container have to be consecutive to be written in one element
+        QString container = first.package;
+        container.append(QChar(0x1f)).append(first.container);
+
+        if (container != currentContainer) {
+            if (finishedContainers.contains(container)) {
+                diverged = true;
+                break;
+            }
+            finishedContainers.insert(currentContainer);
+            currentContainer = container;
+        }
+
+        translations.clear();
+        translations.append(qMakePair(QStringLiteral("Original"), units.last().source));
+        for (int i = 0; i < units.size(); ++i) {
+            translations.append(qMakePair(m_inputs.at(i).langName, units.at(i).target));
+        }
+
+        writer.writeKey(first.package, first.container, first.id, translations);
+
+        MergedKey &mk = merged[keyPath(first.package, first.container, first.id)];
+        mk.source = qHash(units.last().source);
+        for (int i = 0; i < units.size(); ++i) {
+            if (!units.at(i).target.isEmpty()) {
+                mk.languages |= Q_UINT64_C(1) << i;
+            }
+        }
+    }
+
+    QStringList langNames;
+    for (int i = 0; i < m_inputs.size(); ++i) {
+        langNames.append(m_inputs.at(i).langName);
+    }
+
+    closeInputs();
+
+    if (!diverged && QFile::exists(stringTable) && !covers(stringTable, merged, langNames)) {
+        writer.cancel();
+        qInfo("%s", qUtf8Printable(tr("The stringtable.xml file contains keys or translations that are not part of the XLIFF files. Falling back to indexed merging.")));
+        return Diverged;
+    }
+
+    if (diverged) {
+        writer.cancel();
+        qInfo("%s", qUtf8Printable(tr("The XLIFF files do not share the same unit order. Falling back to indexed merging.")));
+        return Diverged;
+    }
+
+    if (backup && !FileWriter(m_wd, nullptr).backupStringTable()) {
+        writer.cancel();
+        return Failed;
+    }
+
+    return writer.commit() ? Merged : Failed;
+}
+
+
+
+/*!
+ * \brief Opens the XLIFF files of all supported languages that exist in the l10n directory.
+ * \since 1.1.0
+ * \return False if there are no files or if one of them can not be merged in a single pass.
+ */
+bool XliffStreamMerger::openInputs()
+{
+    QDir l10nDir(m_wd);
+
+    if (!l10nDir.cd(QStringLiteral("l10n"))) {
+        return false;
+    }
+
+    const QStringList langs = Languages::supported();
+
+    for (int i = 0; i < langs.size(); ++i) {
+        const QString fn = l10nDir.absoluteFilePath(QStringLiteral("strings_%1.xlf").arg(langs.at(i)));
+
+        if (!QFile::exists(fn)) {
+            continue;
+        }
+
+        QFile *f = new QFile(fn);
+
+        if (!f->open(QIODevice::ReadOnly | QIODevice::Text)) {
+            delete f;
+            return false;
+        }
+
+        m_inputs.append({QString(), f, new QXmlStreamReader(f), QStringList()});
+
+        if (!readHeader(m_inputs.last())) {
+            return false;
+        }
+    }
+
+    return !m_inputs.isEmpty();
+}
+
+
+
+/*!
+ * \brief Reads the XLIFF file until the file element and sets the target language of the input.
+ * \since 1.1.0
+ * \return False if the header is invalid, the language is not supported or if the file is a delta export.
+ */
+bool XliffStreamMerger::readHeader(Input &in)
+{
+    QXmlStreamReader *xml = in.xml;
+
+    QString version;
+    QString trgLang;
+
+    while (!xml->atEnd()) {
+
+        if (xml->readNext() != QXmlStreamReader::StartElement) {
+            continue;
+        }
+
+        if (xml->name() == QLatin1String("xliff")) {
+
+            version = xml->attributes().value(QStringLiteral("version")).toString();
+            trgLang = xml->attributes().value(QStringLiteral("trgLang")).toString();
+
+        } else if (xml->name() == QLatin1String("file")) {
+
+            const QXmlStreamAttributes attrs = xml->attributes();
+
+            if (attrs.value(QStringLiteral("a3t:delta")) == QLatin1String("yes")) {
+                return false;
+            }
+
+            QString projectName;
+
+            if (version.startsWith(QLatin1Char('1'))) {
+                trgLang = attrs.value(QStringLiteral("target-language")).toString();
+                projectName = attrs.value(QStringLiteral("original")).toString();
+            } else if (version.startsWith(QLatin1Char('2'))) {
+                projectName = attrs.value(QStringLiteral("id")).toString();
+            } else {
+                return false;
+            }
+
+            if (trgLang.isEmpty() || !Languages::supported().contains(trgLang, Qt::CaseInsensitive)) {
+                return false;
+            }
+
+            in.langName = Languages::codeToString(trgLang.toLower());
+
+            // like the XliffParser, the name of the last file is used if there is no stringtable.xml file
+            m_projectName = projectName.isEmpty() ? QStringLiteral("My Project") : projectName.replace(QChar('_'), QLatin1String(" "));
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+
+/*!
+ * \brief Reads the next unit from the input.
+ *
+ * The first group level is the package, the second level is the container, the trans-unit
+ * respectively segment elements are the keys.
+ *
+ * \since 1.1.0
+ */
+XliffStreamMerger::ReadResult XliffStreamMerger::nextUnit(Input &in, Unit &unit)
+{
+    QXmlStreamReader *xml = in.xml;
+
+    while (!xml->atEnd()) {
+
+        const QXmlStreamReader::TokenType token = xml->readNext();
+
+        if (token == QXmlStreamReader::StartElement) {
+
+            if (xml->name() == QLatin1String("group") || xml->name() == QLatin1String("unit")) {
+
+                QString id = xml->attributes().value(QStringLiteral("id")).toString();
+                in.groups.append(id.replace(QChar('_'), QLatin1String(" ")));
+
+            } else if (xml->name() == QLatin1String("trans-unit") || xml->name() == QLatin1String("segment")) {
+
+                // collapsed duplicates have to be fanned out by the XliffParser
+                if (in.groups.size() != 2 || xml->attributes().hasAttribute(QStringLiteral("a3t:duplicates"))) {
+                    return Error;
+                }
+
+                unit.package = in.groups.at(0);
+                unit.container = in.groups.at(1);
+                unit.id = xml->attributes().value(QStringLiteral("id")).toString();
+                unit.source.clear();
+                unit.target.clear();
+
+                while (xml->readNextStartElement()) {
+                    if (xml->name() == QLatin1String("source")) {
+                        unit.source = xml->readElementText(QXmlStreamReader::IncludeChildElements);
+                    } else if (xml->name() == QLatin1String("target")) {
+                        unit.target = xml->readElementText(QXmlStreamReader::IncludeChildElements);
+                    } else {
+                        xml->skipCurrentElement();
+                    }
+                }
+
+                return UnitRead;
+            }
+
+        } else if (token == QXmlStreamReader::EndElement) {
+
+            if ((xml->name() == QLatin1String("group") || xml->name() == QLatin1String("unit")) && !in.groups.isEmpty()) {
+                in.groups.removeLast();
+            }
+
+        }
+    }
+
+    return xml->hasError() ? Error : End;
+}
+
+
+
+/*!
+ * \brief Returns the project name of the \a stringTable file, or a null string if the file can not be read.
+ * \since 1.1.0
+ */
+QString XliffStreamMerger::projectName(const QString &stringTable)
+{
+    QFile f(stringTable);
+
+    if (!f.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+
+    QXmlStreamReader xml(&f);
+
+    if (!xml.readNextStartElement() || xml.name() != QLatin1String("Project")) {
+        return QString();
+    }
+
+    const QStringRef name = xml.attributes().value(QStringLiteral("name"));
+
+    return name.isNull() ? QStringLiteral("My Project") : name.toString();
+}
+
+
+
+/*!
+ * \brief Returns true if all keys and non empty translations of the \a stringTable file are part of the \a merged keys.
+ *
+ * Translations of keys whose original string has been changed by the merged files are outdated
+ * and are not required. \a langNames are the languages of the merged files, in the order of the
+ * language bits of the merged keys.
+ *
+ * Returns false, too, if the file contains anything the merger can not write: comments, processing
+ * instructions, unknown elements and attributes, containers without keys, packages without
+ * containers, keys without strings and empty language elements.
+ *
+ * \since 1.1.0
+ */
+bool XliffStreamMerger::covers(const QString &stringTable, const QHash<QString, MergedKey> &merged, const QStringList &langNames)
+{
+    QFile f(stringTable);
+
+    if (!f.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QXmlStreamReader xml(&f);
+
+    QString package;
+    QString container;
+    int depth = 0;
+    bool empty = false;
+
+    while (!xml.atEnd()) {
+
+        switch (xml.readNext()) {
+        case QXmlStreamReader::Comment:
+        case QXmlStreamReader::ProcessingInstruction:
+        case QXmlStreamReader::DTD:
+        case QXmlStreamReader::EntityReference:
+            // raw markup is only kept by the StringtableParser
+            return false;
+        case QXmlStreamReader::EndElement:
+            // containers without keys and packages without containers are not written by the merger
+            if (empty) {
+                return false;
+            }
+            depth--;
+            continue;
+        case QXmlStreamReader::StartElement:
+            break;
+        default:
+            continue;
+        }
+
+        const QXmlStreamAttributes attributes = xml.attributes();
+
+        if (depth == 0 && xml.name() == QLatin1String("Project")) {
+
+            if (!hasOnlyAttribute(attributes, QStringLiteral("name"))) {
+                return false;
+            }
+
+        } else if (depth == 1 && xml.name() == QLatin1String("Package")) {
+
+            package = attributes.value(QStringLiteral("name")).toString();
+            empty = true;
+
+            if (!hasOnlyAttribute(attributes, QStringLiteral("name"))) {
+                return false;
+            }
+
+        } else if (depth == 2 && xml.name() == QLatin1String("Container")) {
+
+            container = attributes.value(QStringLiteral("name")).toString();
+            empty = true;
+
+            if (!hasOnlyAttribute(attributes, QStringLiteral("name"))) {
+                return false;
+            }
+
+        } else if (depth == 3 && xml.name() == QLatin1String("Key")) {
+
+            empty = false;
+
+            const QString id = attributes.value(QStringLiteral("ID")).toString();
+
+            if (id.isEmpty() || !hasOnlyAttribute(attributes, QStringLiteral("ID"))) {
+                return false;
+            }
+
+            QVector<QPair<QString, QString> > translations;
+            bool hasStrings = false;
+
+            while (!xml.atEnd() && xml.readNext() != QXmlStreamReader::EndElement) {
+                if (xml.isComment() || xml.isProcessingInstruction()) {
+                    return false;
+                }
+                if (xml.isStartElement()) {
+                    if (!xml.attributes().isEmpty()) {
+                        return false;
+                    }
+                    const QString lang = xml.name().toString();
+                    const QString text = xml.readElementText(QXmlStreamReader::ErrorOnUnexpectedElement);
+                    // empty language elements are not written by the merger
+                    if (text.isEmpty()) {
+                        return false;
+                    }
+                    translations.append(qMakePair(lang, text));
+                    hasStrings = true;
+                }
+            }
+
+            if (!hasStrings) {
+                return false;
+            }
+
+            const QHash<QString, MergedKey>::const_iterator it = merged.constFind(keyPath(package, container, id));
+
+            if (it == merged.constEnd()) {
+                return false;
+            }
+
+            bool sameSource = true;
+            for (int i = 0; i < translations.size(); ++i) {
+                if (translations.at(i).first == QLatin1String("Original")) {
+                    sameSource = qHash(translations.at(i).second) == it.value().source;
+                    break;
+                }
+            }
+
+            if (!sameSource) {
+                continue;
+            }
+
+            for (int i = 0; i < translations.size(); ++i) {
+                const QPair<QString, QString> &t = translations.at(i);
+                if (t.first == QLatin1String("Original")) {
+                    continue;
+                }
+                const int lang = langNames.indexOf(t.first);
+                if (lang < 0 || !(it.value().languages & (Q_UINT64_C(1) << lang))) {
+                    return false;
+                }
+            }
+
+            continue;
+
+        } else {
+
+            // unknown and nested elements are only kept by the StringtableParser
+            return false;
+
+        }
+
+        depth++;
+    }
+
+    return !xml.hasError();
+}
+
+
+
+/*!
+ * \brief Returns true if \a attributes is empty or only contains the attribute \a name.
+ * \since 1.1.0
+ */
+bool XliffStreamMerger::hasOnlyAttribute(const QXmlStreamAttributes &attributes, const QString &name)
+{
+    return attributes.isEmpty() || (attributes.size() == 1 && attributes.hasAttribute(name));
+}
+
+
+
+/*!
+ * \brief Returns the path of a key as it is used to compare merged keys with the stringtable.xml file.
+ *
+ * Names are compared in the form they have in the XLIFF files.
+ *
+ * \since 1.1.0
+ */
+QString XliffStreamMerger::keyPath(const QString &package, const QString &container, const QString &id)
+{
+    QString path = QStringList({package.simplified(), container.simplified(), id.simplified()}).join(QChar(0x1f));
+    path.replace(QChar(' '), QLatin1String("_"));
+    return path.toCaseFolded();
+}
+
+
+
+/*!
+ * \brief Closes all input files.
+ * \since 1.1.0
+ */
+void XliffStreamMerger::closeInputs()
+{
+    for (int i = 0; i < m_inputs.size(); ++i) {
+        delete m_inputs.at(i).xml;
+        delete m_inputs.at(i).file;
+    }
+
+    m_inputs.clear();
+}
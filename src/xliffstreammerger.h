@@ -0,0 +1,91 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef XLIFFSTREAMMERGER_H
+#define XLIFFSTREAMMERGER_H
+
+#include <QObject>
+#include <QDir>
+#include <QVector>
+#include <QHash>
+#include "a3trans_global.h"
+
+class QFile;
+class QXmlStreamReader;
+class QXmlStreamAttributes;
+
+class A3TRANS_EXPORT XliffStreamMerger : public QObject
+{
+    Q_OBJECT
+public:
+    enum Result {
+        Merged,
+        Diverged,
+        Failed
+    };
+
+    explicit XliffStreamMerger(const QDir &workingDir, QObject *parent = nullptr);
+    ~XliffStreamMerger();
+
+    Result merge(bool backup = false);
+
+private:
+    Q_DISABLE_COPY(XliffStreamMerger)
+
+    struct Input {
+        QString langName;
+        QFile *file;
+        QXmlStreamReader *xml;
+        QStringList groups;
+    };
+
+    struct Unit {
+        QString package;
+        QString container;
+        QString id;
+        QString source;
+        QString target;
+    };
+
+    struct MergedKey {
+        uint source = 0;
+        quint64 languages = 0;
+    };
+
+    enum ReadResult {
+        UnitRead,
+        End,
+        Error
+    };
+
+    QDir m_wd;
+    QVector<Input> m_inputs;
+    QString m_projectName;
+
+    bool openInputs();
+    bool readHeader(Input &in);
+    ReadResult nextUnit(Input &in, Unit &unit);
+    void closeInputs();
+
+    static QString projectName(const QString &stringTable);
+    static bool covers(const QString &stringTable, const QHash<QString, MergedKey> &merged, const QStringList &langNames);
+    static bool hasOnlyAttribute(const QXmlStreamAttributes &attributes, const QString &name);
+    static QString keyPath(const QString &package, const QString &container, const QString &id);
+};
+
+#endif // XLIFFSTREAMMERGER_H
@@ -0,0 +1,9 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    tst_server \
+    tst_duplicates \
+    tst_artifactcache \
+    tst_stringtable \
+    tst_filediscovery \
+    tst_stringtablemerger
@@ -0,0 +1,176 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QDirIterator>
+#include "artifactcache.h"
+
+class TestArtifactCache : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+    void cleanup();
+    void fetchStoredEntry();
+    void zeroSizeIsUnlimited();
+    void pruneRemovesLeastRecentlyUsed();
+
+private:
+    QTemporaryDir *m_root = nullptr;
+    QTemporaryDir *m_cache = nullptr;
+
+    QString writeFile(const QString &name, const QByteArray &data);
+    ScriptResult result(const QString &filePath, const QString &key);
+    int entries() const;
+};
+
+
+
+void TestArtifactCache::init()
+{
+    m_root = new QTemporaryDir;
+    m_cache = new QTemporaryDir;
+    QVERIFY(m_root->isValid());
+    QVERIFY(m_cache->isValid());
+}
+
+
+
+void TestArtifactCache::cleanup()
+{
+    delete m_root;
+    delete m_cache;
+}
+
+
+
+QString TestArtifactCache::writeFile(const QString &name, const QByteArray &data)
+{
+    const QString path = QDir(m_root->path()).absoluteFilePath(name);
+    QFile f(path);
+    if (f.open(QIODevice::WriteOnly)) {
+        f.write(data);
+    }
+    return path;
+}
+
+
+
+ScriptResult TestArtifactCache::result(const QString &filePath, const QString &key)
+{
+    ScriptResult r;
+    r.file = filePath;
+    r.entries.append({QStringLiteral("Main"), QStringLiteral("Test"), key, QStringLiteral("Text")});
+    return r;
+}
+
+
+
+int TestArtifactCache::entries() const
+{
+    int n = 0;
+    QDirIterator it(m_cache->path(), QStringList(QStringLiteral("*.a3a")), QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        n++;
+    }
+    return n;
+}
+
+
+
+void TestArtifactCache::fetchStoredEntry()
+{
+    const QString path = writeFile(QStringLiteral("a.sqf"), "// TR Main Test STR_a \"Text\"\n");
+
+    {
+        ArtifactCache cache(m_cache->path(), m_root->path());
+        cache.store(result(path, QStringLiteral("STR_a")), FileMatcher::Script);
+    }
+
+    ArtifactCache cache(m_cache->path(), m_root->path());
+
+    ScriptResult r;
+    QVERIFY(cache.fetch(path, FileMatcher::Script, &r));
+    QCOMPARE(r.entries.size(), 1);
+    QCOMPARE(r.entries.first().key, QStringLiteral("STR_a"));
+    QCOMPARE(cache.hits(), 1);
+
+    // the entry belongs to the content of the file
+    writeFile(QStringLiteral("a.sqf"), "// TR Main Test STR_b \"Text\"\n");
+    QVERIFY(!cache.fetch(path, FileMatcher::Script, &r));
+    QCOMPARE(cache.misses(), 1);
+}
+
+
+
+void TestArtifactCache::zeroSizeIsUnlimited()
+{
+    ArtifactCache cache(m_cache->path(), m_root->path());
+
+    for (int i = 0; i < 3; ++i) {
+        const QString name = QStringLiteral("f%1.sqf").arg(i);
+        cache.store(result(writeFile(name, name.toUtf8()), QStringLiteral("STR_a")), FileMatcher::Script);
+    }
+
+    QCOMPARE(entries(), 3);
+
+    cache.setMaxSize(0);
+    QCOMPARE(cache.prune(), 0);
+    QCOMPARE(entries(), 3);
+
+    cache.setMaxSize(1);
+    QCOMPARE(cache.prune(), 3);
+    QCOMPARE(entries(), 0);
+}
+
+
+
+void TestArtifactCache::pruneRemovesLeastRecentlyUsed()
+{
+    ArtifactCache cache(m_cache->path(), m_root->path());
+
+    const QString older = writeFile(QStringLiteral("older.sqf"), "older");
+    cache.store(result(older, QStringLiteral("STR_a")), FileMatcher::Script);
+
+    // modification times of some file systems only have a resolution of one second
+    QTest::qSleep(1100);
+
+    const QString newer = writeFile(QStringLiteral("newer.sqf"), "newer");
+    cache.store(result(newer, QStringLiteral("STR_a")), FileMatcher::Script);
+
+    QDirIterator it(m_cache->path(), QStringList(QStringLiteral("*.a3a")), QDir::Files, QDirIterator::Subdirectories);
+    qint64 size = 0;
+    while (it.hasNext()) {
+        it.next();
+        size = qMax(size, it.fileInfo().size());
+    }
+
+    cache.setMaxSize(size);
+    QCOMPARE(cache.prune(), 1);
+
+    ScriptResult r;
+    QVERIFY(cache.fetch(newer, FileMatcher::Script, &r));
+    QVERIFY(!cache.fetch(older, FileMatcher::Script, &r));
+}
+
+QTEST_GUILESS_MAIN(TestArtifactCache)
+
+#include "tst_artifactcache.moc"
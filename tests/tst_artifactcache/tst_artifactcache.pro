@@ -0,0 +1,5 @@
+include(../tests.pri)
+
+TARGET = tst_artifactcache
+
+SOURCES += tst_artifactcache.cpp
@@ -0,0 +1,222 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QDomDocument>
+#include "project.h"
+#include "key.h"
+#include "translation.h"
+#include "duplicatefinder.h"
+#include "xliffparser.h"
+
+class TestDuplicates : public QObject
+{
+    Q_OBJECT
+private slots:
+    void exactGroupsAgreeingKeysOnly();
+    void deltaChecksWholeGroup();
+    void roundTrip();
+    void emptyTargetKeepsTranslations();
+
+private:
+    static Project *project(const QString &german);
+    static QDomElement unit(const QDomDocument &xliff);
+    static QString import(const QDir &dir, const QDomDocument &xliff, Project *stringTable, Project *result);
+};
+
+
+
+/*
+ * Returns a project with two keys with the same source string, one of them in a package and
+ * container with a slash and spaces in their names.
+ */
+Project *TestDuplicates::project(const QString &german)
+{
+    Project *p = new Project(QStringLiteral("Test"));
+    p->setTranslation(QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_a"), QStringLiteral("Original"), QStringLiteral("Yes"));
+    p->setTranslation(QStringLiteral("My Package"), QStringLiteral("a/b"), QStringLiteral("STR_b"), QStringLiteral("Original"), QStringLiteral("Yes"));
+    if (!german.isEmpty()) {
+        p->setTranslation(QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_a"), QStringLiteral("German"), german);
+        p->setTranslation(QStringLiteral("My Package"), QStringLiteral("a/b"), QStringLiteral("STR_b"), QStringLiteral("German"), german);
+    }
+    return p;
+}
+
+
+
+QDomElement TestDuplicates::unit(const QDomDocument &xliff)
+{
+    return xliff.documentElement().elementsByTagName(QStringLiteral("trans-unit")).at(0).toElement();
+}
+
+
+
+/*
+ * Writes the German \a xliff file to the l10n directory in \a dir and imports it into \a result.
+ */
+QString TestDuplicates::import(const QDir &dir, const QDomDocument &xliff, Project *stringTable, Project *result)
+{
+    dir.mkpath(QStringLiteral("l10n"));
+
+    QFile f(dir.absoluteFilePath(QStringLiteral("l10n/strings_de.xlf")));
+    if (!f.open(QIODevice::WriteOnly)) {
+        return f.errorString();
+    }
+    f.write(xliff.toByteArray(8));
+    f.close();
+
+    XliffParser xp(dir, result, stringTable);
+    xp.parse();
+
+    return QString();
+}
+
+
+
+void TestDuplicates::exactGroupsAgreeingKeysOnly()
+{
+    Project p(QStringLiteral("Test"));
+    p.setTranslation(QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_a"), QStringLiteral("Original"), QStringLiteral("Yes"));
+    p.setTranslation(QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_a"), QStringLiteral("German"), QStringLiteral("Ja"));
+    p.setTranslation(QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_b"), QStringLiteral("Original"), QStringLiteral("Yes"));
+    p.setTranslation(QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_b"), QStringLiteral("German"), QStringLiteral("Ja"));
+    p.setTranslation(QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_c"), QStringLiteral("Original"), QStringLiteral("Yes"));
+    p.setTranslation(QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_c"), QStringLiteral("German"), QStringLiteral("Jawohl"));
+    p.setTranslation(QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_d"), QStringLiteral("Original"), QStringLiteral("Yes"));
+
+    DuplicateFinder exact(DuplicateFinder::Exact);
+    exact.find(p.keys());
+
+    QCOMPARE(exact.groups().size(), 1);
+    QCOMPARE(exact.groups().first().size(), 2);
+    QCOMPARE(exact.groups().first().at(0)->objectName(), QStringLiteral("STR_a"));
+    QCOMPARE(exact.groups().first().at(1)->objectName(), QStringLiteral("STR_b"));
+
+    DuplicateFinder normalized(DuplicateFinder::Normalized);
+    normalized.find(p.keys());
+
+    QCOMPARE(normalized.duplicateCount(), 3);
+}
+
+
+
+void TestDuplicates::deltaChecksWholeGroup()
+{
+    QScopedPointer<Project> p(project(QString()));
+
+    DuplicateFinder df(DuplicateFinder::Exact);
+    df.find(p->keys());
+
+    XliffOptions options;
+    options.duplicates = &df;
+
+    // only the duplicate has been changed since the baseline
+    Project since(QStringLiteral("Test"));
+    since.setTranslation(QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_a"), QStringLiteral("Original"), QStringLiteral("Yes"));
+    since.setTranslation(QStringLiteral("My Package"), QStringLiteral("a/b"), QStringLiteral("STR_b"), QStringLiteral("Original"), QStringLiteral("No"));
+    options.since = &since;
+
+    QDomElement u = unit(p->toXliff(QStringLiteral("de"), options));
+    QVERIFY(!u.isNull());
+    QCOMPARE(u.firstChildElement(QStringLiteral("target")).attribute(QStringLiteral("state")), QStringLiteral("needs-translation"));
+
+    since.setTranslation(QStringLiteral("My Package"), QStringLiteral("a/b"), QStringLiteral("STR_b"), QStringLiteral("Original"), QStringLiteral("Yes"));
+
+    QVERIFY(!p->toXliff(QStringLiteral("de"), options).hasChildNodes());
+
+    // new only if none of the keys is part of the baseline
+    Project empty(QStringLiteral("Test"));
+    options.since = &empty;
+
+    u = unit(p->toXliff(QStringLiteral("de"), options));
+    QCOMPARE(u.firstChildElement(QStringLiteral("target")).attribute(QStringLiteral("state")), QStringLiteral("new"));
+}
+
+
+
+void TestDuplicates::roundTrip()
+{
+    QScopedPointer<Project> p(project(QString()));
+
+    DuplicateFinder df(DuplicateFinder::Exact);
+    df.find(p->keys());
+
+    XliffOptions options;
+    options.duplicates = &df;
+
+    QDomDocument xliff = p->toXliff(QStringLiteral("de"), options);
+    QDomElement u = unit(xliff);
+
+    QCOMPARE(xliff.documentElement().elementsByTagName(QStringLiteral("trans-unit")).size(), 1);
+    QCOMPARE(u.attribute(QStringLiteral("a3t:duplicates")), QStringLiteral("My%20Package/a%2Fb/STR_b"));
+
+    QDomElement target = xliff.createElement(QStringLiteral("target"));
+    target.appendChild(xliff.createTextNode(QStringLiteral("Ja")));
+    u.appendChild(target);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    Project result(QStringLiteral("Test"));
+    QCOMPARE(import(QDir(dir.path()), xliff, p.data(), &result), QString());
+
+    const Translation *a = result.getTranslation(QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_a"), QStringLiteral("German"));
+    const Translation *b = result.getTranslation(QStringLiteral("My Package"), QStringLiteral("a/b"), QStringLiteral("STR_b"), QStringLiteral("German"));
+
+    QVERIFY(a);
+    QVERIFY(b);
+    QCOMPARE(a->string(), QStringLiteral("Ja"));
+    QCOMPARE(b->string(), QStringLiteral("Ja"));
+}
+
+
+
+void TestDuplicates::emptyTargetKeepsTranslations()
+{
+    QScopedPointer<Project> p(project(QStringLiteral("Ja")));
+
+    DuplicateFinder df(DuplicateFinder::Exact);
+    df.find(p->keys());
+    QCOMPARE(df.duplicateCount(), 1);
+
+    XliffOptions options;
+    options.duplicates = &df;
+
+    // the translator removed the translation
+    QDomDocument xliff = p->toXliff(QStringLiteral("de"), options);
+    QDomElement target = unit(xliff).firstChildElement(QStringLiteral("target"));
+    QVERIFY(!target.isNull());
+    target.removeChild(target.firstChild());
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    Project result(QStringLiteral("Test"));
+    QCOMPARE(import(QDir(dir.path()), xliff, p.data(), &result), QString());
+
+    const Translation *b = result.getTranslation(QStringLiteral("My Package"), QStringLiteral("a/b"), QStringLiteral("STR_b"), QStringLiteral("German"));
+
+    QVERIFY(b);
+    QCOMPARE(b->string(), QStringLiteral("Ja"));
+}
+
+QTEST_GUILESS_MAIN(TestDuplicates)
+
+#include "tst_duplicates.moc"
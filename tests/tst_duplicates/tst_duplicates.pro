@@ -0,0 +1,5 @@
+include(../tests.pri)
+
+TARGET = tst_duplicates
+
+SOURCES += tst_duplicates.cpp
@@ -0,0 +1,108 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include "filediscovery.h"
+
+class TestFileDiscovery : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void fixedOrder_data();
+    void fixedOrder();
+
+private:
+    QTemporaryDir m_dir;
+
+    void writeFile(const QString &name);
+};
+
+
+
+void TestFileDiscovery::writeFile(const QString &name)
+{
+    const QString path = m_dir.filePath(name);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile f(path);
+    QVERIFY(f.open(QIODevice::WriteOnly));
+    f.write("// test\n");
+}
+
+
+
+void TestFileDiscovery::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+
+    writeFile(QStringLiteral("z.sqf"));
+    writeFile(QStringLiteral("a.sqf"));
+    writeFile(QStringLiteral("b/y.sqf"));
+    writeFile(QStringLiteral("b/x.sqf"));
+    writeFile(QStringLiteral("b/c/w.sqf"));
+    writeFile(QStringLiteral("a/v.sqf"));
+    writeFile(QStringLiteral("a/readme.txt"));
+    writeFile(QStringLiteral(".git/u.sqf"));
+}
+
+
+
+void TestFileDiscovery::fixedOrder_data()
+{
+    QTest::addColumn<int>("capacity");
+
+    QTest::newRow("unbounded") << 256;
+    QTest::newRow("single file") << 1;
+}
+
+
+
+/*
+ * The files of a directory come first, followed by its subdirectories, both ordered by path,
+ * independent of the queue capacity.
+ */
+void TestFileDiscovery::fixedOrder()
+{
+    QFETCH(int, capacity);
+
+    FileMatcher matcher;
+    const QStringList patterns = FileMatcher::defaultIncludes();
+    for (int i = 0; i < patterns.size(); ++i) {
+        matcher.addInclude(patterns.at(i));
+    }
+
+    FileDiscovery discovery(m_dir.path(), matcher);
+    discovery.setQueueCapacity(capacity);
+    discovery.start();
+
+    const QDir root(m_dir.path());
+
+    QStringList found;
+    QString fp;
+    while (!(fp = discovery.next()).isNull()) {
+        found.append(root.relativeFilePath(fp));
+    }
+
+    QCOMPARE(found, QStringList({QStringLiteral("a.sqf"), QStringLiteral("z.sqf"), QStringLiteral("a/v.sqf"), QStringLiteral("b/x.sqf"), QStringLiteral("b/y.sqf"), QStringLiteral("b/c/w.sqf")}));
+}
+
+QTEST_GUILESS_MAIN(TestFileDiscovery)
+
+#include "tst_filediscovery.moc"
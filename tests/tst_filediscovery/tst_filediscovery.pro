@@ -0,0 +1,5 @@
+include(../tests.pri)
+
+TARGET = tst_filediscovery
+
+SOURCES += tst_filediscovery.cpp
@@ -0,0 +1,186 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QLocalSocket>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include "workspace.h"
+#include "server.h"
+
+class TestServer : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void lookup();
+    void notificationsAreNotAnswered();
+    void diagnosticsFollowIncludes();
+    void runningServerIsNotReplaced();
+
+private:
+    QTemporaryDir m_dir;
+    Workspace *m_workspace = nullptr;
+    Server *m_server = nullptr;
+    QString m_socketName;
+    QLocalSocket m_client;
+
+    void writeFile(const QString &name, const QByteArray &data);
+    QJsonObject request(const QByteArray &line);
+};
+
+
+
+void TestServer::writeFile(const QString &name, const QByteArray &data)
+{
+    QFile f(m_dir.filePath(name));
+    QVERIFY(f.open(QIODevice::WriteOnly));
+    f.write(data);
+}
+
+
+
+QJsonObject TestServer::request(const QByteArray &line)
+{
+    m_client.write(line);
+    m_client.write("\n");
+    m_client.flush();
+
+    // the server runs in this thread, so the event loop has to run while waiting
+    for (int i = 0; i < 50 && !m_client.canReadLine(); ++i) {
+        QTest::qWait(100);
+    }
+
+    if (!m_client.canReadLine()) {
+        return QJsonObject();
+    }
+
+    return QJsonDocument::fromJson(m_client.readLine()).object();
+}
+
+
+
+void TestServer::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+
+    writeFile(QStringLiteral("stringtable.xml"),
+              "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+              "<Project name=\"Test\">\n"
+              "    <Package name=\"Main\">\n"
+              "        <Container name=\"Test\">\n"
+              "            <Key ID=\"STR_test_hello\">\n"
+              "                <Original>Hello</Original>\n"
+              "                <German>Hallo</German>\n"
+              "            </Key>\n"
+              "        </Container>\n"
+              "    </Package>\n"
+              "</Project>\n");
+
+    writeFile(QStringLiteral("a.sqf"),
+              "#include \"b.hpp\"\n"
+              "hint localize \"STR_test_hello\";\n"
+              "hint localize \"STR_test_nested\";\n"
+              "hint localize \"STR_test_missing\";\n");
+    writeFile(QStringLiteral("b.hpp"), "#include \"c.hpp\"\n");
+    writeFile(QStringLiteral("c.hpp"), "// TR Main Test STR_test_nested \"Nested\"\n");
+
+    m_workspace = new Workspace(m_dir.path(), this);
+    m_server = new Server(m_workspace, this);
+
+    m_socketName = QStringLiteral("a3trans-tst-server-%1").arg(QCoreApplication::applicationPid());
+    QVERIFY(m_server->listen(m_socketName));
+
+    m_client.connectToServer(m_socketName);
+    QVERIFY(m_client.waitForConnected(5000));
+}
+
+
+
+void TestServer::cleanupTestCase()
+{
+    m_client.disconnectFromServer();
+    delete m_server;
+    m_server = nullptr;
+}
+
+
+
+void TestServer::lookup()
+{
+    const QJsonObject r = request("{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"lookup\",\"params\":{\"id\":\"str_test_hello\"}}");
+
+    QCOMPARE(r.value(QStringLiteral("id")).toInt(), 1);
+
+    const QJsonObject result = r.value(QStringLiteral("result")).toObject();
+    QCOMPARE(result.value(QStringLiteral("id")).toString(), QStringLiteral("STR_test_hello"));
+    QCOMPARE(result.value(QStringLiteral("package")).toString(), QStringLiteral("Main"));
+    QCOMPARE(result.value(QStringLiteral("container")).toString(), QStringLiteral("Test"));
+    QCOMPARE(result.value(QStringLiteral("translations")).toObject().value(QStringLiteral("German")).toString(), QStringLiteral("Hallo"));
+}
+
+
+
+void TestServer::notificationsAreNotAnswered()
+{
+    m_client.write("{\"jsonrpc\":\"2.0\",\"method\":\"unknown\"}\n");
+    m_client.write("{\"jsonrpc\":\"2.0\",\"method\":\"lookup\",\"params\":{}}\n");
+
+    // the first answer has to be the one to the request
+    const QJsonObject r = request("{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"complete\",\"params\":{\"prefix\":\"STR_test\"}}");
+
+    QCOMPARE(r.value(QStringLiteral("id")).toInt(), 2);
+    QCOMPARE(r.value(QStringLiteral("result")).toArray().size(), 1);
+    QVERIFY(!m_client.canReadLine());
+}
+
+
+
+void TestServer::diagnosticsFollowIncludes()
+{
+    const QJsonObject r = request("{\"jsonrpc\":\"2.0\",\"id\":3,\"method\":\"diagnostics\",\"params\":{\"file\":\"a.sqf\"}}");
+
+    QCOMPARE(r.value(QStringLiteral("id")).toInt(), 3);
+
+    const QJsonArray ds = r.value(QStringLiteral("result")).toArray();
+    QCOMPARE(ds.size(), 1);
+    QCOMPARE(ds.at(0).toObject().value(QStringLiteral("key")).toString(), QStringLiteral("STR_test_missing"));
+
+    const QJsonObject e = request("{\"jsonrpc\":\"2.0\",\"id\":4,\"method\":\"diagnostics\",\"params\":{\"file\":\"missing.sqf\"}}");
+    QCOMPARE(e.value(QStringLiteral("error")).toObject().value(QStringLiteral("code")).toInt(), -32602);
+}
+
+
+
+void TestServer::runningServerIsNotReplaced()
+{
+    Server other(m_workspace);
+    QVERIFY(!other.listen(m_socketName));
+
+    const QJsonObject r = request("{\"jsonrpc\":\"2.0\",\"id\":5,\"method\":\"lookup\",\"params\":{\"id\":\"STR_test_unknown\"}}");
+    QCOMPARE(r.value(QStringLiteral("id")).toInt(), 5);
+    QVERIFY(r.value(QStringLiteral("result")).isNull());
+}
+
+QTEST_GUILESS_MAIN(TestServer)
+
+#include "tst_server.moc"
@@ -0,0 +1,5 @@
+include(../tests.pri)
+
+TARGET = tst_server
+
+SOURCES += tst_server.cpp
@@ -0,0 +1,275 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QTextCodec>
+#include "stringtableparser.h"
+#include "filewriter.h"
+#include "xliffparser.h"
+#include <QDomDocument>
+#include "project.h"
+#include "container.h"
+#include "key.h"
+#include "translation.h"
+
+class TestStringtable : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+    void cleanup();
+    void declaredEncoding();
+    void byteOrderMark();
+    void nestedElements();
+    void languageProjection();
+    void roundTrip();
+    void xliffImportKeepsMarkup();
+
+private:
+    QTemporaryDir *m_dir = nullptr;
+
+    QString writeFile(const QByteArray &data);
+    QByteArray readFile() const;
+    static QString string(Project *project, const QString &package, const QString &container, const QString &key, const QString &lang);
+};
+
+
+
+void TestStringtable::init()
+{
+    m_dir = new QTemporaryDir;
+    QVERIFY(m_dir->isValid());
+}
+
+
+
+void TestStringtable::cleanup()
+{
+    delete m_dir;
+}
+
+
+
+QString TestStringtable::writeFile(const QByteArray &data)
+{
+    const QString path = QDir(m_dir->path()).absoluteFilePath(QStringLiteral("stringtable.xml"));
+    QFile f(path);
+    if (f.open(QIODevice::WriteOnly)) {
+        f.write(data);
+    }
+    return path;
+}
+
+
+
+QByteArray TestStringtable::readFile() const
+{
+    QFile f(QDir(m_dir->path()).absoluteFilePath(QStringLiteral("stringtable.xml")));
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return QByteArray();
+    }
+    return f.readAll();
+}
+
+
+
+QString TestStringtable::string(Project *project, const QString &package, const QString &container, const QString &key, const QString &lang)
+{
+    const Translation *t = project->getTranslation(package, container, key, lang);
+    return t ? t->string() : QStringLiteral("<missing>");
+}
+
+
+
+void TestStringtable::declaredEncoding()
+{
+    const QString path = writeFile(QByteArray("<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n"
+                                              "<Project name=\"Test\"><Package name=\"Main\"><Container name=\"Test\">"
+                                              "<Key ID=\"STR_a\"><Original>Gr\xfc\xdf" "e</Original></Key>"
+                                              "</Container></Package></Project>\n"));
+
+    StringtableParser parser(path);
+    QScopedPointer<Project> project(parser.parse());
+    QVERIFY(project);
+
+    QCOMPARE(string(project.data(), QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_a"), QStringLiteral("Original")), QString::fromUtf8("Gr\xc3\xbc\xc3\x9f" "e"));
+}
+
+
+
+void TestStringtable::byteOrderMark()
+{
+    const QString xml = QString::fromUtf8("<?xml version=\"1.0\" encoding=\"UTF-16\"?>\n"
+                                          "<Project name=\"Test\"><Package name=\"Main\"><Container name=\"Test\">"
+                                          "<Key ID=\"STR_a\"><Original>\xc3\xa4</Original></Key>"
+                                          "</Container></Package></Project>\n");
+
+    // QTextCodec writes a byte order mark in front of UTF-16 data
+    const QString path = writeFile(QTextCodec::codecForName("UTF-16")->fromUnicode(xml));
+
+    StringtableParser parser(path);
+    QScopedPointer<Project> project(parser.parse());
+    QVERIFY(project);
+
+    QCOMPARE(project->objectName(), QStringLiteral("Test"));
+    QCOMPARE(string(project.data(), QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_a"), QStringLiteral("Original")), QString::fromUtf8("\xc3\xa4"));
+}
+
+
+
+void TestStringtable::nestedElements()
+{
+    const QString path = writeFile("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                                   "<Project name=\"Test\">\n"
+                                   "    <Group>\n"
+                                   "        <Package name=\"Main\">\n"
+                                   "            <Container name=\"Test\">\n"
+                                   "                <Section><Key ID=\"STR_a\"><Original>A</Original></Key></Section>\n"
+                                   "                <Key ID=\"STR_b\"><Original>B</Original></Key>\n"
+                                   "                <Note>no keys</Note>\n"
+                                   "            </Container>\n"
+                                   "        </Package>\n"
+                                   "    </Group>\n"
+                                   "    <Package name=\"Other\"><Container name=\"Test\"><Key ID=\"STR_c\"><Original>C</Original></Key></Container></Package>\n"
+                                   "</Project>\n");
+
+    StringtableParser parser(path);
+    QScopedPointer<Project> project(parser.parse());
+    QVERIFY(project);
+
+    QCOMPARE(project->keys().size(), 3);
+    QCOMPARE(string(project.data(), QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_a"), QStringLiteral("Original")), QStringLiteral("A"));
+    QCOMPARE(string(project.data(), QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_b"), QStringLiteral("Original")), QStringLiteral("B"));
+    QCOMPARE(string(project.data(), QStringLiteral("Other"), QStringLiteral("Test"), QStringLiteral("STR_c"), QStringLiteral("Original")), QStringLiteral("C"));
+
+    // unknown elements without keys are kept as they are
+    const Container *c = qobject_cast<const Container*>(project->key(QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_b"))->parent());
+    QVERIFY(c);
+    QCOMPARE(c->passThrough().end, QStringList(QStringLiteral("<Note>no keys</Note>")));
+}
+
+
+
+void TestStringtable::languageProjection()
+{
+    const QString path = writeFile("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                                   "<Project name=\"Test\"><Package name=\"Main\"><Container name=\"Test\">"
+                                   "<Key ID=\"STR_a\"><Original>Yes</Original><German>Ja</German><French>Oui</French></Key>"
+                                   "</Container></Package></Project>\n");
+
+    StringtableParser parser(path);
+    parser.setLanguages(QStringList() << QStringLiteral("Original") << QStringLiteral("German"));
+    QScopedPointer<Project> project(parser.parse());
+    QVERIFY(project);
+
+    QCOMPARE(string(project.data(), QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_a"), QStringLiteral("German")), QStringLiteral("Ja"));
+    QVERIFY(!project->getTranslation(QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_a"), QStringLiteral("French")));
+}
+
+
+
+/*
+ * The input is formatted like the StringtableWriter formats its output, so it has to be written
+ * back byte by byte.
+ */
+void TestStringtable::roundTrip()
+{
+    const QByteArray input("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                           "<!-- header -->\n"
+                           "<Project name=\"Test\" version=\"2\">\n"
+                           "        <Package name=\"Main\" extra=\"yes\">\n"
+                           "                <!-- container comment -->\n"
+                           "                <Container name=\"Test\">\n"
+                           "                        <!-- key comment -->\n"
+                           "                        <Key ID=\"STR_a\" hint='x'>\n"
+                           "                                <Original>Yes &amp; no</Original>\n"
+                           "                                <German></German>\n"
+                           "                                <!-- after the languages -->\n"
+                           "                        </Key>\n"
+                           "                        <Key ID=\"STR_b\">\n"
+                           "                        </Key>\n"
+                           "                        <Unknown a=\"1\"/>\n"
+                           "                </Container>\n"
+                           "                <Container name=\"Empty\">\n"
+                           "                </Container>\n"
+                           "        </Package>\n"
+                           "        <Package name=\"Nothing\">\n"
+                           "        </Package>\n"
+                           "        <?a3trans keep?>\n"
+                           "</Project>\n");
+
+    const QString path = writeFile(input);
+
+    StringtableParser parser(path);
+    QScopedPointer<Project> project(parser.parse());
+    QVERIFY(project);
+
+    QCOMPARE(project->keys().size(), 2);
+
+    FileWriter writer(QDir(m_dir->path()), project.data());
+    writer.writeStringTable();
+
+    QCOMPARE(readFile(), input);
+}
+
+
+
+void TestStringtable::xliffImportKeepsMarkup()
+{
+    const QString path = writeFile("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                                   "<Project name=\"Test\">\n"
+                                   "    <!-- package comment -->\n"
+                                   "    <Package name=\"Main\">\n"
+                                   "        <Container name=\"Test\">\n"
+                                   "            <Key ID=\"STR_a\" hint=\"x\"><Original>Yes</Original><German>Ja</German></Key>\n"
+                                   "        </Container>\n"
+                                   "        <Container name=\"Empty\"/>\n"
+                                   "    </Package>\n"
+                                   "</Project>\n");
+
+    StringtableParser parser(path);
+    QScopedPointer<Project> stringTable(parser.parse());
+    QVERIFY(stringTable);
+
+    const QDir dir(m_dir->path());
+    dir.mkpath(QStringLiteral("l10n"));
+
+    QFile f(dir.absoluteFilePath(QStringLiteral("l10n/strings_de.xlf")));
+    QVERIFY(f.open(QIODevice::WriteOnly));
+    f.write(stringTable->toXliff(QStringLiteral("de")).toByteArray(8));
+    f.close();
+
+    Project result(QStringLiteral("Result"));
+    XliffParser xp(dir, &result, stringTable.data());
+    xp.parse();
+
+    FileWriter writer(dir, &result);
+    writer.writeStringTable();
+
+    const QByteArray written = readFile();
+    QVERIFY(written.contains("<!-- package comment -->"));
+    QVERIFY(written.contains("<Key ID=\"STR_a\" hint=\"x\">"));
+    QVERIFY(written.contains("<German>Ja</German>"));
+    QVERIFY(written.contains("<Container name=\"Empty\">"));
+}
+
+QTEST_GUILESS_MAIN(TestStringtable)
+
+#include "tst_stringtable.moc"
@@ -0,0 +1,5 @@
+include(../tests.pri)
+
+TARGET = tst_stringtable
+
+SOURCES += tst_stringtable.cpp
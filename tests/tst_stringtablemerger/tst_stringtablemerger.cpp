@@ -0,0 +1,108 @@
+/*
+    a3trans - A translation string extractor and convertor for ArmA 3 script files.
+    Copyright (C) 2016 Buschtrommel/Matthias Fehring (https://www.buschmann23.de)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QtTest>
+#include "stringtablemerger.h"
+#include "project.h"
+#include "translation.h"
+
+class TestStringtableMerger : public QObject
+{
+    Q_OBJECT
+private slots:
+    void removedFromStringtable();
+    void removedAndChanged();
+    void addedWithoutAncestor();
+
+private:
+    static Project *project(const QString &original);
+    static Translation *original(Project *project);
+};
+
+
+
+/*
+ * Returns a project with the key STR_a and the \a original string, or without keys if \a original is empty.
+ */
+Project *TestStringtableMerger::project(const QString &original)
+{
+    Project *p = new Project(QStringLiteral("Test"));
+    if (!original.isEmpty()) {
+        p->setTranslation(QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_a"), QStringLiteral("Original"), original);
+    }
+    return p;
+}
+
+
+
+Translation *TestStringtableMerger::original(Project *project)
+{
+    return project->getTranslation(QStringLiteral("Main"), QStringLiteral("Test"), QStringLiteral("STR_a"), QStringLiteral("Original"));
+}
+
+
+
+void TestStringtableMerger::removedFromStringtable()
+{
+    QScopedPointer<Project> st(project(QString()));
+    QScopedPointer<Project> ex(project(QStringLiteral("Yes")));
+    QScopedPointer<Project> anc(project(QStringLiteral("Yes")));
+
+    StringtableMerger merger(st.data(), ex.data(), anc.data());
+    merger.merge();
+
+    QCOMPARE(merger.count(StringtableMerger::Add), 0);
+    QCOMPARE(merger.count(StringtableMerger::Conflict), 0);
+    QVERIFY(!original(st.data()));
+}
+
+
+
+void TestStringtableMerger::removedAndChanged()
+{
+    QScopedPointer<Project> st(project(QString()));
+    QScopedPointer<Project> ex(project(QStringLiteral("Yes!")));
+    QScopedPointer<Project> anc(project(QStringLiteral("Yes")));
+
+    StringtableMerger merger(st.data(), ex.data(), anc.data());
+    merger.merge();
+
+    QCOMPARE(merger.count(StringtableMerger::Conflict), 1);
+    QVERIFY(original(st.data()));
+    QCOMPARE(original(st.data())->string(), QStringLiteral("Yes!"));
+}
+
+
+
+void TestStringtableMerger::addedWithoutAncestor()
+{
+    QScopedPointer<Project> st(project(QString()));
+    QScopedPointer<Project> ex(project(QStringLiteral("Yes")));
+    QScopedPointer<Project> anc(new Project(QStringLiteral("Test")));
+
+    StringtableMerger merger(st.data(), ex.data(), anc.data());
+    merger.merge();
+
+    QCOMPARE(merger.count(StringtableMerger::Add), 1);
+    QVERIFY(original(st.data()));
+}
+
+QTEST_GUILESS_MAIN(TestStringtableMerger)
+
+#include "tst_stringtablemerger.moc"
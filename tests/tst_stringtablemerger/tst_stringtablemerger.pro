@@ -0,0 +1,5 @@
+include(../tests.pri)
+
+TARGET = tst_stringtablemerger
+
+SOURCES += tst_stringtablemerger.cpp